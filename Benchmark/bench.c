@@ -0,0 +1,136 @@
+/****************************************************************
+ * Summary: This program benchmarks the Queue and List          *
+ *          libraries and reports ns/op with percentiles, and   *
+ *          optionally hardware counters, as a table or JSON.   *
+ *                                                              *
+ * Build:   gcc -O2 -pthread -o bench bench.c harness.c         *
+ *              bench_queue.c bench_list.c bench_ulist.c        *
+ *              bench_clist.c bench_mtlist.c                    *
+ *              ../Queue/queue.c ../List/list.c ../List/ulist.c *
+ *              ../List/ostree.c ../List/vmap.c ../List/slab.c  *
+ *              ../List/clist.c ../List/mtlist.c                *
+ *              ../List/listpar.c ../List/listsnap.c            *
+ *                                                              *
+ * Example: bench                                               *
+ *          bench -f list_ -n 1000000 --perf                    *
+ *          bench --json --label a1b2c3 > new.json              *
+ *          bench --compare old.json new.json                   *
+ ****************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "harness.h"
+#include "cases.h"
+
+#define WRONG_ARGUMENTS		(-1)
+#define BENCHMARK_FAILED	(-2)
+#define CANNOT_COMPARE		(-3)
+
+#define DEFAULT_SIZE		(100000)
+#define DEFAULT_BATCH		(10000)
+#define DEFAULT_SAMPLES		(200)
+#define DEFAULT_THREADS		(4)
+#define DEFAULT_SEED		(2463534242u)
+
+static void usage(const char *name);
+
+int main(int argc, char *argv[])
+{
+	int i = 0;
+	int count = 0;
+	int json = 0;
+	const char *filter = NULL;
+	const char *label = NULL;
+	bench_params_t params;
+	bench_result_t results[BENCH_MAX_CASES];
+
+	params.size = DEFAULT_SIZE;
+	params.batch = DEFAULT_BATCH;
+	params.samples = DEFAULT_SAMPLES;
+	params.threads = DEFAULT_THREADS;
+	params.perf = 0;
+	params.seed = DEFAULT_SEED;
+
+	/* Parse arguments */
+	for (i = 1 ; i < argc ; ++i) {
+		if (0 == strcmp(argv[i], "--compare") && i + 2 < argc) {
+			if (0 != bench_compare(stdout, argv[i + 1], argv[i + 2])) {
+				printf("Could not read %s or %s.\n", argv[i + 1], argv[i + 2]);
+				return CANNOT_COMPARE;
+			}
+			return 0;
+		} else if (0 == strcmp(argv[i], "--json")) {
+			json = 1;
+		} else if (0 == strcmp(argv[i], "--perf")) {
+			params.perf = 1;
+		} else if (0 == strcmp(argv[i], "--label") && i + 1 < argc) {
+			label = argv[++i];
+		} else if (0 == strcmp(argv[i], "-f") && i + 1 < argc) {
+			filter = argv[++i];
+		} else if (0 == strcmp(argv[i], "-n") && i + 1 < argc) {
+			params.size = atoi(argv[++i]);
+		} else if (0 == strcmp(argv[i], "-b") && i + 1 < argc) {
+			params.batch = atoi(argv[++i]);
+		} else if (0 == strcmp(argv[i], "-s") && i + 1 < argc) {
+			params.samples = atoi(argv[++i]);
+		} else if (0 == strcmp(argv[i], "-t") && i + 1 < argc) {
+			params.threads = atoi(argv[++i]);
+		} else if (0 == strcmp(argv[i], "--seed") && i + 1 < argc) {
+			params.seed = (unsigned int)strtoul(argv[++i], NULL, 0);
+		} else {
+			usage(argv[0]);
+			return WRONG_ARGUMENTS;
+		}
+	}
+
+	if (params.size < 1 || params.batch < 1 || params.samples < 1 ||
+		params.threads < 1 || params.threads > BENCH_MAX_THREADS || 0 == params.seed) {
+		usage(argv[0]);
+		return WRONG_ARGUMENTS;
+	}
+
+	/* Run */
+	bench_queue_register();
+	bench_list_register();
+	bench_ulist_register();
+	bench_clist_register();
+	bench_mtlist_register();
+
+	count = bench_run_all(&params, filter, results, BENCH_MAX_CASES);
+	if (count < 0) {
+		printf("Not enough memory.\n");
+		return BENCHMARK_FAILED;
+	}
+
+	if (json) {
+		bench_print_json(stdout, results, count, &params, label);
+	} else {
+		bench_print_table(stdout, results, count);
+	}
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Prints the usage.                                   *
+ *                                                              *
+ * Parameters: name - The name of the program.                  *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+static void usage(const char *name)
+{
+	printf("Usage: %s [options]\n"
+		   "       %s --compare old.json new.json\n"
+		   "Options:\n"
+		   "  -f filter     run only cases whose name contains filter\n"
+		   "  -n size       elements in the structure (default %d)\n"
+		   "  -b batch      operations per timed sample (default %d)\n"
+		   "  -s samples    timed samples per case (default %d)\n"
+		   "  -t threads    threads for the _mt_ cases (default %d)\n"
+		   "  --seed seed   random seed, not 0\n"
+		   "  --perf        read cache and branch misses with perf_event_open\n"
+		   "  --json        print one JSON object per case\n"
+		   "  --label text  label stored in the JSON output\n",
+		   name, name, DEFAULT_SIZE, DEFAULT_BATCH, DEFAULT_SAMPLES, DEFAULT_THREADS);
+}
@@ -0,0 +1,205 @@
+/****************************************************************
+ * Summary: Benchmark cases for the compact list library, the  *
+ *          same operations as the list cases so the two can be *
+ *          compared side by side.                              *
+ ****************************************************************/
+
+#include <stdlib.h>
+#include "../List/clist.h"
+#include "harness.h"
+#include "cases.h"
+
+typedef struct clist_state_rec {
+	int size;
+	int batch;
+	unsigned int seed;
+	clist_t *list;
+	clist_handle_t cursor;
+	clist_handle_t *handles;
+} clist_state_t;
+
+static volatile long long sink = 0;
+
+/****************************************************************
+ * Summary: Creates the state of a compact list case, with a   *
+ *          list holding params->size values and a handle to    *
+ *          every value.                                        *
+ *                                                              *
+ * Parameters: params - The benchmark parameters.               *
+ *                                                              *
+ * Returns: The state if successful, otherwise NULL.            *
+ ****************************************************************/
+static void * clist_setup(const bench_params_t *params)
+{
+	int i = 0;
+	int handle_count = 0;
+	clist_state_t *state = (clist_state_t *)malloc(sizeof(clist_state_t));
+
+	if (NULL == state) {
+		return NULL;
+	}
+
+	handle_count = (params->size > params->batch) ? params->size : params->batch;
+
+	state->size = params->size;
+	state->batch = params->batch;
+	state->seed = params->seed;
+	state->list = clist_create();
+	state->handles = (clist_handle_t *)malloc(sizeof(clist_handle_t) * handle_count);
+	if (NULL == state->list || NULL == state->handles) {
+		if (NULL != state->list) {
+			clist_destroy(state->list);
+		}
+		free(state->handles);
+		free(state);
+		return NULL;
+	}
+	for (i = 0 ; i < params->size ; ++i) {
+		state->handles[i] = clist_add_node(state->list, (int)(bench_rand(&state->seed) & 0xffff));
+	}
+	state->cursor = clist_get_head(state->list);
+
+	return state;
+}
+
+static void clist_teardown(void *arg)
+{
+	clist_state_t *state = (clist_state_t *)arg;
+
+	clist_destroy(state->list);
+	free(state->handles);
+	free(state);
+}
+
+static void clist_fresh_before(void *arg, int thread)
+{
+	clist_state_t *state = (clist_state_t *)arg;
+
+	clist_destroy(state->list);
+	state->list = clist_create();
+	(void)thread;
+}
+
+static void clist_add_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	clist_state_t *state = (clist_state_t *)arg;
+
+	for (i = 0 ; i < ops ; ++i) {
+		clist_add_node(state->list, i);
+	}
+	(void)thread;
+}
+
+static void clist_iterate_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	long long sum = 0;
+	clist_state_t *state = (clist_state_t *)arg;
+	clist_handle_t node = state->cursor;
+
+	for (i = 0 ; i < ops ; ++i) {
+		if (CLIST_NONE == node) {
+			node = clist_get_head(state->list);
+		}
+		sum += clist_get_node_value(state->list, node);
+		node = clist_get_next_node(state->list, node);
+	}
+	state->cursor = node;
+	sink = sum;
+	(void)thread;
+}
+
+static void clist_remove_before(void *arg, int thread)
+{
+	int i = 0, j = 0;
+	clist_handle_t temp = CLIST_NONE;
+	clist_state_t *state = (clist_state_t *)arg;
+
+	clist_fresh_before(arg, thread);
+	for (i = 0 ; i < state->batch ; ++i) {
+		state->handles[i] = clist_add_node(state->list, i);
+	}
+	for (i = state->batch - 1 ; i > 0 ; --i) {
+		j = (int)(bench_rand(&state->seed) % (unsigned int)(i + 1));
+		temp = state->handles[i];
+		state->handles[i] = state->handles[j];
+		state->handles[j] = temp;
+	}
+}
+
+static void clist_remove_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	clist_state_t *state = (clist_state_t *)arg;
+
+	for (i = 0 ; i < ops ; ++i) {
+		clist_remove_node(state->list, state->handles[i]);
+	}
+	(void)thread;
+}
+
+static void clist_churn_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	int r = 0;
+	clist_state_t *state = (clist_state_t *)arg;
+
+	for (i = 0 ; i < ops ; ++i) {
+		r = (int)(bench_rand(&state->seed) % (unsigned int)state->size);
+		clist_remove_node(state->list, state->handles[r]);
+		state->handles[r] = clist_add_node(state->list, r);
+	}
+	state->cursor = clist_get_head(state->list);
+	(void)thread;
+}
+
+/* Iterate a list whose nodes were scattered by size churn operations. */
+static void * clist_churned_setup(const bench_params_t *params)
+{
+	clist_state_t *state = (clist_state_t *)clist_setup(params);
+
+	if (NULL != state) {
+		clist_churn_run(state, 0, state->size);
+	}
+
+	return state;
+}
+
+/* Iterate a churned list after restoring memory order. */
+static void * clist_compacted_setup(const bench_params_t *params)
+{
+	clist_state_t *state = (clist_state_t *)clist_churned_setup(params);
+
+	if (NULL != state) {
+		clist_compact(state->list, NULL);
+		state->cursor = clist_get_head(state->list);
+	}
+
+	return state;
+}
+
+static const bench_case_t clist_cases[] = {
+	{ "clist_add", 0, clist_setup, clist_fresh_before, clist_add_run, NULL, clist_teardown },
+	{ "clist_iterate", 0, clist_setup, NULL, clist_iterate_run, NULL, clist_teardown },
+	{ "clist_iterate_churned", 0, clist_churned_setup, NULL, clist_iterate_run, NULL, clist_teardown },
+	{ "clist_iterate_compacted", 0, clist_compacted_setup, NULL, clist_iterate_run, NULL, clist_teardown },
+	{ "clist_remove_random", 0, clist_setup, clist_remove_before, clist_remove_run, NULL, clist_teardown },
+	{ "clist_churn", 0, clist_setup, NULL, clist_churn_run, NULL, clist_teardown }
+};
+
+/****************************************************************
+ * Summary: Registers the compact list cases with the harness. *
+ *                                                              *
+ * Parameters: None.                                            *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void bench_clist_register(void)
+{
+	unsigned int i = 0;
+
+	for (i = 0 ; i < sizeof(clist_cases) / sizeof(clist_cases[0]) ; ++i) {
+		bench_register(&clist_cases[i]);
+	}
+}
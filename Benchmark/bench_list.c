@@ -0,0 +1,549 @@
+/****************************************************************
+ * Summary: Benchmark cases for the bi-directional list         *
+ *          library.                                            *
+ ****************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include "../List/list.h"
+#include "../List/listpar.h"
+#include "../List/listsnap.h"
+#include "harness.h"
+#include "cases.h"
+
+typedef struct list_state_rec {
+	int size;
+	int batch;
+	unsigned int seed;
+	list_t *list;
+	list_node_t *cursor;		/* iteration position kept across samples */
+	list_node_t **handles;		/* nodes that can be removed at random */
+	int *values;				/* one batch of random values */
+	list_pool_t *pool;			/* for the parallel cases */
+	pthread_mutex_t lock;
+} list_state_t;
+
+/* Written by the snapshot cases in the working directory. */
+#define LIST_BENCH_SNAPSHOT "bench_list.snap"
+
+static volatile long long sink = 0;
+
+/****************************************************************
+ * Summary: Creates the state of a list case, with a list       *
+ *          holding params->size values and a handle to every   *
+ *          node.                                               *
+ *                                                              *
+ * Parameters: params - The benchmark parameters.               *
+ *                                                              *
+ * Returns: The state if successful, otherwise NULL.            *
+ ****************************************************************/
+static void * list_setup(const bench_params_t *params)
+{
+	int i = 0;
+	int handle_count = 0;
+	list_state_t *state = (list_state_t *)malloc(sizeof(list_state_t));
+
+	if (NULL == state) {
+		return NULL;
+	}
+
+	/* Room for the initial nodes, or for one batch per thread */
+	handle_count = params->size;
+	if (handle_count < params->batch * params->threads) {
+		handle_count = params->batch * params->threads;
+	}
+
+	state->size = params->size;
+	state->batch = params->batch;
+	state->seed = params->seed;
+	state->list = list_create();
+	state->handles = (list_node_t **)malloc(sizeof(list_node_t *) * handle_count);
+	state->values = (int *)malloc(sizeof(int) * params->batch);
+	if (NULL == state->list || NULL == state->handles || NULL == state->values) {
+		if (NULL != state->list) {
+			list_destroy(state->list);
+		}
+		free(state->handles);
+		free(state->values);
+		free(state);
+		return NULL;
+	}
+	for (i = 0 ; i < params->batch ; ++i) {
+		state->values[i] = (int)(bench_rand(&state->seed) & 0xffff);
+	}
+	for (i = 0 ; i < params->size ; ++i) {
+		state->handles[i] = list_add_node(state->list, (int)(bench_rand(&state->seed) & 0xffff));
+	}
+	state->cursor = list_get_head(state->list);
+	state->pool = NULL;
+	pthread_mutex_init(&state->lock, NULL);
+
+	return state;
+}
+
+static void list_teardown(void *arg)
+{
+	list_state_t *state = (list_state_t *)arg;
+
+	pthread_mutex_destroy(&state->lock);
+	if (NULL != state->list) {
+		list_destroy(state->list);
+	}
+	if (NULL != state->pool) {
+		list_pool_destroy(state->pool);
+	}
+	free(state->handles);
+	free(state->values);
+	free(state);
+}
+
+/* Append to a list that is recreated before every sample. */
+static void list_fresh_before(void *arg, int thread)
+{
+	list_state_t *state = (list_state_t *)arg;
+
+	if (NULL != state->list) {
+		list_destroy(state->list);
+	}
+	state->list = list_create();
+	(void)thread;
+}
+
+/* Append to a list that draws its nodes from a slab. */
+static void list_pooled_before(void *arg, int thread)
+{
+	list_state_t *state = (list_state_t *)arg;
+
+	if (NULL != state->list) {
+		list_destroy(state->list);
+	}
+	state->list = list_create_pooled(0);
+	(void)thread;
+}
+
+/* Append with order statistics enabled. */
+static void list_ordered_before(void *arg, int thread)
+{
+	list_state_t *state = (list_state_t *)arg;
+
+	list_fresh_before(arg, thread);
+	list_enable_order_stats(state->list);
+}
+
+/* Append with the value index enabled. */
+static void list_indexed_before(void *arg, int thread)
+{
+	list_state_t *state = (list_state_t *)arg;
+
+	list_fresh_before(arg, thread);
+	list_enable_index(state->list);
+}
+
+static void list_add_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	list_state_t *state = (list_state_t *)arg;
+
+	for (i = 0 ; i < ops ; ++i) {
+		list_add_node(state->list, i);
+	}
+	(void)thread;
+}
+
+/* Walk the list with list_get_next_node, wrapping at the tail. */
+static void list_iterate_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	long long sum = 0;
+	list_state_t *state = (list_state_t *)arg;
+	list_node_t *node = state->cursor;
+
+	for (i = 0 ; i < ops ; ++i) {
+		if (NULL == node) {
+			node = list_get_head(state->list);
+		}
+		sum += list_get_node_value(node);
+		node = list_get_next_node(node);
+	}
+	state->cursor = node;
+	sink = sum;
+	(void)thread;
+}
+
+/* Look up random values through the index. */
+static void * list_indexed_setup(const bench_params_t *params)
+{
+	list_state_t *state = (list_state_t *)list_setup(params);
+
+	if (NULL != state && 0 != list_enable_index(state->list)) {
+		list_teardown(state);
+		return NULL;
+	}
+
+	return state;
+}
+
+static void list_find_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	long long found = 0;
+	list_state_t *state = (list_state_t *)arg;
+
+	for (i = 0 ; i < ops ; ++i) {
+		found += (NULL != list_find(state->list, (int)(bench_rand(&state->seed) & 0x1ffff)));
+	}
+	sink = found;
+	(void)thread;
+}
+
+/* Remove a batch of nodes in random order. */
+static void list_remove_before(void *arg, int thread)
+{
+	int i = 0, j = 0;
+	list_node_t *temp = NULL;
+	list_state_t *state = (list_state_t *)arg;
+
+	list_fresh_before(arg, thread);
+	for (i = 0 ; i < state->batch ; ++i) {
+		state->handles[i] = list_add_node(state->list, i);
+	}
+	for (i = state->batch - 1 ; i > 0 ; --i) {
+		j = (int)(bench_rand(&state->seed) % (unsigned int)(i + 1));
+		temp = state->handles[i];
+		state->handles[i] = state->handles[j];
+		state->handles[j] = temp;
+	}
+}
+
+/* Remove a batch of indexed nodes that share two values, in random order. */
+static void list_remove_indexed_before(void *arg, int thread)
+{
+	int i = 0, j = 0;
+	list_node_t *temp = NULL;
+	list_state_t *state = (list_state_t *)arg;
+
+	list_indexed_before(arg, thread);
+	for (i = 0 ; i < state->batch ; ++i) {
+		state->handles[i] = list_add_node(state->list, i & 1);
+	}
+	for (i = state->batch - 1 ; i > 0 ; --i) {
+		j = (int)(bench_rand(&state->seed) % (unsigned int)(i + 1));
+		temp = state->handles[i];
+		state->handles[i] = state->handles[j];
+		state->handles[j] = temp;
+	}
+}
+
+static void list_remove_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	list_state_t *state = (list_state_t *)arg;
+
+	for (i = 0 ; i < ops ; ++i) {
+		list_remove_node(state->list, state->handles[i]);
+	}
+	(void)thread;
+}
+
+/* Replace a random node with a new one, keeping the size fixed. */
+static void list_churn_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	int r = 0;
+	list_state_t *state = (list_state_t *)arg;
+
+	for (i = 0 ; i < ops ; ++i) {
+		r = (int)(bench_rand(&state->seed) % (unsigned int)state->size);
+		list_remove_node(state->list, state->handles[r]);
+		state->handles[r] = list_add_node(state->list, r);
+	}
+	state->cursor = list_get_head(state->list);
+	(void)thread;
+}
+
+/* Destroy a list of batch nodes. */
+static void list_destroy_before(void *arg, int thread)
+{
+	int i = 0;
+	list_state_t *state = (list_state_t *)arg;
+
+	list_fresh_before(arg, thread);
+	for (i = 0 ; i < state->batch ; ++i) {
+		list_add_node(state->list, i);
+	}
+}
+
+static void list_destroy_pooled_before(void *arg, int thread)
+{
+	int i = 0;
+	list_state_t *state = (list_state_t *)arg;
+
+	list_pooled_before(arg, thread);
+	for (i = 0 ; i < state->batch ; ++i) {
+		list_add_node(state->list, i);
+	}
+}
+
+static void list_destroy_run(void *arg, int thread, int ops)
+{
+	list_state_t *state = (list_state_t *)arg;
+
+	list_destroy(state->list);
+	state->list = NULL;
+	(void)thread;
+	(void)ops;
+}
+
+/* Build a list of batch values in one call. */
+static void list_from_array_before(void *arg, int thread)
+{
+	list_state_t *state = (list_state_t *)arg;
+
+	if (NULL != state->list) {
+		list_destroy(state->list);
+		state->list = NULL;
+	}
+	(void)thread;
+}
+
+static void list_from_array_run(void *arg, int thread, int ops)
+{
+	list_state_t *state = (list_state_t *)arg;
+
+	state->list = list_from_array(state->values, ops);
+	(void)thread;
+}
+
+/* Sort a list of batch random values. */
+static void list_sort_before(void *arg, int thread)
+{
+	int i = 0;
+	list_state_t *state = (list_state_t *)arg;
+
+	list_fresh_before(arg, thread);
+	for (i = 0 ; i < state->batch ; ++i) {
+		list_add_node(state->list, state->values[i]);
+	}
+}
+
+static void list_sort_run(void *arg, int thread, int ops)
+{
+	list_state_t *state = (list_state_t *)arg;
+
+	list_sort(state->list);
+	(void)thread;
+	(void)ops;
+}
+
+/* Reduce a list of batch values on a pool of params->threads threads. */
+static void * list_pool_setup(const bench_params_t *params)
+{
+	list_state_t *state = (list_state_t *)list_setup(params);
+
+	if (NULL == state) {
+		return NULL;
+	}
+	list_destroy(state->list);
+	state->list = list_from_array(state->values, state->batch);
+	state->pool = list_pool_create(params->threads);
+	if (NULL == state->list || NULL == state->pool) {
+		list_teardown(state);
+		return NULL;
+	}
+
+	return state;
+}
+
+static void sum_init(void *partial, void *context)
+{
+	*(long long *)partial = 0;
+	(void)context;
+}
+
+static void sum_accumulate(void *partial, int value, void *context)
+{
+	*(long long *)partial += value;
+	(void)context;
+}
+
+/* Some CPU work per value, a few rounds of an integer hash. */
+static void hash_accumulate(void *partial, int value, void *context)
+{
+	int i = 0;
+	unsigned int x = (unsigned int)value;
+
+	for (i = 0 ; i < 16 ; ++i) {
+		x ^= x >> 16;
+		x *= 0x7feb352dU;
+		x ^= x >> 15;
+		x *= 0x846ca68bU;
+	}
+	*(long long *)partial += x;
+	(void)context;
+}
+
+static void sum_combine(void *into, const void *partial, void *context)
+{
+	*(long long *)into += *(const long long *)partial;
+	(void)context;
+}
+
+static void list_reduce_sum_run(void *arg, int thread, int ops)
+{
+	long long result = 0;
+	list_reducer_t reducer = { sizeof(long long), sum_init, sum_accumulate, sum_combine, NULL };
+	list_state_t *state = (list_state_t *)arg;
+
+	list_reduce(state->list, state->pool, &reducer, &result);
+	sink = result;
+	(void)thread;
+	(void)ops;
+}
+
+static void list_reduce_hash_run(void *arg, int thread, int ops)
+{
+	long long result = 0;
+	list_reducer_t reducer = { sizeof(long long), sum_init, hash_accumulate, sum_combine, NULL };
+	list_state_t *state = (list_state_t *)arg;
+
+	list_reduce(state->list, state->pool, &reducer, &result);
+	sink = result;
+	(void)thread;
+	(void)ops;
+}
+
+/* Open a saved list of batch values and read every value. */
+static void * list_snapshot_setup(const bench_params_t *params)
+{
+	list_state_t *state = (list_state_t *)list_setup(params);
+
+	if (NULL == state) {
+		return NULL;
+	}
+	list_destroy(state->list);
+	state->list = list_from_array(state->values, state->batch);
+	if (NULL == state->list || 0 != list_save(state->list, LIST_BENCH_SNAPSHOT, LIST_SNAPSHOT_SORTED)) {
+		list_teardown(state);
+		return NULL;
+	}
+
+	return state;
+}
+
+static void list_snapshot_teardown(void *arg)
+{
+	remove(LIST_BENCH_SNAPSHOT);
+	list_teardown(arg);
+}
+
+static void list_snapshot_scan_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	int count = 0;
+	long long sum = 0;
+	const int *values = NULL;
+	list_snapshot_t *snapshot = list_snapshot_open(LIST_BENCH_SNAPSHOT);
+
+	if (NULL == snapshot) {
+		return;
+	}
+	values = list_snapshot_get_values(snapshot);
+	count = list_snapshot_get_count(snapshot);
+	for (i = 0 ; i < count ; ++i) {
+		sum += values[i];
+	}
+	list_snapshot_close(snapshot);
+	sink = sum;
+	(void)arg;
+	(void)thread;
+	(void)ops;
+}
+
+static void list_snapshot_thaw_run(void *arg, int thread, int ops)
+{
+	list_t *list = NULL;
+	list_snapshot_t *snapshot = list_snapshot_open(LIST_BENCH_SNAPSHOT);
+
+	if (NULL == snapshot) {
+		return;
+	}
+	list = list_snapshot_thaw(snapshot);
+	if (NULL != list) {
+		sink = list_get_sum(list);
+		list_destroy(list);
+	}
+	list_snapshot_close(snapshot);
+	(void)arg;
+	(void)thread;
+	(void)ops;
+}
+
+/* Every thread adds and removes its own nodes of a shared list behind one mutex. */
+static void list_mt_churn_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	list_state_t *state = (list_state_t *)arg;
+	list_node_t **handles = state->handles + thread * state->batch;
+
+	for (i = 0 ; i < ops ; ++i) {
+		pthread_mutex_lock(&state->lock);
+		handles[i] = list_add_node(state->list, i);
+		pthread_mutex_unlock(&state->lock);
+	}
+	for (i = 0 ; i < ops ; ++i) {
+		pthread_mutex_lock(&state->lock);
+		list_remove_node(state->list, handles[i]);
+		pthread_mutex_unlock(&state->lock);
+	}
+}
+
+/* Iterate a list whose nodes were scattered by size churn operations. */
+static void * list_churned_setup(const bench_params_t *params)
+{
+	list_state_t *state = (list_state_t *)list_setup(params);
+
+	if (NULL != state) {
+		list_churn_run(state, 0, state->size);
+	}
+
+	return state;
+}
+
+static const bench_case_t list_cases[] = {
+	{ "list_add", 0, list_setup, list_fresh_before, list_add_run, NULL, list_teardown },
+	{ "list_add_pooled", 0, list_setup, list_pooled_before, list_add_run, NULL, list_teardown },
+	{ "list_add_ordered", 0, list_setup, list_ordered_before, list_add_run, NULL, list_teardown },
+	{ "list_add_indexed", 0, list_setup, list_indexed_before, list_add_run, NULL, list_teardown },
+	{ "list_find_indexed", 0, list_indexed_setup, NULL, list_find_run, NULL, list_teardown },
+	{ "list_iterate", 0, list_setup, NULL, list_iterate_run, NULL, list_teardown },
+	{ "list_iterate_churned", 0, list_churned_setup, NULL, list_iterate_run, NULL, list_teardown },
+	{ "list_remove_random", 0, list_setup, list_remove_before, list_remove_run, NULL, list_teardown },
+	{ "list_remove_indexed", 0, list_setup, list_remove_indexed_before, list_remove_run, NULL, list_teardown },
+	{ "list_churn", 0, list_setup, NULL, list_churn_run, NULL, list_teardown },
+	{ "list_destroy", 0, list_setup, list_destroy_before, list_destroy_run, NULL, list_teardown },
+	{ "list_destroy_pooled", 0, list_setup, list_destroy_pooled_before, list_destroy_run, NULL, list_teardown },
+	{ "list_from_array", 0, list_setup, list_from_array_before, list_from_array_run, NULL, list_teardown },
+	{ "list_sort", 0, list_setup, list_sort_before, list_sort_run, NULL, list_teardown },
+	{ "list_reduce_sum", 0, list_pool_setup, NULL, list_reduce_sum_run, NULL, list_teardown },
+	{ "list_reduce_hash", 0, list_pool_setup, NULL, list_reduce_hash_run, NULL, list_teardown },
+	{ "list_snapshot_scan", 0, list_snapshot_setup, NULL, list_snapshot_scan_run, NULL, list_snapshot_teardown },
+	{ "list_snapshot_thaw", 0, list_snapshot_setup, NULL, list_snapshot_thaw_run, NULL, list_snapshot_teardown },
+	{ "list_mt_churn", 1, list_setup, NULL, list_mt_churn_run, NULL, list_teardown }
+};
+
+/****************************************************************
+ * Summary: Registers the list cases with the harness.          *
+ *                                                              *
+ * Parameters: None.                                            *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void bench_list_register(void)
+{
+	unsigned int i = 0;
+
+	for (i = 0 ; i < sizeof(list_cases) / sizeof(list_cases[0]) ; ++i) {
+		bench_register(&list_cases[i]);
+	}
+}
@@ -0,0 +1,175 @@
+/****************************************************************
+ * Summary: Benchmark cases for the concurrent list library.    *
+ *          mtlist_mt_churn does the same work as list_mt_churn *
+ *          so the two can be compared as threads are added.    *
+ ****************************************************************/
+
+#include <stdlib.h>
+#include "../List/mtlist.h"
+#include "harness.h"
+#include "cases.h"
+
+typedef struct mtlist_state_rec {
+	int size;
+	int batch;
+	int threads;
+	unsigned int seed;
+	mtlist_t *list;
+	mtlist_node_t **handles;		/* one batch of nodes per thread */
+	mtlist_thread_t **contexts;		/* one registration per thread */
+} mtlist_state_t;
+
+static volatile long long sink = 0;
+
+static void mtlist_teardown(void *arg);
+
+/****************************************************************
+ * Summary: Creates the state of a concurrent list case, with a *
+ *          list holding params->size values and a thread       *
+ *          registration for every benchmark thread.            *
+ *                                                              *
+ * Parameters: params - The benchmark parameters.               *
+ *                                                              *
+ * Returns: The state if successful, otherwise NULL.            *
+ ****************************************************************/
+static void * mtlist_setup(const bench_params_t *params)
+{
+	int i = 0;
+	mtlist_state_t *state = (mtlist_state_t *)calloc(1, sizeof(mtlist_state_t));
+
+	if (NULL == state) {
+		return NULL;
+	}
+
+	state->size = params->size;
+	state->batch = params->batch;
+	state->threads = params->threads;
+	state->seed = params->seed;
+	state->list = mtlist_create();
+	state->handles = (mtlist_node_t **)malloc(sizeof(mtlist_node_t *) * params->batch * params->threads);
+	state->contexts = (mtlist_thread_t **)calloc(params->threads, sizeof(mtlist_thread_t *));
+	if (NULL == state->list || NULL == state->handles || NULL == state->contexts) {
+		mtlist_teardown(state);
+		return NULL;
+	}
+	for (i = 0 ; i < params->threads ; ++i) {
+		state->contexts[i] = mtlist_thread_register(state->list);
+		if (NULL == state->contexts[i]) {
+			mtlist_teardown(state);
+			return NULL;
+		}
+	}
+	for (i = 0 ; i < params->size ; ++i) {
+		mtlist_add_node(state->contexts[0], (int)(bench_rand(&state->seed) & 0xffff));
+	}
+
+	return state;
+}
+
+static void mtlist_teardown(void *arg)
+{
+	mtlist_state_t *state = (mtlist_state_t *)arg;
+
+	if (NULL != state->list) {
+		mtlist_destroy(state->list);
+	}
+	free(state->handles);
+	free(state->contexts);
+	free(state);
+}
+
+static void mtlist_add_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	mtlist_state_t *state = (mtlist_state_t *)arg;
+	mtlist_thread_t *context = state->contexts[thread];
+	mtlist_node_t **handles = state->handles + thread * state->batch;
+
+	for (i = 0 ; i < ops ; ++i) {
+		handles[i] = mtlist_add_node(context, i);
+	}
+}
+
+/* Removes the nodes added by mtlist_add_run, outside the timing. */
+static void mtlist_add_after(void *arg, int thread)
+{
+	int i = 0;
+	mtlist_state_t *state = (mtlist_state_t *)arg;
+	mtlist_node_t **handles = state->handles + thread * state->batch;
+
+	for (i = 0 ; i < state->batch ; ++i) {
+		mtlist_remove_node(state->contexts[thread], handles[i]);
+	}
+}
+
+static void mtlist_iterate_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	long long sum = 0;
+	mtlist_state_t *state = (mtlist_state_t *)arg;
+	mtlist_thread_t *context = state->contexts[thread];
+	mtlist_node_t *node = NULL;
+
+	mtlist_enter(context);
+	for (i = 0 ; i < ops ; ++i) {
+		if (NULL == node) {
+			node = mtlist_get_head(state->list);
+			if (NULL == node) {
+				break;
+			}
+		}
+		sum += mtlist_get_node_value(node);
+		node = mtlist_get_next_node(node);
+	}
+	mtlist_exit(context);
+	__atomic_store_n(&sink, sum, __ATOMIC_RELAXED);	/* churning threads may run alongside */
+}
+
+static void mtlist_mt_churn_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	mtlist_state_t *state = (mtlist_state_t *)arg;
+	mtlist_thread_t *context = state->contexts[thread];
+	mtlist_node_t **handles = state->handles + thread * state->batch;
+
+	for (i = 0 ; i < ops ; ++i) {
+		handles[i] = mtlist_add_node(context, i);
+	}
+	for (i = 0 ; i < ops ; ++i) {
+		mtlist_remove_node(context, handles[i]);
+	}
+}
+
+/* Thread 0 iterates while the other threads churn. */
+static void mtlist_mt_iterate_churn_run(void *arg, int thread, int ops)
+{
+	if (0 == thread) {
+		mtlist_iterate_run(arg, thread, ops);
+	} else {
+		mtlist_mt_churn_run(arg, thread, ops);
+	}
+}
+
+static const bench_case_t mtlist_cases[] = {
+	{ "mtlist_add", 0, mtlist_setup, NULL, mtlist_add_run, mtlist_add_after, mtlist_teardown },
+	{ "mtlist_iterate", 0, mtlist_setup, NULL, mtlist_iterate_run, NULL, mtlist_teardown },
+	{ "mtlist_mt_churn", 1, mtlist_setup, NULL, mtlist_mt_churn_run, NULL, mtlist_teardown },
+	{ "mtlist_mt_iterate_churn", 1, mtlist_setup, NULL, mtlist_mt_iterate_churn_run, NULL, mtlist_teardown }
+};
+
+/****************************************************************
+ * Summary: Registers the concurrent list cases with the        *
+ *          harness.                                            *
+ *                                                              *
+ * Parameters: None.                                            *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void bench_mtlist_register(void)
+{
+	unsigned int i = 0;
+
+	for (i = 0 ; i < sizeof(mtlist_cases) / sizeof(mtlist_cases[0]) ; ++i) {
+		bench_register(&mtlist_cases[i]);
+	}
+}
@@ -0,0 +1,215 @@
+/****************************************************************
+ * Summary: Benchmark cases for the queue library.              *
+ ****************************************************************/
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "../Queue/queue.h"
+#include "harness.h"
+#include "cases.h"
+
+typedef struct queue_state_rec {
+	int size;
+	int batch;
+	queue_t *queue;
+	pthread_mutex_t lock;
+} queue_state_t;
+
+static volatile int sink = 0;
+
+/****************************************************************
+ * Summary: Checks that an empty queue accepts values again     *
+ *          after being popped until empty, as the push cases   *
+ *          rely on it.                                         *
+ *                                                              *
+ * Parameters: queue - A pointer to an empty queue_t.           *
+ *                                                              *
+ * Returns: 0 if the queue behaves, -1 otherwise.               *
+ ****************************************************************/
+static int queue_drains(queue_t *queue)
+{
+	int value = 0;
+
+	if ((0 != queue_push(queue, 1)) || (0 != queue_push(queue, 2))) {
+		return -1;
+	}
+	while (0 == queue_pop(queue, NULL)) {
+	}
+	if (NULL != queue->tail) {/* would be written through on push */
+		return -1;
+	}
+	if ((0 != queue_push(queue, 3)) || (0 != queue_push(queue, 4))) {
+		return -1;
+	}
+	if ((0 != queue_pop(queue, &value)) || (3 != value)) {
+		return -1;
+	}
+	if ((0 != queue_pop(queue, &value)) || (4 != value)) {
+		return -1;
+	}
+
+	return (0 == queue_get_count(queue)) ? 0 : -1;
+}
+
+/****************************************************************
+ * Summary: Creates the state of a queue case, with a queue     *
+ *          holding params->size values.                        *
+ *                                                              *
+ * Parameters: params - The benchmark parameters.               *
+ *                                                              *
+ * Returns: The state if successful, otherwise NULL.            *
+ ****************************************************************/
+static void * queue_setup(const bench_params_t *params)
+{
+	int i = 0;
+	queue_state_t *state = (queue_state_t *)malloc(sizeof(queue_state_t));
+
+	if (NULL == state) {
+		return NULL;
+	}
+
+	state->size = params->size;
+	state->batch = params->batch;
+	state->queue = queue_create();
+	if (NULL == state->queue) {
+		free(state);
+		return NULL;
+	}
+	if (0 != queue_drains(state->queue)) {
+		queue_destroy(state->queue);
+		free(state);
+		return NULL;
+	}
+	for (i = 0 ; i < params->size ; ++i) {
+		queue_push(state->queue, i);
+	}
+	pthread_mutex_init(&state->lock, NULL);
+
+	return state;
+}
+
+static void queue_teardown(void *arg)
+{
+	queue_state_t *state = (queue_state_t *)arg;
+
+	pthread_mutex_destroy(&state->lock);
+	queue_destroy(state->queue);
+	free(state);
+}
+
+/* Push into an empty queue, emptied again after every sample. */
+static void queue_push_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	queue_state_t *state = (queue_state_t *)arg;
+
+	for (i = 0 ; i < ops ; ++i) {
+		queue_push(state->queue, i);
+	}
+	(void)thread;
+}
+
+static void queue_push_before(void *arg, int thread)
+{
+	queue_state_t *state = (queue_state_t *)arg;
+
+	while (0 == queue_pop(state->queue, NULL)) {
+	}
+	(void)thread;
+}
+
+/* Pop everything pushed before the sample. */
+static void queue_pop_before(void *arg, int thread)
+{
+	int i = 0;
+	queue_state_t *state = (queue_state_t *)arg;
+
+	queue_push_before(arg, thread);
+	for (i = 0 ; i < state->batch ; ++i) {
+		queue_push(state->queue, i);
+	}
+}
+
+static void queue_pop_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	int value = 0;
+	queue_state_t *state = (queue_state_t *)arg;
+
+	for (i = 0 ; i < ops ; ++i) {
+		queue_pop(state->queue, &value);
+		sink = value;
+	}
+	(void)thread;
+}
+
+/* Steady state: one push and one pop per operation. */
+static void queue_push_pop_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	int value = 0;
+	queue_state_t *state = (queue_state_t *)arg;
+
+	for (i = 0 ; i < ops ; ++i) {
+		queue_push(state->queue, i);
+		queue_pop(state->queue, &value);
+	}
+	sink = value;
+	(void)thread;
+}
+
+static void queue_peek_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	int value = 0;
+	queue_state_t *state = (queue_state_t *)arg;
+
+	for (i = 0 ; i < ops ; ++i) {
+		queue_peek(state->queue, &value);
+		sink = value;
+	}
+	(void)thread;
+}
+
+/* Every thread pushes and pops a shared queue behind one mutex. */
+static void queue_mt_push_pop_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	int value = 0;
+	queue_state_t *state = (queue_state_t *)arg;
+
+	for (i = 0 ; i < ops ; ++i) {
+		pthread_mutex_lock(&state->lock);
+		queue_push(state->queue, thread);
+		pthread_mutex_unlock(&state->lock);
+
+		pthread_mutex_lock(&state->lock);
+		queue_pop(state->queue, &value);
+		pthread_mutex_unlock(&state->lock);
+	}
+	__atomic_store_n(&sink, value, __ATOMIC_RELAXED);	/* every thread stores */
+}
+
+static const bench_case_t queue_cases[] = {
+	{ "queue_push", 0, queue_setup, queue_push_before, queue_push_run, NULL, queue_teardown },
+	{ "queue_pop", 0, queue_setup, queue_pop_before, queue_pop_run, NULL, queue_teardown },
+	{ "queue_push_pop", 0, queue_setup, NULL, queue_push_pop_run, NULL, queue_teardown },
+	{ "queue_peek", 0, queue_setup, NULL, queue_peek_run, NULL, queue_teardown },
+	{ "queue_mt_push_pop", 1, queue_setup, NULL, queue_mt_push_pop_run, NULL, queue_teardown }
+};
+
+/****************************************************************
+ * Summary: Registers the queue cases with the harness.         *
+ *                                                              *
+ * Parameters: None.                                            *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void bench_queue_register(void)
+{
+	unsigned int i = 0;
+
+	for (i = 0 ; i < sizeof(queue_cases) / sizeof(queue_cases[0]) ; ++i) {
+		bench_register(&queue_cases[i]);
+	}
+}
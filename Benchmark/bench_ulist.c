@@ -0,0 +1,224 @@
+/****************************************************************
+ * Summary: Benchmark cases for the unrolled list library, the  *
+ *          same operations as the list cases so the two can be *
+ *          compared side by side.                              *
+ ****************************************************************/
+
+#include <stdlib.h>
+#include "../List/ulist.h"
+#include "harness.h"
+#include "cases.h"
+
+typedef struct ulist_state_rec {
+	int size;
+	int batch;
+	unsigned int seed;
+	ulist_t *list;
+	ulist_node_t *cursor;
+	ulist_node_t **handles;
+} ulist_state_t;
+
+static volatile long long sink = 0;
+
+/****************************************************************
+ * Summary: Creates the state of an unrolled list case, with a  *
+ *          list holding params->size values and a handle to    *
+ *          every value.                                        *
+ *                                                              *
+ * Parameters: params - The benchmark parameters.               *
+ *                                                              *
+ * Returns: The state if successful, otherwise NULL.            *
+ ****************************************************************/
+static void * ulist_setup(const bench_params_t *params)
+{
+	int i = 0;
+	int handle_count = 0;
+	ulist_state_t *state = (ulist_state_t *)malloc(sizeof(ulist_state_t));
+
+	if (NULL == state) {
+		return NULL;
+	}
+
+	handle_count = (params->size > params->batch) ? params->size : params->batch;
+
+	state->size = params->size;
+	state->batch = params->batch;
+	state->seed = params->seed;
+	state->list = ulist_create();
+	state->handles = (ulist_node_t **)malloc(sizeof(ulist_node_t *) * handle_count);
+	if (NULL == state->list || NULL == state->handles) {
+		if (NULL != state->list) {
+			ulist_destroy(state->list);
+		}
+		free(state->handles);
+		free(state);
+		return NULL;
+	}
+	for (i = 0 ; i < params->size ; ++i) {
+		state->handles[i] = ulist_add_node(state->list, (int)(bench_rand(&state->seed) & 0xffff));
+	}
+	state->cursor = ulist_get_head(state->list);
+
+	return state;
+}
+
+static void ulist_teardown(void *arg)
+{
+	ulist_state_t *state = (ulist_state_t *)arg;
+
+	ulist_destroy(state->list);
+	free(state->handles);
+	free(state);
+}
+
+static void ulist_fresh_before(void *arg, int thread)
+{
+	ulist_state_t *state = (ulist_state_t *)arg;
+
+	ulist_destroy(state->list);
+	state->list = ulist_create();
+	(void)thread;
+}
+
+static void ulist_add_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	ulist_state_t *state = (ulist_state_t *)arg;
+
+	for (i = 0 ; i < ops ; ++i) {
+		ulist_add_node(state->list, i);
+	}
+	(void)thread;
+}
+
+static void ulist_iterate_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	long long sum = 0;
+	ulist_state_t *state = (ulist_state_t *)arg;
+	ulist_node_t *node = state->cursor;
+
+	for (i = 0 ; i < ops ; ++i) {
+		if (NULL == node) {
+			node = ulist_get_head(state->list);
+		}
+		sum += ulist_get_node_value(node);
+		node = ulist_get_next_node(node);
+	}
+	state->cursor = node;
+	sink = sum;
+	(void)thread;
+}
+
+static void ulist_remove_before(void *arg, int thread)
+{
+	int i = 0, j = 0;
+	ulist_node_t *temp = NULL;
+	ulist_state_t *state = (ulist_state_t *)arg;
+
+	ulist_fresh_before(arg, thread);
+	for (i = 0 ; i < state->batch ; ++i) {
+		state->handles[i] = ulist_add_node(state->list, i);
+	}
+	for (i = state->batch - 1 ; i > 0 ; --i) {
+		j = (int)(bench_rand(&state->seed) % (unsigned int)(i + 1));
+		temp = state->handles[i];
+		state->handles[i] = state->handles[j];
+		state->handles[j] = temp;
+	}
+}
+
+static void ulist_remove_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	ulist_state_t *state = (ulist_state_t *)arg;
+
+	for (i = 0 ; i < ops ; ++i) {
+		ulist_remove_node(state->list, state->handles[i]);
+	}
+	(void)thread;
+}
+
+static void ulist_churn_run(void *arg, int thread, int ops)
+{
+	int i = 0;
+	int r = 0;
+	ulist_state_t *state = (ulist_state_t *)arg;
+
+	for (i = 0 ; i < ops ; ++i) {
+		r = (int)(bench_rand(&state->seed) % (unsigned int)state->size);
+		ulist_remove_node(state->list, state->handles[r]);
+		state->handles[r] = ulist_add_node(state->list, r);
+	}
+	state->cursor = ulist_get_head(state->list);
+	(void)thread;
+}
+
+/* Iterate a list whose nodes were scattered by size churn operations. */
+static void * ulist_churned_setup(const bench_params_t *params)
+{
+	ulist_state_t *state = (ulist_state_t *)ulist_setup(params);
+
+	if (NULL != state) {
+		ulist_churn_run(state, 0, state->size);
+	}
+
+	return state;
+}
+
+/* Iterate a list left with one value per chunk, the worst case of removal. */
+static void * ulist_sparse_setup(const bench_params_t *params)
+{
+	int i = 0;
+	ulist_state_t *state = (ulist_state_t *)ulist_setup(params);
+
+	if (NULL != state) {
+		for (i = 0 ; i < state->size ; ++i) {
+			if (0 != i % (int)ULIST_CHUNK_VALUES) {
+				ulist_remove_node(state->list, state->handles[i]);
+			}
+		}
+		state->cursor = ulist_get_head(state->list);
+	}
+
+	return state;
+}
+
+/* Iterate the same list after ulist_compact packed it again. */
+static void * ulist_compacted_setup(const bench_params_t *params)
+{
+	ulist_state_t *state = (ulist_state_t *)ulist_sparse_setup(params);
+
+	if (NULL != state) {
+		ulist_compact(state->list);
+		state->cursor = ulist_get_head(state->list);
+	}
+
+	return state;
+}
+
+static const bench_case_t ulist_cases[] = {
+	{ "ulist_add", 0, ulist_setup, ulist_fresh_before, ulist_add_run, NULL, ulist_teardown },
+	{ "ulist_iterate", 0, ulist_setup, NULL, ulist_iterate_run, NULL, ulist_teardown },
+	{ "ulist_iterate_churned", 0, ulist_churned_setup, NULL, ulist_iterate_run, NULL, ulist_teardown },
+	{ "ulist_iterate_sparse", 0, ulist_sparse_setup, NULL, ulist_iterate_run, NULL, ulist_teardown },
+	{ "ulist_iterate_compacted", 0, ulist_compacted_setup, NULL, ulist_iterate_run, NULL, ulist_teardown },
+	{ "ulist_remove_random", 0, ulist_setup, ulist_remove_before, ulist_remove_run, NULL, ulist_teardown },
+	{ "ulist_churn", 0, ulist_setup, NULL, ulist_churn_run, NULL, ulist_teardown }
+};
+
+/****************************************************************
+ * Summary: Registers the unrolled list cases with the harness. *
+ *                                                              *
+ * Parameters: None.                                            *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void bench_ulist_register(void)
+{
+	unsigned int i = 0;
+
+	for (i = 0 ; i < sizeof(ulist_cases) / sizeof(ulist_cases[0]) ; ++i) {
+		bench_register(&ulist_cases[i]);
+	}
+}
@@ -0,0 +1,14 @@
+#if !defined(_CASES_H_)
+#define _CASES_H_
+
+void bench_queue_register(void);
+
+void bench_list_register(void);
+
+void bench_ulist_register(void);
+
+void bench_clist_register(void);
+
+void bench_mtlist_register(void);
+
+#endif
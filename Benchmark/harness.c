@@ -0,0 +1,573 @@
+/****************************************************************
+ * Summary: This library implements a small benchmark harness   *
+ *          that times registered cases, computes per-sample    *
+ *          percentiles, optionally reads hardware counters     *
+ *          and reports results as a table or as JSON lines.    *
+ ****************************************************************/
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "harness.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define BENCH_MAX_LINE (1024)
+
+typedef struct thread_arg_rec {
+	const bench_case_t *bench_case;
+	const bench_params_t *params;
+	void *state;
+	int index;
+	pthread_barrier_t *barrier;
+	double *sample_ns;
+	int *perf_fds;
+} thread_arg_t;
+
+static const bench_case_t *cases[BENCH_MAX_CASES];
+static int case_count = 0;
+
+static const char *counter_names[BENCH_COUNTERS] = {
+	"cycles", "instructions", "cache_misses", "branch_misses"
+};
+
+static double now_ns(void);
+static int compare_doubles(const void *a, const void *b);
+static void perf_open(int *fds);
+static void perf_control(int *fds, int enable);
+static int perf_read(int *fds, double *values);
+static void perf_close(int *fds);
+static void * thread_main(void *arg);
+static void fill_result(bench_result_t *result, const bench_case_t *bench_case,
+						const bench_params_t *params, double *sample_ns, int threads);
+static int json_get_string(const char *line, const char *key, char *out, int size);
+static int json_get_number(const char *line, const char *key, double *out);
+
+/****************************************************************
+ * Summary: Registers a case to be run by bench_run_all.        *
+ *                                                              *
+ * Parameters: bench_case - The case, must outlive the harness. *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void bench_register(const bench_case_t *bench_case)
+{
+	if (case_count < BENCH_MAX_CASES) {
+		cases[case_count] = bench_case;
+		++case_count;
+	}
+}
+
+/****************************************************************
+ * Summary: Runs every registered case whose name contains      *
+ *          filter.                                             *
+ *                                                              *
+ * Parameters: params - The benchmark parameters.               *
+ *             filter - A substring to select cases, or NULL.   *
+ *             results - An array to hold the results.          *
+ *             max_results - The size of results.               *
+ *                                                              *
+ * Returns: The amount of results, -1 if failed.                *
+ ****************************************************************/
+int bench_run_all(const bench_params_t *params, const char *filter,
+				  bench_result_t *results, int max_results)
+{
+	int i = 0, t = 0;
+	int count = 0;
+	int threads = 0;
+	int perf_fds[BENCH_COUNTERS];
+	double *sample_ns = NULL;
+	void *state = NULL;
+	pthread_t handles[BENCH_MAX_THREADS];
+	thread_arg_t args[BENCH_MAX_THREADS];
+	pthread_barrier_t barrier;
+
+	sample_ns = (double *)malloc(sizeof(double) * params->samples);
+	if (NULL == sample_ns) {
+		return -1;
+	}
+
+	for (i = 0 ; i < case_count && count < max_results ; ++i) {
+		if (NULL != filter && NULL == strstr(cases[i]->name, filter)) {
+			continue;
+		}
+
+		state = cases[i]->setup(params);
+		if (NULL == state) {
+			fprintf(stderr, "%s: setup failed, skipped.\n", cases[i]->name);
+			continue;
+		}
+
+		threads = cases[i]->threaded ? params->threads : 1;
+		if (threads > BENCH_MAX_THREADS) {
+			threads = BENCH_MAX_THREADS;
+		}
+
+		/* Counters are opened before the threads so they inherit them */
+		for (t = 0 ; t < BENCH_COUNTERS ; ++t) {
+			perf_fds[t] = -1;
+		}
+		if (params->perf) {
+			perf_open(perf_fds);
+		}
+
+		pthread_barrier_init(&barrier, NULL, threads);
+		for (t = 0 ; t < threads ; ++t) {
+			args[t].bench_case = cases[i];
+			args[t].params = params;
+			args[t].state = state;
+			args[t].index = t;
+			args[t].barrier = &barrier;
+			args[t].sample_ns = sample_ns;
+			args[t].perf_fds = perf_fds;
+		}
+
+		for (t = 1 ; t < threads ; ++t) {
+			pthread_create(&handles[t], NULL, thread_main, &args[t]);
+		}
+		thread_main(&args[0]);
+		for (t = 1 ; t < threads ; ++t) {
+			pthread_join(handles[t], NULL);
+		}
+		pthread_barrier_destroy(&barrier);
+
+		fill_result(&results[count], cases[i], params, sample_ns, threads);
+		if (params->perf) {
+			results[count].has_counters = perf_read(perf_fds, results[count].counters);
+			for (t = 0 ; t < BENCH_COUNTERS && results[count].has_counters ; ++t) {
+				results[count].counters[t] /= (double)results[count].ops;
+			}
+			perf_close(perf_fds);
+		}
+
+		cases[i]->teardown(state);
+		++count;
+	}
+
+	free(sample_ns);
+
+	return count;
+}
+
+/****************************************************************
+ * Summary: Runs the samples of one case on one thread. Thread  *
+ *          0 measures the time between the barriers that       *
+ *          surround every sample.                              *
+ *                                                              *
+ * Parameters: arg - A pointer to the thread_arg_t.             *
+ *                                                              *
+ * Returns: NULL.                                               *
+ ****************************************************************/
+static void * thread_main(void *arg)
+{
+	int s = 0;
+	double t0 = 0;
+	thread_arg_t *targ = (thread_arg_t *)arg;
+	const bench_case_t *bench_case = targ->bench_case;
+	const bench_params_t *params = targ->params;
+
+	/* One untimed warm-up sample */
+	if (NULL != bench_case->before) {
+		bench_case->before(targ->state, targ->index);
+	}
+	bench_case->run(targ->state, targ->index, params->batch);
+	if (NULL != bench_case->after) {
+		bench_case->after(targ->state, targ->index);
+	}
+
+	for (s = 0 ; s < params->samples ; ++s) {
+		if (NULL != bench_case->before) {
+			bench_case->before(targ->state, targ->index);
+		}
+
+		pthread_barrier_wait(targ->barrier);
+		if (0 == targ->index) {
+			perf_control(targ->perf_fds, 1);
+			t0 = now_ns();
+		}
+
+		bench_case->run(targ->state, targ->index, params->batch);
+
+		pthread_barrier_wait(targ->barrier);
+		if (0 == targ->index) {
+			targ->sample_ns[s] = now_ns() - t0;
+			perf_control(targ->perf_fds, 0);
+		}
+
+		if (NULL != bench_case->after) {
+			bench_case->after(targ->state, targ->index);
+		}
+	}
+
+	return NULL;
+}
+
+/****************************************************************
+ * Summary: Turns the sample timings into a result.             *
+ *                                                              *
+ * Parameters: result - The result to fill.                     *
+ *             bench_case - The case that was run.              *
+ *             params - The benchmark parameters.               *
+ *             sample_ns - The duration of every sample, is     *
+ *                         sorted in place.                     *
+ *             threads - The amount of threads used.            *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+static void fill_result(bench_result_t *result, const bench_case_t *bench_case,
+						const bench_params_t *params, double *sample_ns, int threads)
+{
+	int s = 0;
+	double ops_per_sample = (double)params->batch * threads;
+	double timed_ns = 0;
+
+	for (s = 0 ; s < params->samples ; ++s) {
+		timed_ns += sample_ns[s];
+		sample_ns[s] /= ops_per_sample;
+	}
+	qsort(sample_ns, params->samples, sizeof(double), compare_doubles);
+
+	memset(result, 0, sizeof(bench_result_t));
+	strncpy(result->name, bench_case->name, BENCH_MAX_NAME - 1);
+	result->threads = threads;
+	result->ops = (long long)ops_per_sample * params->samples;
+	result->ns_per_op = timed_ns / (double)result->ops;
+	result->p50 = sample_ns[(params->samples - 1) * 50 / 100];
+	result->p90 = sample_ns[(params->samples - 1) * 90 / 100];
+	result->p99 = sample_ns[(params->samples - 1) * 99 / 100];
+	result->max = sample_ns[params->samples - 1];
+}
+
+/****************************************************************
+ * Summary: Prints results as an aligned table.                 *
+ *                                                              *
+ * Parameters: fp - The stream to print to.                     *
+ *             results - The results.                           *
+ *             count - The amount of results.                   *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void bench_print_table(FILE *fp, const bench_result_t *results, int count)
+{
+	int i = 0;
+
+	fprintf(fp, "%-28s %4s %10s %10s %10s %10s %10s %10s %10s\n",
+			"case", "thr", "ns/op", "p50", "p90", "p99", "max",
+			"cache-mis", "branch-mis");
+	for (i = 0 ; i < count ; ++i) {
+		fprintf(fp, "%-28s %4d %10.2f %10.2f %10.2f %10.2f %10.2f",
+				results[i].name, results[i].threads, results[i].ns_per_op,
+				results[i].p50, results[i].p90, results[i].p99, results[i].max);
+		if (results[i].has_counters) {
+			fprintf(fp, " %10.3f %10.3f\n",
+					results[i].counters[BENCH_COUNTER_CACHE_MISSES],
+					results[i].counters[BENCH_COUNTER_BRANCH_MISSES]);
+		} else {
+			fprintf(fp, " %10s %10s\n", "-", "-");
+		}
+	}
+}
+
+/****************************************************************
+ * Summary: Prints results as JSON lines, one object per case,  *
+ *          with keys in a fixed order so that two runs can be  *
+ *          diffed or passed to bench_compare.                  *
+ *                                                              *
+ * Parameters: fp - The stream to print to.                     *
+ *             results - The results.                           *
+ *             count - The amount of results.                   *
+ *             params - The parameters the results came from.   *
+ *             label - A label for the run (e.g. a commit).     *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void bench_print_json(FILE *fp, const bench_result_t *results, int count,
+					  const bench_params_t *params, const char *label)
+{
+	int i = 0, c = 0;
+
+	for (i = 0 ; i < count ; ++i) {
+		fprintf(fp, "{\"label\":\"%s\",\"case\":\"%s\",\"threads\":%d,"
+				"\"size\":%d,\"batch\":%d,\"samples\":%d,\"ops\":%lld,"
+				"\"ns_per_op\":%.3f,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,"
+				"\"max\":%.3f",
+				(NULL != label) ? label : "", results[i].name, results[i].threads,
+				params->size, params->batch, params->samples, results[i].ops,
+				results[i].ns_per_op, results[i].p50, results[i].p90,
+				results[i].p99, results[i].max);
+		if (results[i].has_counters) {
+			for (c = 0 ; c < BENCH_COUNTERS ; ++c) {
+				fprintf(fp, ",\"%s\":%.4f", counter_names[c], results[i].counters[c]);
+			}
+		}
+		fprintf(fp, "}\n");
+	}
+}
+
+/****************************************************************
+ * Summary: Compares two JSON result files produced by          *
+ *          bench_print_json and prints the change in ns/op and *
+ *          p99 of every case found in both.                    *
+ *                                                              *
+ * Parameters: fp - The stream to print to.                     *
+ *             old_path - The baseline results.                 *
+ *             new_path - The results to compare.               *
+ *                                                              *
+ * Returns: 0 if successful, -1 if a file could not be read.    *
+ ****************************************************************/
+int bench_compare(FILE *fp, const char *old_path, const char *new_path)
+{
+	char old_line[BENCH_MAX_LINE];
+	char new_line[BENCH_MAX_LINE];
+	char old_name[BENCH_MAX_NAME];
+	char new_name[BENCH_MAX_NAME];
+	double old_threads = 0, new_threads = 0;
+	double old_ns = 0, new_ns = 0, old_p99 = 0, new_p99 = 0;
+	FILE *fp_old = NULL;
+	FILE *fp_new = NULL;
+
+	fp_old = fopen(old_path, "r");
+	if (NULL == fp_old) {
+		return -1;
+	}
+	fp_new = fopen(new_path, "r");
+	if (NULL == fp_new) {
+		fclose(fp_old);
+		return -1;
+	}
+
+	fprintf(fp, "%-28s %4s %10s %10s %8s %10s %10s %8s\n", "case", "thr",
+			"old ns/op", "new ns/op", "change", "old p99", "new p99", "change");
+	while (NULL != fgets(new_line, BENCH_MAX_LINE, fp_new)) {
+		if (0 != json_get_string(new_line, "case", new_name, BENCH_MAX_NAME) ||
+			0 != json_get_number(new_line, "threads", &new_threads) ||
+			0 != json_get_number(new_line, "ns_per_op", &new_ns) ||
+			0 != json_get_number(new_line, "p99", &new_p99)) {
+			continue;
+		}
+
+		/* Find the same case in the baseline */
+		rewind(fp_old);
+		while (NULL != fgets(old_line, BENCH_MAX_LINE, fp_old)) {
+			if (0 == json_get_string(old_line, "case", old_name, BENCH_MAX_NAME) &&
+				0 == json_get_number(old_line, "threads", &old_threads) &&
+				0 == strcmp(old_name, new_name) && old_threads == new_threads &&
+				0 == json_get_number(old_line, "ns_per_op", &old_ns) &&
+				0 == json_get_number(old_line, "p99", &old_p99)) {
+				fprintf(fp, "%-28s %4d %10.2f %10.2f %+7.1f%% %10.2f %10.2f %+7.1f%%\n",
+						new_name, (int)new_threads, old_ns, new_ns,
+						100.0 * (new_ns - old_ns) / old_ns, old_p99, new_p99,
+						100.0 * (new_p99 - old_p99) / old_p99);
+				break;
+			}
+		}
+	}
+
+	fclose(fp_old);
+	fclose(fp_new);
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: A small xorshift generator so that every case sees  *
+ *          the same sequence for a given seed.                 *
+ *                                                              *
+ * Parameters: state - The generator state, must not be 0.      *
+ *                                                              *
+ * Returns: The next pseudo random number.                      *
+ ****************************************************************/
+unsigned int bench_rand(unsigned int *state)
+{
+	unsigned int x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return x;
+}
+
+/****************************************************************
+ * Summary: Reads a monotonic clock.                            *
+ *                                                              *
+ * Parameters: None.                                            *
+ *                                                              *
+ * Returns: The time in nanoseconds.                            *
+ ****************************************************************/
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+/****************************************************************
+ * Summary: Opens the hardware counters, disabled. Counters     *
+ *          that are not available are left as -1.              *
+ *                                                              *
+ * Parameters: fds - An array of BENCH_COUNTERS descriptors.    *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+static void perf_open(int *fds)
+{
+	int i = 0;
+#if defined(__linux__)
+	static const unsigned long long configs[BENCH_COUNTERS] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES
+	};
+	struct perf_event_attr attr;
+
+	for (i = 0 ; i < BENCH_COUNTERS ; ++i) {
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = configs[i];
+		attr.disabled = 1;
+		attr.inherit = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+#else
+	for (i = 0 ; i < BENCH_COUNTERS ; ++i) {
+		fds[i] = -1;
+	}
+#endif
+}
+
+static void perf_control(int *fds, int enable)
+{
+#if defined(__linux__)
+	int i = 0;
+
+	for (i = 0 ; i < BENCH_COUNTERS ; ++i) {
+		if (fds[i] >= 0) {
+			ioctl(fds[i], enable ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+		}
+	}
+#else
+	(void)fds;
+	(void)enable;
+#endif
+}
+
+/****************************************************************
+ * Summary: Reads the hardware counters.                        *
+ *                                                              *
+ * Parameters: fds - The counter descriptors.                   *
+ *             values - An array to hold the counter totals.    *
+ *                                                              *
+ * Returns: 1 if every counter was read, otherwise 0.           *
+ ****************************************************************/
+static int perf_read(int *fds, double *values)
+{
+#if defined(__linux__)
+	int i = 0;
+	unsigned long long value = 0;
+
+	for (i = 0 ; i < BENCH_COUNTERS ; ++i) {
+		if (fds[i] < 0 || sizeof(value) != read(fds[i], &value, sizeof(value))) {
+			return 0;
+		}
+		values[i] = (double)value;
+	}
+
+	return 1;
+#else
+	(void)fds;
+	(void)values;
+
+	return 0;
+#endif
+}
+
+static void perf_close(int *fds)
+{
+#if defined(__linux__)
+	int i = 0;
+
+	for (i = 0 ; i < BENCH_COUNTERS ; ++i) {
+		if (fds[i] >= 0) {
+			close(fds[i]);
+		}
+	}
+#else
+	(void)fds;
+#endif
+}
+
+/****************************************************************
+ * Summary: Extracts a string value from a flat JSON line.      *
+ *                                                              *
+ * Parameters: line - The JSON line.                            *
+ *             key - The key to look for.                       *
+ *             out - A buffer to hold the value.                *
+ *             size - The size of out.                          *
+ *                                                              *
+ * Returns: 0 if found, otherwise -1.                           *
+ ****************************************************************/
+static int json_get_string(const char *line, const char *key, char *out, int size)
+{
+	int i = 0;
+	char pattern[BENCH_MAX_NAME];
+	const char *pos = NULL;
+
+	snprintf(pattern, sizeof(pattern), "\"%s\":\"", key);
+	pos = strstr(line, pattern);
+	if (NULL == pos) {
+		return -1;
+	}
+	pos += strlen(pattern);
+	for (i = 0 ; i < size - 1 && '"' != pos[i] && '\0' != pos[i] ; ++i) {
+		out[i] = pos[i];
+	}
+	out[i] = '\0';
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Extracts a numeric value from a flat JSON line.     *
+ *                                                              *
+ * Parameters: line - The JSON line.                            *
+ *             key - The key to look for.                       *
+ *             out - A pointer to hold the value.               *
+ *                                                              *
+ * Returns: 0 if found, otherwise -1.                           *
+ ****************************************************************/
+static int json_get_number(const char *line, const char *key, double *out)
+{
+	char pattern[BENCH_MAX_NAME];
+	const char *pos = NULL;
+
+	snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+	pos = strstr(line, pattern);
+	if (NULL == pos) {
+		return -1;
+	}
+
+	return (1 == sscanf(pos + strlen(pattern), "%lf", out)) ? 0 : -1;
+}
@@ -0,0 +1,69 @@
+#if !defined(_HARNESS_H_)
+#define _HARNESS_H_
+
+#include <stdio.h>
+
+#define BENCH_MAX_CASES		(64)
+#define BENCH_MAX_NAME		(64)
+#define BENCH_MAX_THREADS	(256)
+
+#define BENCH_COUNTER_CYCLES		(0)
+#define BENCH_COUNTER_INSTRUCTIONS	(1)
+#define BENCH_COUNTER_CACHE_MISSES	(2)
+#define BENCH_COUNTER_BRANCH_MISSES	(3)
+#define BENCH_COUNTERS				(4)
+
+/* Parameters shared by every case, set from the command line. */
+typedef struct bench_params_rec {
+	int size;		/* elements in the structure under test */
+	int batch;		/* operations per timed sample */
+	int samples;	/* timed samples per case */
+	int threads;	/* threads for contention cases */
+	int perf;		/* non-0 to read hardware counters */
+	unsigned int seed;
+} bench_params_t;
+
+/****************************************************************
+ * A case is a set of callbacks. setup() builds the state once, *
+ * before() and after() run untimed around every sample, run()  *
+ * is the timed body and must perform exactly ops operations.   *
+ * Threaded cases are called from every thread with its index.  *
+ ****************************************************************/
+typedef struct bench_case_rec {
+	const char *name;
+	int threaded;
+	void * (*setup)(const bench_params_t *params);
+	void (*before)(void *state, int thread);
+	void (*run)(void *state, int thread, int ops);
+	void (*after)(void *state, int thread);
+	void (*teardown)(void *state);
+} bench_case_t;
+
+typedef struct bench_result_rec {
+	char name[BENCH_MAX_NAME];
+	int threads;
+	long long ops;
+	double ns_per_op;	/* total time / total operations */
+	double p50;			/* per-sample ns/op percentiles */
+	double p90;
+	double p99;
+	double max;
+	int has_counters;
+	double counters[BENCH_COUNTERS];	/* per operation */
+} bench_result_t;
+
+void bench_register(const bench_case_t *bench_case);
+
+int bench_run_all(const bench_params_t *params, const char *filter,
+				  bench_result_t *results, int max_results);
+
+void bench_print_table(FILE *fp, const bench_result_t *results, int count);
+
+void bench_print_json(FILE *fp, const bench_result_t *results, int count,
+					  const bench_params_t *params, const char *label);
+
+int bench_compare(FILE *fp, const char *old_path, const char *new_path);
+
+unsigned int bench_rand(unsigned int *state);
+
+#endif
@@ -0,0 +1,823 @@
+/****************************************************************
+ * Summary: This program benchmarks LimitedVocabulary on        *
+ *          generated dictionaries and texts of many sizes, and *
+ *          reports the time to load the dictionary, the MB/s   *
+ *          rewritten and the peak memory of every backend. All *
+ *          runs are child processes, so the peak memory is     *
+ *          that of the run alone. With --check, every output   *
+ *          is compared to that of the original implementation. *
+ *                                                              *
+ *          The files are generated once into work_dir, named   *
+ *          by their parameters, and reused by later runs.      *
+ *                                                              *
+ * Build:   gcc -O2 -pthread -o vocab_bench vocab_bench.c       *
+ *              vocabgen.c vocabref.c harness.c                 *
+ *              ../LimitedVocabulary/arena.c                    *
+ *              ../LimitedVocabulary/batch.c                    *
+ *              ../LimitedVocabulary/compat.c                   *
+ *              ../LimitedVocabulary/dictfile.c                 *
+ *              ../LimitedVocabulary/dictionary.c               *
+ *              ../LimitedVocabulary/dictparse.c                *
+ *              ../LimitedVocabulary/hash.c                     *
+ *              ../LimitedVocabulary/rewrite.c                  *
+ *              ../LimitedVocabulary/rewrite_parallel.c         *
+ *              ../LimitedVocabulary/scan.c                     *
+ *              ../LimitedVocabulary/stats.c -lm                *
+ *                                                              *
+ * Example: vocab_bench /tmp/vocab                              *
+ *          vocab_bench --check -m 1,64 /tmp/vocab              *
+ *          vocab_bench -w 1000000 -m 1024 -b parallel -j 8     *
+ *              --json /tmp/vocab > results.json                *
+ *          vocab_bench --dictionary dict.txt -w 50000          *
+ *          vocab_bench --corpus essay.txt -w 50000 -m 10       *
+ ****************************************************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "vocabgen.h"
+#include "vocabref.h"
+#include "../LimitedVocabulary/dictionary.h"
+#include "../LimitedVocabulary/rewrite.h"
+#include "../LimitedVocabulary/batch.h"
+
+#define WRONG_ARGUMENTS		(-1)
+#define BENCHMARK_FAILED	(-2)
+#define OUTPUT_DIFFERS		(-3)
+
+#define MAX_SIZES			(16)
+#define MAX_PATH			(4096)
+#define MAX_DIR				(1024)	/* so every file name fits in MAX_PATH */
+#define BATCH_PARTS			(16)
+#define COMPARE_BUFFER		(1 << 16)
+
+#define DEFAULT_WORDS		("1000,100000,1000000")
+#define DEFAULT_MEGABYTES	("1,16,64")
+#define DEFAULT_SYNONYMS	(0)
+#define DEFAULT_MAX_SYNONYMS (4)
+#define DEFAULT_HIT_RATE	(0.3)
+#define DEFAULT_ZIPF		(1.0)
+#define DEFAULT_THREADS		(4)
+#define DEFAULT_SEED		(2463534242u)
+
+#define BACKEND_STREAM		(0)
+#define BACKEND_ZERO_COPY	(1)
+#define BACKEND_PARALLEL	(2)
+#define BACKEND_COMPILED	(3)
+#define BACKEND_BATCH		(4)
+#define BACKENDS			(5)
+
+static const char *backend_names[BACKENDS] = {
+	"stream", "zero-copy", "parallel", "compiled", "batch"
+};
+
+typedef struct config_rec {
+	long words[MAX_SIZES];			/* headwords of every dictionary */
+	int word_sizes;
+	double megabytes[MAX_SIZES];	/* size of every text */
+	int text_sizes;
+	vocabgen_params_t gen;			/* words is set per dictionary */
+	int threads;
+	int backends;					/* a bit per backend */
+	int check;
+	int json;
+	const char *dir;
+} config_t;
+
+/* What a child process runs, and what it reports back */
+typedef struct job_rec {
+	int backend;
+	int threads;
+	const char *dictionary_path;
+	const char *text_path;			/* the text, or the directory of a batch */
+	const char *out_path;
+	double load_ms;
+	double rewrite_ms;
+} job_t;
+
+static int parse_words(const char *text, long *values);
+static int parse_megabytes(const char *text, double *values);
+static int parse_backends(const char *text);
+static int generate(const char *path, const config_t *config, double megabytes);
+static int benchmark(const config_t *config, long words);
+static int prepare_text(const config_t *config, double megabytes, char *text_path, char *parts_path);
+static int split_text(const char *text_path, const char *parts_path);
+static int in_child(int (*work)(job_t *job), job_t *job, long *peak_kb);
+static int run_backend(job_t *job);
+static int run_compile(job_t *job);
+static int run_reference(job_t *job);
+static int same_files(const char *a, const char *b);
+static int expect_batch(const char *parts_path, const char *dictionary_path, const char *expected_path);
+static int check_batch(const char *batch_path, const char *expected_path);
+static void print_run(const config_t *config, long words, double megabytes, const job_t *job, long peak_kb,
+					  const char *check);
+static double now_ms(void);
+static void usage(const char *name);
+
+int main(int argc, char *argv[])
+{
+	int i = 0;
+	int w = 0;
+	int rc = 0;
+	int result = 0;
+	const char *dictionary_path = NULL;
+	const char *corpus_path = NULL;
+	config_t config;
+
+	memset(&config, 0, sizeof(config));
+	config.word_sizes = parse_words(DEFAULT_WORDS, config.words);
+	config.text_sizes = parse_megabytes(DEFAULT_MEGABYTES, config.megabytes);
+	config.gen.min_synonyms = DEFAULT_SYNONYMS;
+	config.gen.max_synonyms = DEFAULT_MAX_SYNONYMS;
+	config.gen.hit_rate = DEFAULT_HIT_RATE;
+	config.gen.zipf = DEFAULT_ZIPF;
+	config.gen.seed = DEFAULT_SEED;
+	config.threads = DEFAULT_THREADS;
+	config.backends = (1 << BACKENDS) - 1;
+
+	/* Parse arguments */
+	for (i = 1 ; i < argc ; ++i) {
+		if (0 == strcmp(argv[i], "--dictionary") && i + 1 < argc) {
+			dictionary_path = argv[++i];
+		} else if (0 == strcmp(argv[i], "--corpus") && i + 1 < argc) {
+			corpus_path = argv[++i];
+		} else if (0 == strcmp(argv[i], "--check")) {
+			config.check = 1;
+		} else if (0 == strcmp(argv[i], "--json")) {
+			config.json = 1;
+		} else if (0 == strcmp(argv[i], "-w") && i + 1 < argc) {
+			config.word_sizes = parse_words(argv[++i], config.words);
+		} else if (0 == strcmp(argv[i], "-m") && i + 1 < argc) {
+			config.text_sizes = parse_megabytes(argv[++i], config.megabytes);
+		} else if (0 == strcmp(argv[i], "-b") && i + 1 < argc) {
+			config.backends = parse_backends(argv[++i]);
+		} else if (0 == strcmp(argv[i], "-j") && i + 1 < argc) {
+			config.threads = atoi(argv[++i]);
+		} else if (0 == strcmp(argv[i], "--synonyms") && i + 1 < argc) {
+			++i;
+			if (2 != sscanf(argv[i], "%d,%d", &config.gen.min_synonyms, &config.gen.max_synonyms)) {
+				config.gen.min_synonyms = -1;
+			}
+		} else if (0 == strcmp(argv[i], "--hit") && i + 1 < argc) {
+			config.gen.hit_rate = atof(argv[++i]);
+		} else if (0 == strcmp(argv[i], "--zipf") && i + 1 < argc) {
+			config.gen.zipf = atof(argv[++i]);
+		} else if (0 == strcmp(argv[i], "--seed") && i + 1 < argc) {
+			config.gen.seed = (unsigned int)strtoul(argv[++i], NULL, 0);
+		} else if ('-' != argv[i][0] && NULL == config.dir) {
+			config.dir = argv[i];
+		} else {
+			usage(argv[0]);
+			return WRONG_ARGUMENTS;
+		}
+	}
+
+	if (config.word_sizes < 1 || config.text_sizes < 1 || 0 == config.backends ||
+		config.threads < 1 || 0 == config.gen.seed || config.gen.min_synonyms < 0 ||
+		config.gen.max_synonyms < config.gen.min_synonyms || config.gen.max_synonyms > VOCABGEN_MAX_SYNONYMS ||
+		config.gen.hit_rate < 0 || config.gen.hit_rate > 1 || config.gen.zipf < 0 ||
+		(NULL == config.dir) == (NULL == dictionary_path && NULL == corpus_path) ||
+		(NULL != config.dir && strlen(config.dir) > MAX_DIR)) {
+		usage(argv[0]);
+		return WRONG_ARGUMENTS;
+	}
+
+	/* Only generate */
+	if (NULL == config.dir) {
+		config.gen.words = config.words[0];
+		if (NULL != dictionary_path) {
+			rc = generate(dictionary_path, &config, 0);
+		}
+		if (0 == rc && NULL != corpus_path) {
+			rc = generate(corpus_path, &config, config.megabytes[0]);
+		}
+		return rc;
+	}
+
+	if (0 != mkdir(config.dir, 0755) && EEXIST != errno) {
+		printf("Could not create %s.\n", config.dir);
+		return BENCHMARK_FAILED;
+	}
+	if (!config.json) {
+		printf("%10s %8s %-10s %4s %10s %10s %10s %10s  %s\n", "words", "MB", "backend", "thr",
+			   "load ms", "rewrite ms", "MB/s", "peak KB", "check");
+	}
+	for (w = 0 ; w < config.word_sizes ; ++w) {
+		result = benchmark(&config, config.words[w]);
+		if (0 != result) {
+			rc = result;
+		}
+		if (BENCHMARK_FAILED == result) {
+			break;
+		}
+	}
+
+	return rc;
+}
+
+/****************************************************************
+ * Summary: Runs every backend on every text with a dictionary  *
+ *          of the given size.                                  *
+ *                                                              *
+ * Parameters: config - The benchmark configuration.            *
+ *             words - The headwords of the dictionary.         *
+ *                                                              *
+ * Returns: 0 if successful, otherwise BENCHMARK_FAILED or      *
+ *          OUTPUT_DIFFERS.                                     *
+ ****************************************************************/
+static int benchmark(const config_t *config, long words)
+{
+	int rc = 0;
+	int t = 0, b = 0;
+	long peak_kb = 0;
+	const char *check = "-";
+	char dictionary_path[MAX_PATH];
+	char compiled_path[MAX_PATH];
+	char text_path[MAX_PATH];
+	char parts_path[MAX_PATH];
+	char out_path[MAX_PATH];
+	char expected_path[MAX_PATH];
+	char batch_path[MAX_PATH];
+	config_t sized = *config;
+	job_t job;
+
+	sized.gen.words = words;
+	snprintf(dictionary_path, MAX_PATH, "%s/dict-w%ld-s%d-%d-%u.txt", config->dir, words,
+			 config->gen.min_synonyms, config->gen.max_synonyms, config->gen.seed);
+	snprintf(compiled_path, MAX_PATH, "%s/dict-w%ld-s%d-%d-%u.lv", config->dir, words,
+			 config->gen.min_synonyms, config->gen.max_synonyms, config->gen.seed);
+	snprintf(out_path, MAX_PATH, "%s/out.txt", config->dir);
+	snprintf(expected_path, MAX_PATH, "%s/expected", config->dir);
+	snprintf(batch_path, MAX_PATH, "%s/batch", config->dir);
+
+	/* Generate and compile the dictionary */
+	if (0 != access(dictionary_path, F_OK) && 0 != generate(dictionary_path, &sized, 0)) {
+		return BENCHMARK_FAILED;
+	}
+	memset(&job, 0, sizeof(job));
+	job.dictionary_path = dictionary_path;
+	job.out_path = compiled_path;
+	if (0 != (config->backends & (1 << BACKEND_COMPILED)) && 0 != access(compiled_path, F_OK) &&
+		0 != in_child(run_compile, &job, &peak_kb)) {
+		printf("Could not compile %s.\n", dictionary_path);
+		return BENCHMARK_FAILED;
+	}
+
+	for (t = 0 ; t < config->text_sizes && BENCHMARK_FAILED != rc ; ++t) {
+		if (0 != prepare_text(&sized, config->megabytes[t], text_path, parts_path)) {
+			return BENCHMARK_FAILED;
+		}
+
+		/* What the original implementation makes of the text, and of every part */
+		if (config->check) {
+			job.dictionary_path = dictionary_path;
+			job.text_path = text_path;
+			job.out_path = expected_path;
+			if (0 != in_child(run_reference, &job, &peak_kb) ||
+				(0 != (config->backends & (1 << BACKEND_BATCH)) &&
+				 0 != expect_batch(parts_path, dictionary_path, expected_path))) {
+				printf("Could not rewrite %s with the reference.\n", text_path);
+				return BENCHMARK_FAILED;
+			}
+		}
+
+		for (b = 0 ; b < BACKENDS ; ++b) {
+			if (0 == (config->backends & (1 << b))) {
+				continue;
+			}
+
+			memset(&job, 0, sizeof(job));
+			job.backend = b;
+			job.threads = (BACKEND_PARALLEL == b || BACKEND_BATCH == b) ? config->threads : 1;
+			job.dictionary_path = (BACKEND_COMPILED == b) ? compiled_path : dictionary_path;
+			job.text_path = text_path;
+			job.out_path = out_path;
+			if (BACKEND_BATCH == b) {
+				/* The batch rewrites in place, so it gets fresh copies of the parts */
+				if (0 != split_text(text_path, batch_path)) {
+					return BENCHMARK_FAILED;
+				}
+				job.text_path = batch_path;
+			}
+
+			if (0 != in_child(run_backend, &job, &peak_kb)) {
+				printf("%s failed on %s.\n", backend_names[b], text_path);
+				return BENCHMARK_FAILED;
+			}
+
+			check = "-";
+			if (config->check) {
+				if (BACKEND_BATCH == b) {
+					check = (0 == check_batch(batch_path, expected_path)) ? "ok" : "differs";
+				} else {
+					check = (1 == same_files(out_path, expected_path)) ? "ok" : "differs";
+				}
+				if ('d' == check[0]) {
+					rc = OUTPUT_DIFFERS;
+				}
+			}
+			print_run(config, words, config->megabytes[t], &job, peak_kb, check);
+		}
+	}
+	remove(out_path);
+	remove(expected_path);
+	for (t = 0 ; t < BATCH_PARTS ; ++t) {
+		snprintf(expected_path, MAX_PATH, "%s/expected-%03d", config->dir, t);
+		remove(expected_path);
+	}
+
+	return rc;
+}
+
+/****************************************************************
+ * Summary: Generates a text once, and splits it into the parts *
+ *          of a batch.                                         *
+ *                                                              *
+ * Parameters: config - The configuration, with the words of    *
+ *                      the dictionary.                         *
+ *             megabytes - The size of the text.                *
+ *             text_path - Receives the path of the text.       *
+ *             parts_path - Receives the directory of its parts.*
+ *                                                              *
+ * Returns: 0 if successful, otherwise BENCHMARK_FAILED.        *
+ ****************************************************************/
+static int prepare_text(const config_t *config, double megabytes, char *text_path, char *parts_path)
+{
+	snprintf(text_path, MAX_PATH, "%s/text-w%ld-m%g-h%g-z%g-%u.txt", config->dir, config->gen.words, megabytes,
+			 config->gen.hit_rate, config->gen.zipf, config->gen.seed);
+	if (MAX_PATH <= snprintf(parts_path, MAX_PATH, "%s.parts", text_path)) {
+		return BENCHMARK_FAILED;
+	}
+
+	if (0 != access(text_path, F_OK) && 0 != generate(text_path, config, megabytes)) {
+		return BENCHMARK_FAILED;
+	}
+	if (0 != (config->backends & (1 << BACKEND_BATCH)) && 0 != access(parts_path, F_OK) &&
+		0 != split_text(text_path, parts_path)) {
+		return BENCHMARK_FAILED;
+	}
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Generates a dictionary, or a text.                  *
+ *                                                              *
+ * Parameters: path - The file to write.                        *
+ *             config - What to generate, words is the size of  *
+ *                      the dictionary.                         *
+ *             megabytes - The size of the text, 0 for the      *
+ *                         dictionary.                          *
+ *                                                              *
+ * Returns: 0 if successful, otherwise BENCHMARK_FAILED.        *
+ ****************************************************************/
+static int generate(const char *path, const config_t *config, double megabytes)
+{
+	int rc = 0;
+	FILE *fp = fopen(path, "wb");
+
+	if (NULL == fp) {
+		printf("Could not create %s.\n", path);
+		return BENCHMARK_FAILED;
+	}
+
+	if (0 == megabytes) {
+		rc = vocabgen_dictionary(fp, &config->gen);
+	} else {
+		rc = vocabgen_corpus(fp, (long long)(megabytes * 1024 * 1024), &config->gen);
+	}
+	if (0 != fclose(fp) || 0 != rc) {
+		printf("Could not generate %s.\n", path);
+		remove(path);
+		return BENCHMARK_FAILED;
+	}
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Splits a text into BATCH_PARTS files at line ends,  *
+ *          replacing the files of an earlier split.            *
+ *                                                              *
+ * Parameters: text_path - The text.                            *
+ *             parts_path - The directory of the parts.         *
+ *                                                              *
+ * Returns: 0 if successful, otherwise BENCHMARK_FAILED.        *
+ ****************************************************************/
+static int split_text(const char *text_path, const char *parts_path)
+{
+	int c = 0;
+	int part = 0;
+	long long written = 0;
+	long long part_size = 0;
+	char path[MAX_PATH];
+	struct stat info;
+	FILE *in = NULL;
+	FILE *out = NULL;
+
+	if (0 != stat(text_path, &info) || (0 != mkdir(parts_path, 0755) && EEXIST != errno)) {
+		return BENCHMARK_FAILED;
+	}
+	in = fopen(text_path, "rb");
+	if (NULL == in) {
+		return BENCHMARK_FAILED;
+	}
+	part_size = (long long)info.st_size / BATCH_PARTS + 1;
+
+	for (part = 0 ; part < BATCH_PARTS ; ++part) {
+		snprintf(path, MAX_PATH, "%s/part-%03d.txt", parts_path, part);
+		out = fopen(path, "wb");
+		if (NULL == out) {
+			fclose(in);
+			return BENCHMARK_FAILED;
+		}
+		/* The last part takes whatever is left */
+		written = 0;
+		while (EOF != (c = getc(in))) {
+			putc(c, out);
+			++written;
+			if ('\n' == c && written >= part_size && part + 1 < BATCH_PARTS) {
+				break;
+			}
+		}
+		if (0 != fclose(out)) {
+			fclose(in);
+			return BENCHMARK_FAILED;
+		}
+	}
+	fclose(in);
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Runs work in a child process, so it starts with the *
+ *          memory of this one and its peak is its own.         *
+ *                                                              *
+ * Parameters: work - What to run, returns 0 if successful and  *
+ *                    fills the times of job.                   *
+ *             job - The job, receives the times.               *
+ *             peak_kb - Receives the peak resident size of the *
+ *                       child.                                 *
+ *                                                              *
+ * Returns: 0 if successful, otherwise -1.                      *
+ ****************************************************************/
+static int in_child(int (*work)(job_t *job), job_t *job, long *peak_kb)
+{
+	int fds[2];
+	int status = 0;
+	ssize_t got = 0;
+	pid_t pid = 0;
+	struct rusage usage;
+
+	if (0 != pipe(fds)) {
+		return -1;
+	}
+	fflush(stdout);
+	fflush(stderr);
+
+	pid = fork();
+	if (pid < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		return -1;
+	}
+	if (0 == pid) {
+		close(fds[0]);
+		status = work(job);
+		if (0 == status && sizeof(job_t) != write(fds[1], job, sizeof(job_t))) {
+			status = -1;
+		}
+		_exit((0 == status) ? 0 : 1);
+	}
+
+	close(fds[1]);
+	got = read(fds[0], job, sizeof(job_t));
+	close(fds[0]);
+	if (pid != wait4(pid, &status, 0, &usage)) {
+		return -1;
+	}
+	*peak_kb = usage.ru_maxrss;
+
+	return (sizeof(job_t) == got && WIFEXITED(status) && 0 == WEXITSTATUS(status)) ? 0 : -1;
+}
+
+/****************************************************************
+ * Summary: Loads the dictionary and rewrites the text with one *
+ *          backend, in the child. The output goes to           *
+ *          job->out_path, except a batch rewrites in place.    *
+ *                                                              *
+ * Parameters: job - The job, receives the times.               *
+ *                                                              *
+ * Returns: 0 if successful, otherwise -1.                      *
+ ****************************************************************/
+static int run_backend(job_t *job)
+{
+	int rc = 0;
+	int fd = -1;
+	int flags = REWRITE_TO_STDOUT;
+	double start = 0;
+	char *paths[1];
+	dictionary_t *dictionary = NULL;
+
+	if (BACKEND_BATCH != job->backend) {
+		fd = open(job->out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0 || dup2(fd, STDOUT_FILENO) < 0) {
+			return -1;
+		}
+		close(fd);
+	}
+
+	start = now_ms();
+	dictionary = open_dictionary(job->dictionary_path, job->threads, NULL);
+	job->load_ms = now_ms() - start;
+	if (NULL == dictionary) {
+		return -1;
+	}
+
+	start = now_ms();
+	switch (job->backend) {
+	case BACKEND_ZERO_COPY:
+		flags |= REWRITE_ZERO_COPY;
+		rc = rewrite_file(job->text_path, dictionary, flags, job->threads);
+		break;
+	case BACKEND_BATCH:
+		paths[0] = (char *)job->text_path;
+		rc = batch_rewrite(dictionary, paths, 1, 0, job->threads, NULL);
+		break;
+	default:
+		rc = rewrite_file(job->text_path, dictionary, flags, job->threads);
+		break;
+	}
+	if (0 != fflush(stdout)) {
+		rc = -1;
+	}
+	job->rewrite_ms = now_ms() - start;
+
+	destroy_dictionary(dictionary);
+
+	return (0 == rc) ? 0 : -1;
+}
+
+/* Compiles job->dictionary_path to job->out_path, in the child */
+static int run_compile(job_t *job)
+{
+	int rc = 0;
+	dictionary_t *dictionary = open_dictionary(job->dictionary_path, 0, NULL);
+
+	if (NULL == dictionary) {
+		return -1;
+	}
+	rc = compile_dictionary(dictionary, job->out_path);
+	destroy_dictionary(dictionary);
+
+	return (0 == rc) ? 0 : -1;
+}
+
+/* Rewrites job->text_path to job->out_path as the original did, in the child */
+static int run_reference(job_t *job)
+{
+	double start = now_ms();
+	int rc = vocabref_rewrite(job->dictionary_path, job->text_path, job->out_path);
+
+	job->rewrite_ms = now_ms() - start;
+
+	return (0 == rc) ? 0 : -1;
+}
+
+/****************************************************************
+ * Summary: Rewrites every part of a batch with the reference,  *
+ *          as the batch rewrites every file on its own.        *
+ *                                                              *
+ * Parameters: parts_path - The directory of the parts.         *
+ *             dictionary_path - The dictionary file.           *
+ *             expected_path - The prefix of the rewritten      *
+ *                             parts.                           *
+ *                                                              *
+ * Returns: 0 if successful, otherwise -1.                      *
+ ****************************************************************/
+static int expect_batch(const char *parts_path, const char *dictionary_path, const char *expected_path)
+{
+	int part = 0;
+	long peak_kb = 0;
+	char path[MAX_PATH];
+	char expected[MAX_PATH];
+	job_t job;
+
+	for (part = 0 ; part < BATCH_PARTS ; ++part) {
+		if (MAX_PATH <= snprintf(path, MAX_PATH, "%s/part-%03d.txt", parts_path, part) ||
+			MAX_PATH <= snprintf(expected, MAX_PATH, "%s-%03d", expected_path, part)) {
+			return -1;
+		}
+		memset(&job, 0, sizeof(job));
+		job.dictionary_path = dictionary_path;
+		job.text_path = path;
+		job.out_path = expected;
+		if (0 != in_child(run_reference, &job, &peak_kb)) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* Compares the parts a batch rewrote to the reference's, returns 0 if the same */
+static int check_batch(const char *batch_path, const char *expected_path)
+{
+	int part = 0;
+	char path[MAX_PATH];
+	char expected[MAX_PATH];
+
+	for (part = 0 ; part < BATCH_PARTS ; ++part) {
+		if (MAX_PATH <= snprintf(path, MAX_PATH, "%s/part-%03d.txt", batch_path, part) ||
+			MAX_PATH <= snprintf(expected, MAX_PATH, "%s-%03d", expected_path, part)) {
+			return -1;
+		}
+		if (1 != same_files(path, expected)) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* Tells if two files have the same bytes: 1 if so, 0 if not, -1 if unreadable */
+static int same_files(const char *a, const char *b)
+{
+	int rc = 1;
+	size_t size_a = 0, size_b = 0;
+	char buffer_a[COMPARE_BUFFER];
+	char buffer_b[COMPARE_BUFFER];
+	FILE *fp_a = fopen(a, "rb");
+	FILE *fp_b = fopen(b, "rb");
+
+	if (NULL == fp_a || NULL == fp_b) {
+		rc = -1;
+	}
+	while (1 == rc) {
+		size_a = fread(buffer_a, 1, sizeof(buffer_a), fp_a);
+		size_b = fread(buffer_b, 1, sizeof(buffer_b), fp_b);
+		if (size_a != size_b || 0 != memcmp(buffer_a, buffer_b, size_a)) {
+			rc = 0;
+		} else if (0 == size_a) {
+			break;
+		}
+	}
+	if (NULL != fp_a) {
+		fclose(fp_a);
+	}
+	if (NULL != fp_b) {
+		fclose(fp_b);
+	}
+
+	return rc;
+}
+
+/****************************************************************
+ * Summary: Prints the result of a run as a table row, or as    *
+ *          one JSON object per line.                           *
+ *                                                              *
+ * Parameters: config - The benchmark configuration.            *
+ *             words - The headwords of the dictionary.         *
+ *             megabytes - The size of the text.                *
+ *             job - The run.                                   *
+ *             peak_kb - The peak resident size of the run.     *
+ *             check - "ok", "differs", or "-" if not checked.  *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+static void print_run(const config_t *config, long words, double megabytes, const job_t *job, long peak_kb,
+					  const char *check)
+{
+	double mb_per_s = (job->rewrite_ms > 0) ? megabytes * 1000.0 / job->rewrite_ms : 0;
+
+	if (config->json) {
+		printf("{\"words\":%ld,\"megabytes\":%g,\"hit_rate\":%g,\"zipf\":%g,\"seed\":%u,"
+			   "\"backend\":\"%s\",\"threads\":%d,\"load_ms\":%.3f,\"rewrite_ms\":%.3f,"
+			   "\"mb_per_s\":%.3f,\"peak_rss_kb\":%ld,\"check\":\"%s\"}\n",
+			   words, megabytes, config->gen.hit_rate, config->gen.zipf, config->gen.seed,
+			   backend_names[job->backend], job->threads, job->load_ms, job->rewrite_ms,
+			   mb_per_s, peak_kb, check);
+	} else {
+		printf("%10ld %8g %-10s %4d %10.2f %10.2f %10.2f %10ld  %s\n", words, megabytes,
+			   backend_names[job->backend], job->threads, job->load_ms, job->rewrite_ms,
+			   mb_per_s, peak_kb, check);
+	}
+	fflush(stdout);
+}
+
+/* Parses a comma separated list of sizes, returns how many, -1 if bad */
+static int parse_words(const char *text, long *values)
+{
+	int count = 0;
+	char *end = NULL;
+
+	while (count < MAX_SIZES) {
+		values[count] = strtol(text, &end, 10);
+		if (end == text || values[count] < 1) {
+			return -1;
+		}
+		++count;
+		if (',' != *end) {
+			return ('\0' == *end) ? count : -1;
+		}
+		text = end + 1;
+	}
+
+	return -1;
+}
+
+static int parse_megabytes(const char *text, double *values)
+{
+	int count = 0;
+	char *end = NULL;
+
+	while (count < MAX_SIZES) {
+		values[count] = strtod(text, &end);
+		if (end == text || values[count] <= 0) {
+			return -1;
+		}
+		++count;
+		if (',' != *end) {
+			return ('\0' == *end) ? count : -1;
+		}
+		text = end + 1;
+	}
+
+	return -1;
+}
+
+/* Parses a comma separated list of backend names to a bit mask, 0 if bad */
+static int parse_backends(const char *text)
+{
+	int b = 0;
+	int backends = 0;
+	size_t length = 0;
+
+	while ('\0' != *text) {
+		length = strcspn(text, ",");
+		for (b = 0 ; b < BACKENDS ; ++b) {
+			if (length == strlen(backend_names[b]) && 0 == strncmp(text, backend_names[b], length)) {
+				break;
+			}
+		}
+		if (BACKENDS == b) {
+			return 0;
+		}
+		backends |= 1 << b;
+		text += length;
+		if (',' == *text) {
+			++text;
+		}
+	}
+
+	return backends;
+}
+
+static double now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+/****************************************************************
+ * Summary: Prints the usage.                                   *
+ *                                                              *
+ * Parameters: name - The name of the program.                  *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+static void usage(const char *name)
+{
+	printf("Usage: %s [options] work_dir\n"
+		   "       %s [options] --dictionary dictionary_file [--corpus text_file]\n"
+		   "       %s [options] --corpus text_file\n"
+		   "Options:\n"
+		   "  -w words,...     headwords of the dictionaries (default %s)\n"
+		   "  -m megabytes,... sizes of the texts (default %s)\n"
+		   "  -b backends      some of stream,zero-copy,parallel,compiled,batch\n"
+		   "                   (default all)\n"
+		   "  -j threads       threads of the parallel and batch backends (default %d)\n"
+		   "  --synonyms a,b   synonyms of a headword, from a to b, at most %d\n"
+		   "                   (default %d,%d)\n"
+		   "  --hit rate       share of the text words in the dictionary (default %g)\n"
+		   "  --zipf s         exponent of the word frequencies, 0 for uniform\n"
+		   "                   (default %g)\n"
+		   "  --seed seed      random seed, not 0\n"
+		   "  --check          compare every output to the original implementation's\n"
+		   "  --json           print one JSON object per run\n"
+		   "Only the first -w and -m are used to generate a single file.\n",
+		   name, name, name, DEFAULT_WORDS, DEFAULT_MEGABYTES, DEFAULT_THREADS, VOCABGEN_MAX_SYNONYMS,
+		   DEFAULT_SYNONYMS, DEFAULT_MAX_SYNONYMS, DEFAULT_HIT_RATE, DEFAULT_ZIPF);
+}
@@ -0,0 +1,263 @@
+/****************************************************************
+ * Summary: This library generates dictionaries and texts to    *
+ *          benchmark LimitedVocabulary with, from a seed.      *
+ *                                                              *
+ *          Headwords and the words missing from the dictionary *
+ *          are numbered and spelled in base 26 with letters    *
+ *          shuffled by the seed, so they never collide. Text   *
+ *          words are drawn with Zipfian frequencies, a given   *
+ *          share of them from the headwords.                   *
+ ****************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "harness.h"
+#include "vocabgen.h"
+
+#define LETTERS				(26)
+#define MAX_WORD			(16)
+#define FIRST_NUMBER		(703)	/* the first number spelled with 3 letters */
+#define MIN_MISSES			(1000)	/* words missing from the dictionary, at least */
+#define MIN_SYNONYM			(3)		/* letters of a synonym */
+#define MAX_SYNONYM			(9)
+#define MIN_SENTENCE		(4)		/* words of a sentence */
+#define MAX_SENTENCE		(20)
+#define SENTENCES_PER_LINE	(4)
+
+typedef struct vocabgen_rec {
+	char letters[LETTERS];	/* the digits words are spelled with */
+	unsigned int rng;
+} vocabgen_t;
+
+static void vocabgen_init(vocabgen_t *gen, unsigned int seed, unsigned int stream);
+static int spell(const vocabgen_t *gen, long index, char *word);
+static double * zipf_table(long count, double exponent);
+static long zipf_draw(const double *table, long count, double u);
+static double uniform(unsigned int *rng);
+
+/****************************************************************
+ * Summary: Writes a dictionary of params->words headwords,     *
+ *          each with min to max random synonyms.               *
+ *                                                              *
+ * Parameters: out - The stream to write to.                    *
+ *             params - What to generate.                       *
+ *                                                              *
+ * Returns: 0 if successful, otherwise VOCABGEN_CANNOT_WRITE.   *
+ ****************************************************************/
+int vocabgen_dictionary(FILE *out, const vocabgen_params_t *params)
+{
+	long i = 0;
+	int s = 0, j = 0;
+	int count = 0;
+	int length = 0;
+	unsigned int spread = (unsigned int)(params->max_synonyms - params->min_synonyms + 1);
+	char word[MAX_WORD];
+	vocabgen_t gen;
+
+	vocabgen_init(&gen, params->seed, 1);
+	for (i = 0 ; i < params->words ; ++i) {
+		spell(&gen, i, word);
+		fputs(word, out);
+
+		count = params->min_synonyms + (int)(bench_rand(&gen.rng) % spread);
+		for (s = 0 ; s < count ; ++s) {
+			length = MIN_SYNONYM + (int)(bench_rand(&gen.rng) % (MAX_SYNONYM - MIN_SYNONYM + 1));
+			for (j = 0 ; j < length ; ++j) {
+				word[j] = (char)('a' + bench_rand(&gen.rng) % LETTERS);
+			}
+			word[length] = '\0';
+			fputc(' ', out);
+			fputs(word, out);
+		}
+		fputc('\n', out);
+	}
+
+	return ferror(out) ? VOCABGEN_CANNOT_WRITE : 0;
+}
+
+/****************************************************************
+ * Summary: Writes a text of sentences, where a share           *
+ *          params->hit_rate of the words are headwords of the  *
+ *          dictionary generated with the same parameters.      *
+ *          Sentences start with a capital, and a few words are *
+ *          in capitals.                                        *
+ *                                                              *
+ * Parameters: out - The stream to write to.                    *
+ *             bytes - The size of the text, it ends with the   *
+ *                     sentence that reaches it.                *
+ *             params - What to generate.                       *
+ *                                                              *
+ * Returns: 0 if successful, otherwise                          *
+ *          VOCABGEN_NOT_ENOUGH_MEMORY or VOCABGEN_CANNOT_WRITE.*
+ ****************************************************************/
+int vocabgen_corpus(FILE *out, long long bytes, const vocabgen_params_t *params)
+{
+	int w = 0, j = 0;
+	int length = 0;
+	int size = 0;
+	long index = 0;
+	long sentences = 0;
+	long long written = 0;
+	long misses = (params->words > MIN_MISSES) ? params->words : MIN_MISSES;
+	double *hit_table = NULL;
+	double *miss_table = NULL;
+	char word[MAX_WORD];
+	vocabgen_t gen;
+
+	/* Allocate memory */
+	hit_table = zipf_table(params->words, params->zipf);
+	miss_table = zipf_table(misses, params->zipf);
+	if (NULL == hit_table || NULL == miss_table) {
+		free(hit_table);
+		free(miss_table);
+		return VOCABGEN_NOT_ENOUGH_MEMORY;
+	}
+
+	vocabgen_init(&gen, params->seed, 2);
+	while (written < bytes) {
+		length = MIN_SENTENCE + (int)(bench_rand(&gen.rng) % (MAX_SENTENCE - MIN_SENTENCE + 1));
+		for (w = 0 ; w < length ; ++w) {
+			if (uniform(&gen.rng) < params->hit_rate) {
+				index = zipf_draw(hit_table, params->words, uniform(&gen.rng));
+			} else {
+				index = params->words + zipf_draw(miss_table, misses, uniform(&gen.rng));
+			}
+			size = spell(&gen, index, word);
+
+			if (0 == w) {
+				word[0] = (char)(word[0] - 'a' + 'A');
+			} else if (0 == bench_rand(&gen.rng) % 50) {
+				for (j = 0 ; j < size ; ++j) {
+					word[j] = (char)(word[j] - 'a' + 'A');
+				}
+			}
+
+			if (0 != w) {
+				fputc(' ', out);
+				++written;
+			}
+			fputs(word, out);
+			written += size;
+			if (w + 1 < length && 0 == bench_rand(&gen.rng) % 10) {
+				fputc(',', out);
+				++written;
+			}
+		}
+
+		++sentences;
+		fputc('.', out);
+		fputc((0 == sentences % SENTENCES_PER_LINE || written + 2 >= bytes) ? '\n' : ' ', out);
+		written += 2;
+	}
+
+	/* Free memory */
+	free(hit_table);
+	free(miss_table);
+
+	return ferror(out) ? VOCABGEN_CANNOT_WRITE : 0;
+}
+
+/* Shuffles the letters by the seed alone, and starts a random stream */
+static void vocabgen_init(vocabgen_t *gen, unsigned int seed, unsigned int stream)
+{
+	int i = 0, j = 0;
+	char letter = 0;
+
+	gen->rng = seed;
+	for (i = 0 ; i < LETTERS ; ++i) {
+		gen->letters[i] = (char)('a' + i);
+	}
+	for (i = LETTERS - 1 ; i > 0 ; --i) {
+		j = (int)(bench_rand(&gen->rng) % (unsigned int)(i + 1));
+		letter = gen->letters[i];
+		gen->letters[i] = gen->letters[j];
+		gen->letters[j] = letter;
+	}
+
+	gen->rng = seed ^ (stream * 0x9e3779b9u);
+	if (0 == gen->rng) {
+		gen->rng = stream;
+	}
+}
+
+/* Spells the number of a word in bijective base 26, returns its length */
+static int spell(const vocabgen_t *gen, long index, char *word)
+{
+	int i = 0;
+	int length = 0;
+	char letter = 0;
+	unsigned long number = (unsigned long)index + FIRST_NUMBER;
+
+	while (0 != number) {
+		--number;
+		word[length] = gen->letters[number % LETTERS];
+		number /= LETTERS;
+		++length;
+	}
+	word[length] = '\0';
+
+	for (i = 0 ; i < length / 2 ; ++i) {
+		letter = word[i];
+		word[i] = word[length - 1 - i];
+		word[length - 1 - i] = letter;
+	}
+
+	return length;
+}
+
+/****************************************************************
+ * Summary: Builds the cumulative Zipf distribution of count    *
+ *          ranks, where rank k is drawn in proportion to       *
+ *          1 / k^exponent.                                     *
+ *                                                              *
+ * Parameters: count - The amount of ranks, at least 1.         *
+ *             exponent - The exponent, 0 for uniform.          *
+ *                                                              *
+ * Returns: The table if successful, otherwise NULL.            *
+ ****************************************************************/
+static double * zipf_table(long count, double exponent)
+{
+	long i = 0;
+	double total = 0;
+	double *table = (double *)malloc(sizeof(double) * count);
+
+	if (NULL == table) {
+		return NULL;
+	}
+
+	for (i = 0 ; i < count ; ++i) {
+		total += pow((double)(i + 1), -exponent);
+		table[i] = total;
+	}
+	for (i = 0 ; i < count ; ++i) {
+		table[i] /= total;
+	}
+
+	return table;
+}
+
+/* Finds the first rank whose cumulative share is above u */
+static long zipf_draw(const double *table, long count, double u)
+{
+	long low = 0;
+	long high = count - 1;
+	long middle = 0;
+
+	while (low < high) {
+		middle = low + (high - low) / 2;
+		if (table[middle] > u) {
+			high = middle;
+		} else {
+			low = middle + 1;
+		}
+	}
+
+	return low;
+}
+
+/* A number from 0 up to, not including, 1 */
+static double uniform(unsigned int *rng)
+{
+	return (double)bench_rand(rng) / 4294967296.0;
+}
@@ -0,0 +1,26 @@
+#if !defined(_VOCABGEN_H_)
+#define _VOCABGEN_H_
+
+#include <stdio.h>
+
+#define VOCABGEN_NOT_ENOUGH_MEMORY	(-1)
+#define VOCABGEN_CANNOT_WRITE		(-2)
+
+/* Most synonyms of a headword, so a line stays within DICTIONARY_MAX_LINE */
+#define VOCABGEN_MAX_SYNONYMS		(20)
+
+/* What to generate. The same parameters always give the same files. */
+typedef struct vocabgen_params_rec {
+	long words;			/* headwords in the dictionary */
+	int min_synonyms;	/* synonyms of every headword, from min to max */
+	int max_synonyms;
+	double hit_rate;	/* share of the corpus words that are headwords */
+	double zipf;		/* exponent of the word frequencies, 0 for uniform */
+	unsigned int seed;	/* not 0 */
+} vocabgen_params_t;
+
+int vocabgen_dictionary(FILE *out, const vocabgen_params_t *params);
+
+int vocabgen_corpus(FILE *out, long long bytes, const vocabgen_params_t *params);
+
+#endif
@@ -0,0 +1,313 @@
+/****************************************************************
+ * Summary: This library rewrites a text the way the original   *
+ *          LimitedVocabulary program did, to check the faster  *
+ *          implementations against: every run of letters is    *
+ *          lowercased and replaced by the next synonym of its  *
+ *          dictionary line, the synonyms taken first, last,    *
+ *          then backwards to the second. Words are found by    *
+ *          binary search instead of walking a list, so large   *
+ *          dictionaries can be checked, and blank dictionary   *
+ *          lines are skipped where the original failed.        *
+ ****************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "vocabref.h"
+
+#define REF_MAX_LINE	(256)		/* as DICTIONARY_MAX_LINE of the original */
+#define REF_SEPARATOR	(" \n")
+#define REF_BUFFER		(1 << 16)
+
+typedef struct ref_entry_rec {
+	size_t word;		/* offset in the pool */
+	size_t synonyms;	/* index of the first synonym offset */
+	int count;
+	int turn;
+	long line;
+} ref_entry_t;
+
+typedef struct ref_dictionary_rec {
+	char *pool;
+	size_t pool_size;
+	size_t pool_capacity;
+	size_t *synonyms;	/* offsets in the pool */
+	size_t synonym_count;
+	size_t synonym_capacity;
+	ref_entry_t *entries;
+	size_t count;
+	size_t capacity;
+} ref_dictionary_t;
+
+static const char *sort_pool = NULL;
+
+static int load(ref_dictionary_t *dictionary, FILE *fp);
+static int intern(ref_dictionary_t *dictionary, const char *word, size_t *offset);
+static void * grow(void *array, size_t *capacity, size_t needed, size_t item);
+static const char * next_synonym(ref_dictionary_t *dictionary, char *word);
+static int compare_entries(const void *a, const void *b);
+static int compare_key(const void *key, const void *entry);
+static void free_dictionary(ref_dictionary_t *dictionary);
+
+/****************************************************************
+ * Summary: Rewrites a text file to another file.               *
+ *                                                              *
+ * Parameters: dictionary_path - The dictionary file.           *
+ *             in_path - The text to rewrite.                   *
+ *             out_path - Receives the rewritten text.          *
+ *                                                              *
+ * Returns: 0 if successful, otherwise                          *
+ *          VOCABREF_NOT_ENOUGH_MEMORY, VOCABREF_CANNOT_READ or *
+ *          VOCABREF_CANNOT_WRITE.                              *
+ ****************************************************************/
+int vocabref_rewrite(const char *dictionary_path, const char *in_path, const char *out_path)
+{
+	int rc = 0;
+	size_t i = 0;
+	size_t size = 0;
+	size_t length = 0;
+	size_t capacity = 0;
+	char *word = NULL;
+	char *new_word = NULL;
+	char *buffer = NULL;
+	FILE *fp_in = NULL;
+	FILE *fp_out = NULL;
+	ref_dictionary_t dictionary;
+
+	memset(&dictionary, 0, sizeof(dictionary));
+
+	/* Build dictionary */
+	fp_in = fopen(dictionary_path, "r");
+	if (NULL == fp_in) {
+		return VOCABREF_CANNOT_READ;
+	}
+	rc = load(&dictionary, fp_in);
+	fclose(fp_in);
+	if (0 != rc) {
+		free_dictionary(&dictionary);
+		return rc;
+	}
+
+	/* Open files */
+	buffer = (char *)malloc(sizeof(char) * REF_BUFFER);
+	fp_in = fopen(in_path, "rb");
+	fp_out = fopen(out_path, "wb");
+	if (NULL == buffer || NULL == fp_in || NULL == fp_out) {
+		rc = (NULL == buffer) ? VOCABREF_NOT_ENOUGH_MEMORY :
+			 (NULL == fp_in) ? VOCABREF_CANNOT_READ : VOCABREF_CANNOT_WRITE;
+	}
+
+	/* Separate to words, a word ends at the first byte that is not a letter */
+	while (0 == rc && 0 != (size = fread(buffer, 1, REF_BUFFER, fp_in))) {
+		for (i = 0 ; i < size && 0 == rc ; ++i) {
+			if (0 != isalpha((unsigned char)buffer[i])) {
+				new_word = (char *)grow(word, &capacity, length + 2, sizeof(char));
+				if (NULL == new_word) {
+					rc = VOCABREF_NOT_ENOUGH_MEMORY;
+					continue;
+				}
+				word = new_word;
+				word[length] = buffer[i];
+				++length;
+				continue;
+			}
+			if (0 != length) {
+				word[length] = '\0';
+				fputs(next_synonym(&dictionary, word), fp_out);
+				length = 0;
+			}
+			fputc(buffer[i], fp_out);
+		}
+	}
+	if (0 == rc && 0 != length) {
+		word[length] = '\0';
+		fputs(next_synonym(&dictionary, word), fp_out);
+	}
+	if (0 == rc && ferror(fp_in)) {
+		rc = VOCABREF_CANNOT_READ;
+	}
+
+	/* Close files */
+	if (NULL != fp_in) {
+		fclose(fp_in);
+	}
+	if (NULL != fp_out && (0 != fclose(fp_out)) && 0 == rc) {
+		rc = VOCABREF_CANNOT_WRITE;
+	}
+
+	/* Free memory */
+	free(word);
+	free(buffer);
+	free_dictionary(&dictionary);
+
+	return rc;
+}
+
+/****************************************************************
+ * Summary: Reads the dictionary lines, and sorts the entries   *
+ *          by word, keeping the first line of a repeated word. *
+ *                                                              *
+ * Parameters: dictionary - The empty dictionary to fill.       *
+ *             fp - The dictionary file.                        *
+ *                                                              *
+ * Returns: 0 if successful, otherwise                          *
+ *          VOCABREF_NOT_ENOUGH_MEMORY.                         *
+ ****************************************************************/
+static int load(ref_dictionary_t *dictionary, FILE *fp)
+{
+	size_t i = 0, kept = 0;
+	size_t offset = 0;
+	long line = 0;
+	char *token = NULL;
+	char text[REF_MAX_LINE];
+	void *grown = NULL;
+	ref_entry_t *entry = NULL;
+
+	while (NULL != fgets(text, REF_MAX_LINE, fp)) {
+		++line;
+		token = strtok(text, REF_SEPARATOR);
+		if (NULL == token) {
+			continue;
+		}
+
+		grown = grow(dictionary->entries, &dictionary->capacity, dictionary->count + 1, sizeof(ref_entry_t));
+		if (NULL == grown) {
+			return VOCABREF_NOT_ENOUGH_MEMORY;
+		}
+		dictionary->entries = (ref_entry_t *)grown;
+		entry = &dictionary->entries[dictionary->count];
+		for (i = 0 ; '\0' != token[i] ; ++i) {
+			token[i] = (char)tolower((unsigned char)token[i]);
+		}
+		if (0 != intern(dictionary, token, &entry->word)) {
+			return VOCABREF_NOT_ENOUGH_MEMORY;
+		}
+		entry->synonyms = dictionary->synonym_count;
+		entry->count = 0;
+		entry->turn = 0;
+		entry->line = line;
+		++dictionary->count;
+
+		/* Add synonyms */
+		for (token = strtok(NULL, REF_SEPARATOR) ; NULL != token ; token = strtok(NULL, REF_SEPARATOR)) {
+			grown = grow(dictionary->synonyms, &dictionary->synonym_capacity, dictionary->synonym_count + 1,
+						 sizeof(size_t));
+			if (NULL == grown || 0 != intern(dictionary, token, &offset)) {
+				return VOCABREF_NOT_ENOUGH_MEMORY;
+			}
+			dictionary->synonyms = (size_t *)grown;
+			dictionary->synonyms[dictionary->synonym_count] = offset;
+			++dictionary->synonym_count;
+			++entry->count;
+		}
+	}
+
+	sort_pool = dictionary->pool;
+	qsort(dictionary->entries, dictionary->count, sizeof(ref_entry_t), compare_entries);
+	for (i = 0 ; i < dictionary->count ; ++i) {
+		if (0 == kept || 0 != strcmp(dictionary->pool + dictionary->entries[kept - 1].word,
+									 dictionary->pool + dictionary->entries[i].word)) {
+			dictionary->entries[kept] = dictionary->entries[i];
+			++kept;
+		}
+	}
+	dictionary->count = kept;
+
+	return 0;
+}
+
+/* Copies a word to the pool */
+static int intern(ref_dictionary_t *dictionary, const char *word, size_t *offset)
+{
+	size_t length = strlen(word) + 1;
+	char *pool = (char *)grow(dictionary->pool, &dictionary->pool_capacity, dictionary->pool_size + length,
+							  sizeof(char));
+
+	if (NULL == pool) {
+		return VOCABREF_NOT_ENOUGH_MEMORY;
+	}
+	dictionary->pool = pool;
+	memcpy(dictionary->pool + dictionary->pool_size, word, length);
+	*offset = dictionary->pool_size;
+	dictionary->pool_size += length;
+
+	return 0;
+}
+
+/* Makes room for needed items, doubling the capacity, returns NULL if it cannot */
+static void * grow(void *array, size_t *capacity, size_t needed, size_t item)
+{
+	size_t new_capacity = (0 == *capacity) ? 64 : *capacity;
+	void *new_array = NULL;
+
+	if (needed <= *capacity) {
+		return array;
+	}
+	while (new_capacity < needed) {
+		new_capacity *= 2;
+	}
+	new_array = realloc(array, new_capacity * item);
+	if (NULL != new_array) {
+		*capacity = new_capacity;
+	}
+
+	return new_array;
+}
+
+/****************************************************************
+ * Summary: Lowercases a word and takes its next synonym.       *
+ *                                                              *
+ * Parameters: dictionary - The dictionary.                     *
+ *             word - The word, is lowercased in place.         *
+ *                                                              *
+ * Returns: The synonym if found, otherwise the word.           *
+ ****************************************************************/
+static const char * next_synonym(ref_dictionary_t *dictionary, char *word)
+{
+	size_t i = 0;
+	int synonym = 0;
+	ref_entry_t *entry = NULL;
+
+	for (i = 0 ; '\0' != word[i] ; ++i) {
+		word[i] = (char)tolower((unsigned char)word[i]);
+	}
+
+	sort_pool = dictionary->pool;
+	entry = (ref_entry_t *)bsearch(word, dictionary->entries, dictionary->count, sizeof(ref_entry_t),
+								   compare_key);
+	if (NULL == entry || 0 == entry->count) {
+		return word;
+	}
+
+	/* The original added every synonym after the first, so they go round backwards */
+	synonym = (0 == entry->turn) ? 0 : entry->count - entry->turn;
+	entry->turn = (entry->turn + 1) % entry->count;
+
+	return dictionary->pool + dictionary->synonyms[entry->synonyms + synonym];
+}
+
+static int compare_entries(const void *a, const void *b)
+{
+	const ref_entry_t *x = (const ref_entry_t *)a;
+	const ref_entry_t *y = (const ref_entry_t *)b;
+	int order = strcmp(sort_pool + x->word, sort_pool + y->word);
+
+	if (0 != order) {
+		return order;
+	}
+
+	return (x->line > y->line) - (x->line < y->line);
+}
+
+static int compare_key(const void *key, const void *entry)
+{
+	return strcmp((const char *)key, sort_pool + ((const ref_entry_t *)entry)->word);
+}
+
+static void free_dictionary(ref_dictionary_t *dictionary)
+{
+	free(dictionary->pool);
+	free(dictionary->synonyms);
+	free(dictionary->entries);
+}
@@ -0,0 +1,10 @@
+#if !defined(_VOCABREF_H_)
+#define _VOCABREF_H_
+
+#define VOCABREF_NOT_ENOUGH_MEMORY	(-1)
+#define VOCABREF_CANNOT_READ		(-2)
+#define VOCABREF_CANNOT_WRITE		(-3)
+
+int vocabref_rewrite(const char *dictionary_path, const char *in_path, const char *out_path);
+
+#endif
@@ -1,21 +1,38 @@
 /****************************************************************
  * Summary: This program implements the Game of Life.           *
  *                                                              *
+ *          The window shows a view of the world, zoomed out to *
+ *          fit when the world is larger, a character summing   *
+ *          up the block of cells under it. The arrows or WASD  *
+ *          move the view, + and - zoom, and Q or Esc quit.     *
+ *                                                              *
  * Example: game_of_life                                        *
  *          game_of_life world.txt                              *
  ****************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <conio.h>
 #include <windows.h>
+#include "view.h"
 
+#if !defined(WORLD_SIZE)
 #define WORLD_SIZE  (60)
+#endif
 #define SIZEX       WORLD_SIZE
 #define SIZEY       WORLD_SIZE
 #define DEAD        (' ')
 #define ALIVE       ('*')
 #define DELAY       (20)
 #define RAND()      DEAD + ( (ALIVE - DEAD) * (rand() & 0x1) )
+#define WINDOW_ROWS (50)    /* the largest window to ask for */
+#define WINDOW_COLS (120)
+#define KEY_ESCAPE  (27)
+#define KEY_PREFIX  (224)   /* comes before the code of an arrow, or 0 */
+#define KEY_UP      (72)
+#define KEY_DOWN    (80)
+#define KEY_LEFT    (75)
+#define KEY_RIGHT   (77)
 
 #define INVALID_ARGS        (-1)
 #define INVALID_FORMAT      (-2)
@@ -25,25 +42,39 @@
 
 void set_window_size();
 
+void console_size(int *rows, int *cols);
+
 int start_file(char world[SIZEX][SIZEY], char *file_name);
 
 void start_rand(char world[SIZEX][SIZEY]);
 
-int condition(int changed);
+int condition(int changed, view_t *view);
 
 char check_cell(char world[SIZEX][SIZEY], int i, int j);
 
-int step(char before[SIZEX][SIZEY], char after[SIZEX][SIZEY]);
+int step(char before[SIZEX][SIZEY], char after[SIZEX][SIZEY], view_t *view);
 
-void print(char world[SIZEX][SIZEY]);
+void print(char world[SIZEX][SIZEY], view_t *view, long generation);
 
 static HANDLE wHnd = NULL;    /* Handle to change window size */
+static char *screen = NULL;   /* The last frame rendered */
+static size_t screen_size = 0;
 
 int main(int argc, char *argv[])
 {
 	int current = 0;
 	int changed = 0;
-	char world[2][SIZEX][SIZEY];
+	int rows = 0, cols = 0;
+	long generation = 0;
+	char (*world)[SIZEX][SIZEY] = NULL;
+	view_t *view = NULL;
+
+	/* Allocate memory, the world can be larger than the stack */
+	world = (char (*)[SIZEX][SIZEY])malloc(sizeof(char) * 2 * SIZEX * SIZEY);
+	if (NULL == world) {
+		printf("Not enough memory for a %d" "x" "%d world.\n", SIZEX, SIZEY);
+		return NOT_ENOUGH_MEMORY;
+	}
 
 	/* Check args */
 	if (1 == argc) {
@@ -54,25 +85,34 @@ int main(int argc, char *argv[])
 		switch(start_file(world[0], argv[1]))
 		{
 		case INVALID_FORMAT:/* File is in incorrect format. */
+			free(world);
 			printf("Invalid file format.\n"
 				"The file must contain %d lines with %d characters in each row.\n"
 				"The characters can only be '%c' for living cells OR '%c' for dead cells.\n",
 				SIZEX, SIZEY, ALIVE, DEAD);
 			return INVALID_FORMAT;
 		case FAILED_TO_OPEN:/* Cannot open file. */
+			free(world);
 			printf("Could not open \"%s\"", argv[1]);
 			return FAILED_TO_OPEN;
 		case FAILED_TO_CLOSE:/* Cannot close file. */
+			free(world);
 			printf("Could not close \"%s\"", argv[1]);
 			return FAILED_TO_CLOSE;
+		case NOT_ENOUGH_MEMORY:/* Cannot read the file. */
+			free(world);
+			printf("Not enough memory to read \"%s\"", argv[1]);
+			return NOT_ENOUGH_MEMORY;
 		default:/* All is well */
 			break;
 		}
 	} else {
 		/* Too many extra args - invalid use. */
+		free(world);
 		printf("Usage:\n"
 			" %s\t" "start with a random board.\n"
-			" %s file_name\t" "read %d" "x" "%d board from file.\n",
+			" %s file_name\t" "read %d" "x" "%d board from file.\n"
+			"Arrows or WASD move the view, + and - zoom, Q or Esc quit.\n",
 			argv[0], argv[0], SIZEX, SIZEY);
 		return INVALID_ARGS;
 	}
@@ -83,29 +123,46 @@ int main(int argc, char *argv[])
 	/* Make console window big enough */
 	set_window_size();
 
+	/* Count the world, and show all of it */
+	view = view_create(&world[0][0][0], SIZEX, SIZEY, ALIVE);
+	if (NULL == view) {
+		free(world);
+		printf("Not enough memory for a %d" "x" "%d world.\n", SIZEX, SIZEY);
+		return NOT_ENOUGH_MEMORY;
+	}
+	console_size(&rows, &cols);
+	view_fit(view, rows, cols);
+
 	/* Clear screen */
 	system("cls");
 
 	/* step */
-	while (0 != condition(changed)) {
+	while (0 != condition(changed, view)) {
 		/* Show the world */
-		print(world[current]);
+		print(world[current], view, generation);
 		/* Next step */
-		changed = step(world[current], world[!current]);
+		changed = step(world[current], world[!current], view);
+		view_update(view, &world[!current][0][0]);
 
 		current = !current;
+		++generation;
 
 		Sleep(DELAY);
 	}
 	/* Show the last world */
-	print(world[current]);
+	print(world[current], view, generation);
+
+	/* Free memory */
+	view_destroy(view);
+	free(screen);
+	free(world);
 
 	return 0;
 }
 
 /****************************************************************
  * Summary: Sets the size of the window to match the size of    *
- *          the world.                                          *
+ *          the world, up to WINDOW_ROWS x WINDOW_COLS.         *
  *                                                              *
  * Parameters: None.                                            *
  *                                                              *
@@ -113,12 +170,41 @@ int main(int argc, char *argv[])
  ****************************************************************/
 void set_window_size()
 {
-	SMALL_RECT windowSize = {0, 0, SIZEX + 1, SIZEY + 1};
+	SMALL_RECT windowSize = {0, 0, ((SIZEY < WINDOW_COLS) ? SIZEY : WINDOW_COLS) + 1,
+							 ((SIZEX < WINDOW_ROWS) ? SIZEX : WINDOW_ROWS) + 1};
 
 	wHnd = GetStdHandle(STD_OUTPUT_HANDLE);
     SetConsoleWindowInfo(wHnd, 1, &windowSize);
 }
 
+/****************************************************************
+ * Summary: Gets the size of the window to show the world in,   *
+ *          keeping the last row for the status line and the    *
+ *          last column empty, so lines do not wrap.            *
+ *                                                              *
+ * Parameters: rows - Receives the rows.                        *
+ *             cols - Receives the columns.                     *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void console_size(int *rows, int *cols)
+{
+	CONSOLE_SCREEN_BUFFER_INFO info;
+
+	*rows = (SIZEX < WINDOW_ROWS) ? SIZEX : WINDOW_ROWS;
+	*cols = (SIZEY < WINDOW_COLS) ? SIZEY : WINDOW_COLS;
+	if (0 != GetConsoleScreenBufferInfo(wHnd, &info)) {
+		*rows = info.srWindow.Bottom - info.srWindow.Top;
+		*cols = info.srWindow.Right - info.srWindow.Left;
+	}
+	if (*rows < 1) {
+		*rows = 1;
+	}
+	if (*cols < 1) {
+		*cols = 1;
+	}
+}
+
 /****************************************************************
  * Summary: Initializes the world using input from a file.      *
  *                                                              *
@@ -198,16 +284,63 @@ void start_rand(char world[SIZEX][SIZEY])
 }
 
 /****************************************************************
- * Summary: Checks the condition whether to continue or stop.   *
+ * Summary: Checks the condition whether to continue or stop,   *
+ *          moving or zooming the view by the keys pressed.     *
  *                                                              *
  * Parameters: changed - 1 if the world changed in the last     *
  *                       step, 0 if it didn't.                  *
+ *             view - The view of the world.                    *
  *                                                              *
  * Returns: Non-0 if condition exists, otherwise 0.             *
  ****************************************************************/
-int condition(int changed)
+int condition(int changed, view_t *view)
 {
-	return ( (0 != changed) && (0 == _kbhit()) );
+	int key = 0;
+	int rows = (*view).screen_rows / 4 + 1; /* a quarter of the screen */
+	int cols = (*view).screen_cols / 4 + 1;
+
+	while (0 != _kbhit()) {
+		key = _getch();
+		/* Arrows are two keys, the second one tells which */
+		if (0 == key || KEY_PREFIX == key) {
+			switch (_getch())
+			{
+			case KEY_UP:	key = 'w'; break;
+			case KEY_DOWN:	key = 's'; break;
+			case KEY_LEFT:	key = 'a'; break;
+			case KEY_RIGHT:	key = 'd'; break;
+			default:		key = 0; break;
+			}
+		}
+
+		switch (key)
+		{
+		case 'w': case 'W':
+			view_pan(view, -rows, 0);
+			break;
+		case 's': case 'S':
+			view_pan(view, rows, 0);
+			break;
+		case 'a': case 'A':
+			view_pan(view, 0, -cols);
+			break;
+		case 'd': case 'D':
+			view_pan(view, 0, cols);
+			break;
+		case '+': case '=':
+			view_zoom(view, -1);
+			break;
+		case '-': case '_':
+			view_zoom(view, 1);
+			break;
+		case 'q': case 'Q': case KEY_ESCAPE:
+			return 0;
+		default:/* Not a key of ours */
+			break;
+		}
+	}
+
+	return (0 != changed);
 }
 
 /****************************************************************
@@ -260,10 +393,12 @@ char check_cell(char world[SIZEX][SIZEY], int row, int col)
  * Parameters: before - Represents the world before the step.   *
  *             after - Will have its values set to the world on *
  *                     next step.                               *
+ *             view - Gets the tile of every changed cell       *
+ *                    marked.                                   *
  *                                                              *
  * Returns: 1 if the world has changed, 0 if not.               *
  ****************************************************************/
-int step(char before[SIZEX][SIZEY], char after[SIZEX][SIZEY])
+int step(char before[SIZEX][SIZEY], char after[SIZEX][SIZEY], view_t *view)
 {
 	int changed = 0;
 	int i = 0, j = 0; /* Loop variables */
@@ -273,7 +408,10 @@ int step(char before[SIZEX][SIZEY], char after[SIZEX][SIZEY])
 		for (j = 0 ; j < SIZEY ; ++j) {
 			after[i][j] = check_cell(before, i, j);
 			/* Remember change */
-			changed |= (after[i][j] != before[i][j]);
+			if (after[i][j] != before[i][j]) {
+				changed = 1;
+				view_mark(view, i, j);
+			}
 		}
 	}
 
@@ -281,23 +419,41 @@ int step(char before[SIZEX][SIZEY], char after[SIZEX][SIZEY])
 }
 
 /****************************************************************
- * Summary: Prints the world.                                   *
+ * Summary: Prints the view of the world that fits the window,  *
+ *          and a status line under it.                         *
  *                                                              *
  * Parameters: world - Represents the world.                    *
+ *             view - The view of the world.                    *
+ *             generation - The steps taken so far.             *
  *                                                              *
  * Returns: void.                                               *
  ****************************************************************/
-void print(char world[SIZEX][SIZEY])
+void print(char world[SIZEX][SIZEY], view_t *view, long generation)
 {
-	int i = 0, j = 0; /* Loop variables */
+	int rows = 0, cols = 0;
+	size_t needed = 0;
+	char *new_screen = NULL;
+	char status[128];
 	COORD posZero = {0, 0};
-	
-	SetConsoleCursorPosition(wHnd, posZero);
-	
-	for (i = 0 ; i < SIZEX ; ++i) {
-		for (j = 0 ; j < SIZEY ; ++j) {
-			printf("%c", world[i][j]);
+
+	/* The window may have been resized */
+	console_size(&rows, &cols);
+	needed = (size_t)rows * (cols + 1);
+	if (needed > screen_size) {
+		new_screen = (char *)realloc(screen, needed);
+		if (NULL == new_screen) {
+			return;
 		}
-		printf("\n");
+		screen = new_screen;
+		screen_size = needed;
 	}
+
+	SetConsoleCursorPosition(wHnd, posZero);
+
+	/* A frame is written at once, its size is the window's, not the world's */
+	fwrite(screen, 1, view_render(view, &world[0][0], screen, rows, cols), stdout);
+	sprintf(status, "gen %ld  zoom 1:%d  at %d,%d  arrows/WASD move  +/- zoom  Q quit",
+			generation, 1 << (*view).zoom, (*view).top, (*view).left);
+	printf("%-*.*s", cols, cols, status);
+	fflush(stdout);
 }
\ No newline at end of file
@@ -0,0 +1,339 @@
+/****************************************************************
+ * Summary: Shows a region of a board that can be far larger    *
+ *          than the screen. Zoomed out, every character sums   *
+ *          up the live cells of the block under it with a ramp *
+ *          of characters from empty to full.                   *
+ *                                                              *
+ *          The live cells of every tile of VIEW_TILE cells a   *
+ *          side are counted, and every level above sums 2x2    *
+ *          blocks of the level below, up to a single block for *
+ *          the whole board. A step marks the tiles it changed, *
+ *          and only those are counted again, the difference    *
+ *          added up the levels. A character is read from one   *
+ *          level, or counted from less than a tile of cells    *
+ *          when zoomed in, so a frame costs the size of the    *
+ *          screen whatever the size of the board.              *
+ ****************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "view.h"
+
+static int count_cells(view_t *view, const char *world, int top, int left, int side);
+
+static int align(long long value, int limit, int zoom);
+
+/****************************************************************
+ * Summary: Creates the view of a board, counting every tile.   *
+ *          The whole board is shown from the top left.         *
+ *                                                              *
+ * Parameters: world - The board, rows of cols cells.           *
+ *             rows - The rows of the board.                    *
+ *             cols - The columns of the board.                 *
+ *             alive - The character of a living cell.          *
+ *                                                              *
+ * Returns: The view if successful, otherwise NULL.             *
+ ****************************************************************/
+view_t * view_create(const char *world, int rows, int cols, char alive)
+{
+	int level = 0;
+	int r = 0, c = 0;
+	size_t tiles = 0;
+	view_t *view = NULL;
+
+	/* Allocate memory */
+	view = (view_t *)calloc(1, sizeof(view_t));
+	if (NULL == view) {
+		return NULL;
+	}
+	(*view).rows = rows;
+	(*view).cols = cols;
+	(*view).alive = alive;
+
+	/* Every level halves the one below, up to a single block */
+	(*view).level_rows[0] = (rows + VIEW_TILE - 1) >> VIEW_TILE_SHIFT;
+	(*view).level_cols[0] = (cols + VIEW_TILE - 1) >> VIEW_TILE_SHIFT;
+	for (level = 0 ; level < VIEW_MAX_LEVELS ; ++level) {
+		if (0 != level) {
+			(*view).level_rows[level] = ((*view).level_rows[level - 1] + 1) / 2;
+			(*view).level_cols[level] = ((*view).level_cols[level - 1] + 1) / 2;
+		}
+		(*view).counts[level] = (int *)calloc((size_t)(*view).level_rows[level] * (*view).level_cols[level],
+											  sizeof(int));
+		if (NULL == (*view).counts[level]) {
+			view_destroy(view);
+			return NULL;
+		}
+		(*view).levels = level + 1;
+		if (1 == (*view).level_rows[level] && 1 == (*view).level_cols[level]) {
+			break;
+		}
+	}
+
+	tiles = (size_t)(*view).level_rows[0] * (*view).level_cols[0];
+	(*view).dirty = (int *)malloc(sizeof(int) * tiles);
+	(*view).is_dirty = (unsigned char *)calloc(tiles, sizeof(unsigned char));
+	if (NULL == (*view).dirty || NULL == (*view).is_dirty) {
+		view_destroy(view);
+		return NULL;
+	}
+
+	/* Count every tile once */
+	for (r = 0 ; r < (*view).level_rows[0] ; ++r) {
+		for (c = 0 ; c < (*view).level_cols[0] ; ++c) {
+			view_mark(view, r << VIEW_TILE_SHIFT, c << VIEW_TILE_SHIFT);
+		}
+	}
+	view_update(view, world);
+
+	return view;
+}
+
+/****************************************************************
+ * Summary: Destroys a view.                                    *
+ *                                                              *
+ * Parameters: view - The view.                                 *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void view_destroy(view_t *view)
+{
+	int level = 0;
+
+	for (level = 0 ; level < VIEW_MAX_LEVELS ; ++level) {
+		free((*view).counts[level]);
+	}
+	free((*view).dirty);
+	free((*view).is_dirty);
+	free(view);
+}
+
+/****************************************************************
+ * Summary: Marks the tile of a cell that changed, to be        *
+ *          counted again by the next view_update.              *
+ *                                                              *
+ * Parameters: view - The view.                                 *
+ *             row - The row of the cell.                       *
+ *             col - The column of the cell.                    *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void view_mark(view_t *view, int row, int col)
+{
+	int tile = (row >> VIEW_TILE_SHIFT) * (*view).level_cols[0] + (col >> VIEW_TILE_SHIFT);
+
+	if (0 == (*view).is_dirty[tile]) {
+		(*view).is_dirty[tile] = 1;
+		(*view).dirty[(*view).dirty_count] = tile;
+		++(*view).dirty_count;
+	}
+}
+
+/****************************************************************
+ * Summary: Counts the marked tiles again, and adds what they   *
+ *          changed by to the blocks above them.                *
+ *                                                              *
+ * Parameters: view - The view.                                 *
+ *             world - The board after the changes.             *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void view_update(view_t *view, const char *world)
+{
+	int i = 0;
+	int level = 0;
+	int tile = 0;
+	int row = 0, col = 0;				/* of the tile */
+	int delta = 0;
+
+	for (i = 0 ; i < (*view).dirty_count ; ++i) {
+		tile = (*view).dirty[i];
+		(*view).is_dirty[tile] = 0;
+		row = tile / (*view).level_cols[0];
+		col = tile % (*view).level_cols[0];
+
+		delta = count_cells(view, world, row << VIEW_TILE_SHIFT, col << VIEW_TILE_SHIFT, VIEW_TILE) -
+				(*view).counts[0][tile];
+		if (0 == delta) {
+			continue;
+		}
+		for (level = 0 ; level < (*view).levels ; ++level) {
+			(*view).counts[level][(row >> level) * (*view).level_cols[level] + (col >> level)] += delta;
+		}
+	}
+	(*view).dirty_count = 0;
+}
+
+/****************************************************************
+ * Summary: Zooms out until the whole board fits on the screen, *
+ *          and shows it from the top left.                     *
+ *                                                              *
+ * Parameters: view - The view.                                 *
+ *             screen_rows - The rows of the screen.            *
+ *             screen_cols - The columns of the screen.         *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void view_fit(view_t *view, int screen_rows, int screen_cols)
+{
+	int zoom = 0;
+	int most = VIEW_TILE_SHIFT + (*view).levels - 1;
+
+	while (zoom < most &&
+		   (((*view).rows - 1) >> zoom >= screen_rows || ((*view).cols - 1) >> zoom >= screen_cols)) {
+		++zoom;
+	}
+
+	(*view).zoom = zoom;
+	(*view).top = 0;
+	(*view).left = 0;
+	(*view).screen_rows = screen_rows;
+	(*view).screen_cols = screen_cols;
+}
+
+/****************************************************************
+ * Summary: Moves the view by whole characters, keeping its top *
+ *          left corner on the board.                           *
+ *                                                              *
+ * Parameters: view - The view.                                 *
+ *             rows - Characters to move down, or up if less    *
+ *                    than 0.                                   *
+ *             cols - Characters to move right, or left if less *
+ *                    than 0.                                   *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void view_pan(view_t *view, int rows, int cols)
+{
+	long long side = 1LL << (*view).zoom;
+
+	(*view).top = align((*view).top + rows * side, (*view).rows, (*view).zoom);
+	(*view).left = align((*view).left + cols * side, (*view).cols, (*view).zoom);
+}
+
+/****************************************************************
+ * Summary: Zooms around the middle of what the screen shows of *
+ *          the board.                                          *
+ *                                                              *
+ * Parameters: view - The view.                                 *
+ *             change - 1 to show blocks twice as large, -1 to  *
+ *                      show them half as large.                *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void view_zoom(view_t *view, int change)
+{
+	int zoom = (*view).zoom + change;
+	long long shown_rows = (long long)(*view).screen_rows << (*view).zoom;
+	long long shown_cols = (long long)(*view).screen_cols << (*view).zoom;
+	long long middle_row = 0, middle_col = 0;
+
+	/* The middle of what is shown of the board, the screen may be larger */
+	if (shown_rows > (*view).rows - (*view).top) {
+		shown_rows = (*view).rows - (*view).top;
+	}
+	if (shown_cols > (*view).cols - (*view).left) {
+		shown_cols = (*view).cols - (*view).left;
+	}
+	middle_row = (*view).top + shown_rows / 2;
+	middle_col = (*view).left + shown_cols / 2;
+
+	if (zoom < 0 || zoom > VIEW_TILE_SHIFT + (*view).levels - 1) {
+		return;
+	}
+
+	(*view).zoom = zoom;
+	(*view).top = align(middle_row - ((long long)(*view).screen_rows << zoom) / 2, (*view).rows, zoom);
+	(*view).left = align(middle_col - ((long long)(*view).screen_cols << zoom) / 2, (*view).cols, zoom);
+}
+
+/****************************************************************
+ * Summary: Renders the view, a line of characters per row of   *
+ *          the screen. Zoomed in all the way, a character is   *
+ *          the cell itself.                                    *
+ *                                                              *
+ * Parameters: view - The view.                                 *
+ *             world - The board.                               *
+ *             screen - Receives the lines, must hold           *
+ *                      screen_rows * (screen_cols + 1) chars.  *
+ *             screen_rows - The rows of the screen.            *
+ *             screen_cols - The columns of the screen.         *
+ *                                                              *
+ * Returns: The amount of characters rendered.                  *
+ ****************************************************************/
+size_t view_render(view_t *view, const char *world, char *screen, int screen_rows, int screen_cols)
+{
+	int r = 0, c = 0;
+	long long row = 0, col = 0;
+	int count = 0;
+	int zoom = (*view).zoom;
+	int side = 1 << zoom;
+	int level = zoom - VIEW_TILE_SHIFT;
+	int shades = (int)strlen(VIEW_RAMP) - 1;	/* of blocks that are not empty */
+	long long area = 0;
+	size_t used = 0;
+	const char *ramp = VIEW_RAMP;
+
+	(*view).screen_rows = screen_rows;
+	(*view).screen_cols = screen_cols;
+
+	for (r = 0 ; r < screen_rows ; ++r) {
+		row = (*view).top + (long long)r * side;
+		for (c = 0 ; c < screen_cols ; ++c) {
+			col = (*view).left + (long long)c * side;
+			if (row >= (*view).rows || col >= (*view).cols) {
+				screen[used] = ramp[0]; /* off the board */
+			} else if (0 == zoom) {
+				screen[used] = world[(size_t)row * (*view).cols + (size_t)col];
+			} else {
+				if (level >= 0) {
+					count = (*view).counts[level][(size_t)(row >> zoom) * (*view).level_cols[level] +
+												  (size_t)(col >> zoom)];
+				} else {
+					count = count_cells(view, world, (int)row, (int)col, side);
+				}
+
+				/* Blocks at the edges are only partly on the board */
+				area = (long long)((row + side < (*view).rows) ? side : (*view).rows - row) *
+					   ((col + side < (*view).cols) ? side : (*view).cols - col);
+				screen[used] = (0 == count) ? ramp[0] : ramp[1 + ((long long)count * shades - 1) / area];
+			}
+			++used;
+		}
+		screen[used] = '\n';
+		++used;
+	}
+
+	return used;
+}
+
+/* Counts the live cells of a square block, as much of it as is on the board */
+static int count_cells(view_t *view, const char *world, int top, int left, int side)
+{
+	int count = 0;
+	int row = 0, col = 0;
+	int bottom = (top + side < (*view).rows) ? top + side : (*view).rows;
+	int right = (left + side < (*view).cols) ? left + side : (*view).cols;
+	const char *cell = NULL;
+
+	for (row = top ; row < bottom ; ++row) {
+		cell = world + (size_t)row * (*view).cols;
+		for (col = left ; col < right ; ++col) {
+			count += ((*view).alive == cell[col]);
+		}
+	}
+
+	return count;
+}
+
+/* Keeps a corner on the board, at a multiple of the block size */
+static int align(long long value, int limit, int zoom)
+{
+	if (value > limit - 1) {
+		value = limit - 1;
+	}
+	if (value < 0) {
+		value = 0;
+	}
+
+	return (int)value & ~((1 << zoom) - 1);
+}
@@ -0,0 +1,50 @@
+#if !defined(_VIEW_H_)
+#define _VIEW_H_
+
+#include <stddef.h>
+
+/* Cells on a side of the smallest block the pyramid counts, as a shift */
+#define VIEW_TILE_SHIFT (3)
+#define VIEW_TILE (1 << VIEW_TILE_SHIFT)
+
+/* Levels above the tiles, so a block of the last one still has an int side */
+#define VIEW_MAX_LEVELS (24)
+
+/* Characters of blocks from empty to full */
+#define VIEW_RAMP (" .:-=+*#%@")
+
+typedef struct view_rec {
+	int rows;							/* the board */
+	int cols;
+	char alive;
+	int levels;
+	int *counts[VIEW_MAX_LEVELS];		/* live cells of every block of VIEW_TILE << level cells a side */
+	int level_rows[VIEW_MAX_LEVELS];
+	int level_cols[VIEW_MAX_LEVELS];
+	int *dirty;							/* tiles changed since the last update */
+	int dirty_count;
+	unsigned char *is_dirty;
+	int top;							/* the cell at the top left of the screen */
+	int left;
+	int zoom;							/* cells on a side of a character, as a shift */
+	int screen_rows;					/* the screen last rendered to */
+	int screen_cols;
+} view_t;
+
+view_t * view_create(const char *world, int rows, int cols, char alive);
+
+void view_destroy(view_t *view);
+
+void view_mark(view_t *view, int row, int col);
+
+void view_update(view_t *view, const char *world);
+
+void view_fit(view_t *view, int screen_rows, int screen_cols);
+
+void view_pan(view_t *view, int rows, int cols);
+
+void view_zoom(view_t *view, int change);
+
+size_t view_render(view_t *view, const char *world, char *screen, int screen_rows, int screen_cols);
+
+#endif
@@ -0,0 +1,187 @@
+/****************************************************************
+ * Summary: A growable arena of strings. Every string is kept   *
+ *          once, ending with '\0', and is addressed by its     *
+ *          offset, which stays the same when the arena grows.  *
+ *          An arena is freed as a whole.                       *
+ ****************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+#include "hash.h"
+
+static int grow_pool(arena_t *arena, size_t needed);
+
+static int grow_table(arena_t *arena);
+
+/****************************************************************
+ * Summary: Starts an empty arena. Nothing is allocated until a *
+ *          string is added.                                    *
+ *                                                              *
+ * Parameters: arena - The arena.                               *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void arena_init(arena_t *arena)
+{
+	memset(arena, 0, sizeof(arena_t));
+}
+
+/****************************************************************
+ * Summary: Frees the strings of an arena.                      *
+ *                                                              *
+ * Parameters: arena - The arena.                               *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void arena_free(arena_t *arena)
+{
+	free((*arena).pool);
+	free((*arena).table);
+	arena_init(arena);
+}
+
+/****************************************************************
+ * Summary: Adds a string to an arena, unless it is already in  *
+ *          it.                                                 *
+ *                                                              *
+ * Parameters: arena - The arena.                               *
+ *             word - The string, without '\0' in its length.   *
+ *             length - The length of word.                     *
+ *             offset - Receives the offset of the string.      *
+ *                                                              *
+ * Returns: 0 if successful, otherwise ARENA_NOT_ENOUGH_MEMORY  *
+ *          or ARENA_TOO_LARGE.                                 *
+ ****************************************************************/
+int arena_intern(arena_t *arena, const char *word, size_t length, uint32_t *offset)
+{
+	int rc = 0;
+	uint32_t i = 0;
+	uint32_t hash = (uint32_t)hash_bytes(word, length, ARENA_SEED);
+	const char *string = NULL;
+
+	/* The table is kept at most half full */
+	if (((*arena).count + 1) * 2 > (*arena).mask) {
+		rc = grow_table(arena);
+		if (0 != rc) {
+			return rc;
+		}
+	}
+
+	for (i = hash & (*arena).mask ; 0 != (*arena).table[i].offset ; i = (i + 1) & (*arena).mask) {
+		if (hash == (*arena).table[i].hash) {
+			string = (*arena).pool + (*arena).table[i].offset - 1;
+			if (0 == strncmp(string, word, length) && '\0' == string[length]) {
+				*offset = (*arena).table[i].offset - 1;
+				return 0;
+			}
+		}
+	}
+
+	if ((size_t)(*arena).used + length + 1 > (*arena).size) {
+		rc = grow_pool(arena, length + 1);
+		if (0 != rc) {
+			return rc;
+		}
+	}
+
+	*offset = (*arena).used;
+	memcpy((*arena).pool + (*arena).used, word, length);
+	(*arena).pool[(*arena).used + length] = '\0';
+	(*arena).used += (uint32_t)(length + 1);
+
+	(*arena).table[i].offset = *offset + 1;
+	(*arena).table[i].hash = hash;
+	++(*arena).count;
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Copies the strings of another arena to the end of   *
+ *          an arena. They are not interned again, so a string  *
+ *          in both arenas is kept twice.                       *
+ *                                                              *
+ * Parameters: arena - The arena.                               *
+ *             from - The arena to copy.                        *
+ *             base - Receives the offset the strings of from   *
+ *                    start at.                                 *
+ *                                                              *
+ * Returns: 0 if successful, otherwise ARENA_NOT_ENOUGH_MEMORY  *
+ *          or ARENA_TOO_LARGE.                                 *
+ ****************************************************************/
+int arena_append(arena_t *arena, const arena_t *from, uint32_t *base)
+{
+	int rc = 0;
+
+	if ((size_t)(*arena).used + (*from).used > (*arena).size) {
+		rc = grow_pool(arena, (*from).used);
+		if (0 != rc) {
+			return rc;
+		}
+	}
+
+	*base = (*arena).used;
+	if (0 != (*from).used) {
+		memcpy((*arena).pool + (*arena).used, (*from).pool, (*from).used);
+	}
+	(*arena).used += (*from).used;
+
+	return 0;
+}
+
+/* Makes room for needed more bytes, keeping every offset below 4 GB */
+static int grow_pool(arena_t *arena, size_t needed)
+{
+	size_t size = (0 == (*arena).size) ? ARENA_INITIAL_POOL : (*arena).size;
+	char *pool = NULL;
+
+	while (size < (size_t)(*arena).used + needed) {
+		size *= 2;
+	}
+	if (size > UINT32_MAX) {
+		if ((size_t)(*arena).used + needed > UINT32_MAX) {
+			return ARENA_TOO_LARGE;
+		}
+		size = UINT32_MAX;
+	}
+
+	pool = (char *)realloc((*arena).pool, size);
+	if (NULL == pool) {
+		return ARENA_NOT_ENOUGH_MEMORY;
+	}
+	(*arena).pool = pool;
+	(*arena).size = (uint32_t)size;
+
+	return 0;
+}
+
+/* Doubles the table, placing every string again by its hash */
+static int grow_table(arena_t *arena)
+{
+	uint32_t i = 0, j = 0;
+	uint32_t size = (0 == (*arena).mask) ? ARENA_INITIAL_TABLE : ((*arena).mask + 1) * 2;
+	arena_slot_t *table = NULL;
+
+	if (0 == size) {
+		return ARENA_TOO_LARGE;
+	}
+	table = (arena_slot_t *)calloc(size, sizeof(arena_slot_t));
+	if (NULL == table) {
+		return ARENA_NOT_ENOUGH_MEMORY;
+	}
+
+	for (i = 0 ; 0 != (*arena).mask && i <= (*arena).mask ; ++i) {
+		if (0 == (*arena).table[i].offset) {
+			continue;
+		}
+		for (j = (*arena).table[i].hash & (size - 1) ; 0 != table[j].offset ; j = (j + 1) & (size - 1)) {
+		}
+		table[j] = (*arena).table[i];
+	}
+
+	free((*arena).table);
+	(*arena).table = table;
+	(*arena).mask = size - 1;
+
+	return 0;
+}
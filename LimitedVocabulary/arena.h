@@ -0,0 +1,40 @@
+#if !defined(_ARENA_H_)
+#define _ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARENA_NOT_ENOUGH_MEMORY (-1)
+#define ARENA_TOO_LARGE (-2)
+
+/* Bytes of the pool, and slots of the table, an arena starts with */
+#define ARENA_INITIAL_POOL (1 << 12)
+#define ARENA_INITIAL_TABLE (1 << 10)
+
+#define ARENA_SEED (0x51ed27059fa3c84bULL)
+
+/* A string of the pool */
+typedef struct arena_slot_rec {
+	uint32_t offset;				/* offset in the pool + 1, 0 if the slot is empty */
+	uint32_t hash;
+} arena_slot_t;
+
+/* Strings kept once each, one after the other, addressed by offset */
+typedef struct arena_rec {
+	char *pool;
+	uint32_t used;
+	uint32_t size;
+	arena_slot_t *table;			/* finds the strings already in the pool */
+	uint32_t mask;					/* amount of slots - 1 */
+	uint32_t count;
+} arena_t;
+
+void arena_init(arena_t *arena);
+
+void arena_free(arena_t *arena);
+
+int arena_intern(arena_t *arena, const char *word, size_t length, uint32_t *offset);
+
+int arena_append(arena_t *arena, const arena_t *from, uint32_t *base);
+
+#endif
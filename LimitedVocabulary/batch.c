@@ -0,0 +1,342 @@
+/****************************************************************
+ * Summary: Rewrites many files with one dictionary. The files  *
+ *          are handed out to a pool of threads, each with its  *
+ *          own worker, so the dictionary is only read and is   *
+ *          built once for all of them. Every file is rewritten *
+ *          as if it was the only one.                          *
+ ****************************************************************/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE (200809L)
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "batch.h"
+#include "rewrite.h"
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+typedef struct batch_file_rec {
+	char *path;
+	long long bytes;
+	double seconds;
+	int rc;
+} batch_file_t;
+
+typedef struct batch_rec {
+	dictionary_t *dictionary;
+	batch_file_t *files;
+	int count;
+	int capacity;
+	int next;						/* the first file no thread has taken */
+	int flags;
+#if !defined(_WIN32)
+	pthread_mutex_t lock;
+#endif
+} batch_t;
+
+static int add_path(batch_t *batch, const char *path);
+
+static int add_file(batch_t *batch, const char *path);
+
+static void * run_worker(void *arg);
+
+static int take_file(batch_t *batch);
+
+static double now(void);
+
+static void print_report(batch_t *batch, double seconds, FILE *report);
+
+static const char * error_text(int rc);
+
+/****************************************************************
+ * Summary: Rewrites files in place, or to standard output one  *
+ *          after another, on a pool of threads. A directory is *
+ *          replaced by the files in it and its subdirectories. *
+ *                                                              *
+ * Parameters: dictionary - The dictionary with the synonyms,   *
+ *                          left as it is.                      *
+ *             paths - The files and directories to rewrite.    *
+ *             count - The amount of paths.                     *
+ *             flags - As for rewrite_file.                     *
+ *             threads - The amount of threads, or 0 for one    *
+ *                       per online processor.                  *
+ *             report - Receives the time every file took and   *
+ *                      the total, or NULL.                     *
+ *                                                              *
+ * Returns: 0 if successful, BATCH_FILES_FAILED if some files   *
+ *          could not be rewritten, otherwise                   *
+ *          BATCH_NOT_ENOUGH_MEMORY or BATCH_CANNOT_LIST.       *
+ ****************************************************************/
+int batch_rewrite(dictionary_t *dictionary, char *paths[], int count, int flags, int threads, FILE *report)
+{
+	int rc = 0;
+	int i = 0;
+	double start = 0;
+	batch_t batch;
+#if !defined(_WIN32)
+	int t = 0;
+	int started = 0;
+	pthread_t workers[BATCH_MAX_THREADS];
+#endif
+
+	memset(&batch, 0, sizeof(batch));
+	batch.dictionary = dictionary;
+	batch.flags = flags;
+
+	for (i = 0 ; i < count && 0 == rc ; ++i) {
+		rc = add_path(&batch, paths[i]);
+	}
+
+	/* Files written to standard output must not be mixed */
+#if !defined(_WIN32)
+	if (0 == threads) {
+		threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+#endif
+	if (threads < 1 || (flags & REWRITE_TO_STDOUT)) {
+		threads = 1;
+	} else if (threads > BATCH_MAX_THREADS) {
+		threads = BATCH_MAX_THREADS;
+	}
+	if (threads > batch.count) {
+		threads = (0 == batch.count) ? 1 : batch.count;
+	}
+
+	start = now();
+	if (0 == rc) {
+#if !defined(_WIN32)
+		pthread_mutex_init(&batch.lock, NULL);
+		for (started = 1 ; started < threads ; ++started) {
+			if (0 != pthread_create(&workers[started], NULL, run_worker, &batch)) {
+				break;
+			}
+		}
+#endif
+
+		/* The calling thread works too, and alone if no thread started */
+		run_worker(&batch);
+
+#if !defined(_WIN32)
+		for (t = 1 ; t < started ; ++t) {
+			pthread_join(workers[t], NULL);
+		}
+		pthread_mutex_destroy(&batch.lock);
+#endif
+
+		/* Files are left only if no thread had memory for a worker */
+		if (batch.next < batch.count) {
+			rc = BATCH_NOT_ENOUGH_MEMORY;
+		}
+	}
+
+	if (0 == rc) {
+		if (NULL != report) {
+			print_report(&batch, now() - start, report);
+		}
+		for (i = 0 ; i < batch.count ; ++i) {
+			if (0 != batch.files[i].rc) {
+				rc = BATCH_FILES_FAILED;
+			}
+		}
+	}
+
+	/* Free memory */
+	for (i = 0 ; i < batch.count ; ++i) {
+		free(batch.files[i].path);
+	}
+	free(batch.files);
+
+	return rc;
+}
+
+/* Adds a file, or every file under a directory */
+static int add_path(batch_t *batch, const char *path)
+{
+#if !defined(_WIN32)
+	int rc = 0;
+	size_t length = strlen(path);
+	char *child = NULL;
+	DIR *directory = NULL;
+	struct dirent *item = NULL;
+	struct stat info;
+
+	if (0 != stat(path, &info) || !S_ISDIR(info.st_mode)) {
+		return add_file(batch, path); /* a missing file is reported with the others */
+	}
+
+	directory = opendir(path);
+	if (NULL == directory) {
+		return BATCH_CANNOT_LIST;
+	}
+	while (0 == rc && NULL != (item = readdir(directory))) {
+		if (0 == strcmp((*item).d_name, ".") || 0 == strcmp((*item).d_name, "..")) {
+			continue;
+		}
+
+		child = (char *)malloc(sizeof(char) * (length + strlen((*item).d_name) + 2));
+		if (NULL == child) {
+			rc = BATCH_NOT_ENOUGH_MEMORY;
+			continue;
+		}
+		sprintf(child, ('/' == path[length - 1]) ? "%s%s" : "%s/%s", path, (*item).d_name);
+		rc = add_path(batch, child);
+		free(child);
+	}
+	closedir(directory);
+
+	return rc;
+#else
+	return add_file(batch, path);
+#endif
+}
+
+/* Adds a file to the end of the batch */
+static int add_file(batch_t *batch, const char *path)
+{
+	int capacity = 0;
+	batch_file_t *files = NULL;
+
+	if ((*batch).count == (*batch).capacity) {
+		capacity = (0 == (*batch).capacity) ? 16 : (*batch).capacity * 2;
+		files = (batch_file_t *)realloc((*batch).files, sizeof(batch_file_t) * capacity);
+		if (NULL == files) {
+			return BATCH_NOT_ENOUGH_MEMORY;
+		}
+		(*batch).files = files;
+		(*batch).capacity = capacity;
+	}
+
+	files = &(*batch).files[(*batch).count];
+	memset(files, 0, sizeof(batch_file_t));
+	(*files).path = (char *)malloc(sizeof(char) * (strlen(path) + 1));
+	if (NULL == (*files).path) {
+		return BATCH_NOT_ENOUGH_MEMORY;
+	}
+	strcpy((*files).path, path);
+	++(*batch).count;
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Rewrites files of a batch until none are left. A    *
+ *          thread without memory for a worker leaves the files *
+ *          to the others.                                      *
+ *                                                              *
+ * Parameters: arg - The batch.                                 *
+ *                                                              *
+ * Returns: NULL.                                               *
+ ****************************************************************/
+static void * run_worker(void *arg)
+{
+	int i = 0;
+	double start = 0;
+	batch_t *batch = (batch_t *)arg;
+	batch_file_t *file = NULL;
+	rewrite_worker_t *worker = NULL;
+#if !defined(_WIN32)
+	struct stat info;
+#endif
+
+	worker = rewrite_worker_create((*batch).dictionary, 1);
+	if (NULL == worker) {
+		return NULL;
+	}
+
+	while ((i = take_file(batch)) >= 0) {
+		file = &(*batch).files[i];
+#if !defined(_WIN32)
+		if (0 == stat((*file).path, &info)) {
+			(*file).bytes = (long long)info.st_size;
+		}
+#endif
+		start = now();
+		(*file).rc = rewrite_worker_file(worker, (*file).path, (*batch).flags);
+		(*file).seconds = now() - start;
+	}
+
+	rewrite_worker_destroy(worker);
+
+	return NULL;
+}
+
+/* Gets the index of a file no thread has taken yet, or -1 */
+static int take_file(batch_t *batch)
+{
+	int i = -1;
+
+#if !defined(_WIN32)
+	pthread_mutex_lock(&(*batch).lock);
+#endif
+	if ((*batch).next < (*batch).count) {
+		i = (*batch).next;
+		++(*batch).next;
+	}
+#if !defined(_WIN32)
+	pthread_mutex_unlock(&(*batch).lock);
+#endif
+
+	return i;
+}
+
+/* Seconds since some fixed point, for measuring */
+static double now(void)
+{
+#if !defined(_WIN32)
+	struct timespec time;
+
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+#else
+	return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/* Prints every file in the order given, then the totals */
+static void print_report(batch_t *batch, double seconds, FILE *report)
+{
+	int i = 0;
+	int failed = 0;
+	long long bytes = 0;
+	batch_file_t *file = NULL;
+
+	for (i = 0 ; i < (*batch).count ; ++i) {
+		file = &(*batch).files[i];
+		if (0 != (*file).rc) {
+			fprintf(report, "%s: %s\n", (*file).path, error_text((*file).rc));
+			++failed;
+			continue;
+		}
+
+		bytes += (*file).bytes;
+		fprintf(report, "%s: %lld bytes in %.3f ms, %.1f MB/s\n", (*file).path, (*file).bytes,
+				(*file).seconds * 1e3,
+				((*file).seconds > 0) ? (double)(*file).bytes / (*file).seconds / 1e6 : 0.0);
+	}
+
+	fprintf(report, "%d files, %lld bytes in %.3f s, %.1f MB/s", (*batch).count - failed, bytes, seconds,
+			(seconds > 0) ? (double)bytes / seconds / 1e6 : 0.0);
+	if (0 != failed) {
+		fprintf(report, ", %d failed", failed);
+	}
+	fprintf(report, "\n");
+}
+
+static const char * error_text(int rc)
+{
+	switch (rc) {
+	case REWRITE_NOT_ENOUGH_MEMORY:
+		return "not enough memory";
+	case REWRITE_CANNOT_READ:
+		return "could not read";
+	default:
+		return "could not write";
+	}
+}
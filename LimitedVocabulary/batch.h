@@ -0,0 +1,16 @@
+#if !defined(_BATCH_H_)
+#define _BATCH_H_
+
+#include <stdio.h>
+#include "dictionary.h"
+
+#define BATCH_NOT_ENOUGH_MEMORY (-1)
+#define BATCH_CANNOT_LIST (-2)
+#define BATCH_FILES_FAILED (-3)
+
+/* Most threads a batch runs on */
+#define BATCH_MAX_THREADS (256)
+
+int batch_rewrite(dictionary_t *dictionary, char *paths[], int count, int flags, int threads, FILE *report);
+
+#endif
@@ -0,0 +1,28 @@
+/****************************************************************
+ * Summary: Functions the Windows C library has and others do   *
+ *          not.                                                *
+ ****************************************************************/
+#include <ctype.h>
+#include "compat.h"
+
+#if !defined(_WIN32)
+
+/****************************************************************
+ * Summary: Converts a string to lowercase in place.            *
+ *                                                              *
+ * Parameters: str - The string to convert.                     *
+ *                                                              *
+ * Returns: str.                                                *
+ ****************************************************************/
+char * strlwr(char *str)
+{
+	char *p = str;
+
+	for (p = str ; '\0' != *p ; ++p) {
+		*p = (char)tolower((unsigned char)*p);
+	}
+
+	return str;
+}
+
+#endif
@@ -0,0 +1,9 @@
+#if !defined(_COMPAT_H_)
+#define _COMPAT_H_
+
+/* strlwr is only provided by Windows C libraries */
+#if !defined(_WIN32)
+char * strlwr(char *str);
+#endif
+
+#endif
@@ -0,0 +1,680 @@
+/****************************************************************
+ * Summary: Compiled dictionaries. A dictionary is written once *
+ *          as a binary file holding a minimal perfect hash of  *
+ *          its words, the words' entries, their synonyms and a *
+ *          pool of the strings. Loading maps the file, so      *
+ *          nothing is parsed or allocated per word and the     *
+ *          pages are shared by every process using the file.   *
+ *                                                              *
+ *          The perfect hash is hash and displace: words are    *
+ *          split into buckets by hash, and every bucket gets   *
+ *          the first displacement that sends all of its words  *
+ *          to free entries, largest buckets first.             *
+ ****************************************************************/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "hash.h"
+#include "dictfile.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define DICTFILE_SEED (0x9b7c2e5f1d3a4861ULL)
+#define DICTFILE_MAX_SEEDS (16)
+
+typedef struct dictfile_key_rec {
+	const dictfile_entry_t *entry;	/* in the dictionary being written */
+	uint64_t hash;
+	uint32_t length;
+	uint32_t bucket;
+	uint32_t position;
+} dictfile_key_t;
+
+static int collect_keys(const dictfile_t *words, dictfile_key_t **out, uint32_t *count);
+
+static int build_perfect_hash(const char *pool, dictfile_key_t *keys, uint32_t count, uint32_t *buckets,
+							  uint32_t bucket_count, uint64_t *seed);
+
+static int place_buckets(dictfile_key_t *keys, uint32_t count, uint32_t *buckets,
+						 uint32_t bucket_count, uint32_t *members, uint32_t *start, char *taken);
+
+static int write_file(FILE *fp, const dictfile_t *words, dictfile_key_t *keys, uint32_t count,
+					  uint32_t *buckets, uint32_t bucket_count, uint64_t seed);
+
+static uint32_t bucket_of(uint64_t hash, uint32_t bucket_count);
+
+static uint32_t position_of(uint64_t hash, uint32_t displacement, uint32_t count);
+
+static int load(const char *path, dictfile_t *file);
+
+static void unload(dictfile_t *file);
+
+static int check(dictfile_t *file);
+
+/****************************************************************
+ * Summary: Compiles the words of a dictionary to a file. The   *
+ *          string pool is written as it is, and every ring of  *
+ *          synonyms from its next synonym on.                  *
+ *                                                              *
+ * Parameters: words - The words of the dictionary, each once.  *
+ *             path - The file to write.                        *
+ *                                                              *
+ * Returns: 0 if successful, otherwise DICTFILE_NOT_ENOUGH_     *
+ *          MEMORY, DICTFILE_CANNOT_WRITE or DICTFILE_TOO_LARGE.*
+ ****************************************************************/
+int dictfile_write(const dictfile_t *words, const char *path)
+{
+	int rc = 0;
+	uint32_t count = 0;
+	uint32_t bucket_count = 0;
+	uint32_t *buckets = NULL;
+	uint64_t seed = 0;
+	dictfile_key_t *keys = NULL;
+	FILE *fp = NULL;
+
+	rc = collect_keys(words, &keys, &count);
+	if (0 != rc) {
+		return rc;
+	}
+
+	bucket_count = count / DICTFILE_BUCKET_LOAD + 1;
+	buckets = (uint32_t *)calloc(bucket_count, sizeof(uint32_t));
+	if (NULL == buckets) {
+		free(keys);
+		return DICTFILE_NOT_ENOUGH_MEMORY;
+	}
+
+	rc = build_perfect_hash((*words).pool, keys, count, buckets, bucket_count, &seed);
+	if (0 == rc) {
+		fp = fopen(path, "wb");
+		if (NULL == fp) {
+			rc = DICTFILE_CANNOT_WRITE;
+		} else {
+			rc = write_file(fp, words, keys, count, buckets, bucket_count, seed);
+			if (0 != fclose(fp)) {
+				rc = DICTFILE_CANNOT_WRITE;
+			}
+			if (0 != rc) {
+				remove(path);
+			}
+		}
+	}
+
+	free(buckets);
+	free(keys);
+
+	return rc;
+}
+
+/****************************************************************
+ * Summary: Checks whether a file is a compiled dictionary.     *
+ *                                                              *
+ * Parameters: path - The file to check.                        *
+ *                                                              *
+ * Returns: 1 if it starts like a compiled dictionary, 0 if not *
+ *          or it cannot be read.                               *
+ ****************************************************************/
+int dictfile_is_compiled(const char *path)
+{
+	char magic[8] = { 0 };
+	size_t read = 0;
+	FILE *fp = fopen(path, "rb");
+
+	if (NULL == fp) {
+		return 0;
+	}
+	read = fread(magic, 1, sizeof(magic), fp);
+	fclose(fp);
+
+	return (sizeof(magic) == read && 0 == memcmp(magic, DICTFILE_MAGIC, sizeof(magic)));
+}
+
+/****************************************************************
+ * Summary: Opens a compiled dictionary.                        *
+ *                                                              *
+ * Parameters: path - The file to open.                         *
+ *                                                              *
+ * Returns: The compiled dictionary if successful, otherwise    *
+ *          NULL.                                               *
+ ****************************************************************/
+dictfile_t * dictfile_open(const char *path)
+{
+	const char *base = NULL;
+	dictfile_t *file = (dictfile_t *)malloc(sizeof(dictfile_t));
+
+	if (NULL == file) {
+		return NULL;
+	}
+
+	if (0 != load(path, file)) {
+		free(file);
+		return NULL;
+	}
+	if (0 != check(file)) {
+		unload(file);
+		free(file);
+		return NULL;
+	}
+
+	base = (const char *)(*file).data;
+	(*file).header = (const dictfile_header_t *)base;
+	(*file).buckets = (const uint32_t *)(base + (*(*file).header).buckets_offset);
+	(*file).entries = (const dictfile_entry_t *)(base + (*(*file).header).entries_offset);
+	(*file).synonyms = (const uint32_t *)(base + (*(*file).header).synonyms_offset);
+	(*file).flags = (const uint8_t *)(base + (*(*file).header).flags_offset);
+	(*file).pool = base + (*(*file).header).pool_offset;
+
+	/* Zeroed pages, so this costs nothing until an entry is used */
+	(*file).rotation = (uint32_t *)calloc((*(*file).header).entry_count, sizeof(uint32_t));
+	if (NULL == (*file).rotation) {
+		unload(file);
+		free(file);
+		return NULL;
+	}
+
+	return file;
+}
+
+/****************************************************************
+ * Summary: Closes a compiled dictionary.                       *
+ *                                                              *
+ * Parameters: file - The compiled dictionary.                  *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void dictfile_close(dictfile_t *file)
+{
+	free((*file).rotation);
+	unload(file);
+	free(file);
+}
+
+/****************************************************************
+ * Summary: Finds the entry of a word.                          *
+ *                                                              *
+ * Parameters: file - The compiled dictionary.                  *
+ *             word - The word, in lowercase.                   *
+ *             length - The length of word.                     *
+ *                                                              *
+ * Returns: The entry if found, otherwise NULL.                 *
+ ****************************************************************/
+const dictfile_entry_t * dictfile_find(dictfile_t *file, const char *word, size_t length)
+{
+	const dictfile_header_t *header = (*file).header;
+	uint64_t hash = hash_bytes(word, length, (*header).seed);
+	uint32_t displacement = (*file).buckets[bucket_of(hash, (*header).bucket_count)];
+	const dictfile_entry_t *entry = NULL;
+
+	/* Every word maps to some entry, so the word itself is compared */
+	entry = &(*file).entries[position_of(hash, displacement, (*header).entry_count)];
+	if (length != (*entry).length || (*entry).word >= (*header).pool_size ||
+		length >= (*header).pool_size - (*entry).word ||
+		0 != memcmp((*file).pool + (*entry).word, word, length)) {
+		return NULL;
+	}
+
+	return entry;
+}
+
+/****************************************************************
+ * Summary: Gets the next synonym of an entry, in turn.         *
+ *                                                              *
+ * Parameters: file - The compiled dictionary.                  *
+ *             entry - The entry.                               *
+ *                                                              *
+ * Returns: The synonym, which must not be changed, or NULL if  *
+ *          the word has no synonyms.                           *
+ ****************************************************************/
+char * dictfile_next_synonym(dictfile_t *file, const dictfile_entry_t *entry)
+{
+	char *synonym = dictfile_peek_synonym(file, entry, 0);
+
+	if (NULL != synonym) {
+		dictfile_skip_synonyms(file, entry, 1);
+	}
+
+	return synonym;
+}
+
+/****************************************************************
+ * Summary: Gets the synonym dictfile_next_synonym would return *
+ *          after turn more calls, without moving. Nothing is   *
+ *          changed, so this can be called from many threads at *
+ *          once.                                               *
+ *                                                              *
+ * Parameters: file - The compiled dictionary.                  *
+ *             entry - The entry.                               *
+ *             turn - The amount of calls to look past.         *
+ *                                                              *
+ * Returns: The synonym, which must not be changed, or NULL if  *
+ *          the word has no synonyms.                           *
+ ****************************************************************/
+char * dictfile_peek_synonym(dictfile_t *file, const dictfile_entry_t *entry, uint64_t turn)
+{
+	const dictfile_header_t *header = (*file).header;
+	uint32_t index = 0;
+	uint32_t offset = 0;
+
+	if (0 == (*entry).synonym_count || (*entry).first_synonym >= (*header).synonym_count ||
+		(*entry).synonym_count > (*header).synonym_count - (*entry).first_synonym) {
+		return NULL;
+	}
+
+	turn += (*file).rotation[entry - (*file).entries];
+	index = (*entry).first_synonym + (uint32_t)(turn % (*entry).synonym_count);
+
+	offset = (*file).synonyms[index];
+	if (offset >= (*header).pool_size) {
+		return NULL;
+	}
+
+	return (char *)((*file).pool + offset);
+}
+
+/****************************************************************
+ * Summary: Moves the synonyms of an entry as if                *
+ *          dictfile_next_synonym was called turns times.       *
+ *                                                              *
+ * Parameters: file - The compiled dictionary.                  *
+ *             entry - The entry.                               *
+ *             turns - The amount of calls.                     *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void dictfile_skip_synonyms(dictfile_t *file, const dictfile_entry_t *entry, uint64_t turns)
+{
+	uint32_t *rotation = &(*file).rotation[entry - (*file).entries];
+
+	if (0 != (*entry).synonym_count) {
+		*rotation = (uint32_t)((*rotation + turns % (*entry).synonym_count) % (*entry).synonym_count);
+	}
+}
+
+/****************************************************************
+ * Summary: Lists the words of a dictionary with their hashes.  *
+ *                                                              *
+ * Parameters: words - The words of the dictionary.             *
+ *             out - Receives the keys, to be freed.            *
+ *             count - Receives the amount of keys.             *
+ *                                                              *
+ * Returns: 0 if successful, otherwise DICTFILE_NOT_ENOUGH_     *
+ *          MEMORY or DICTFILE_TOO_LARGE.                       *
+ ****************************************************************/
+static int collect_keys(const dictfile_t *words, dictfile_key_t **out, uint32_t *count)
+{
+	uint32_t i = 0;
+	uint32_t total = (*(*words).header).entry_count;
+	dictfile_key_t *keys = NULL;
+
+	if (total >= UINT32_MAX / 2) {
+		return DICTFILE_TOO_LARGE;
+	}
+	keys = (dictfile_key_t *)malloc(sizeof(dictfile_key_t) * ((size_t)total + 1));
+	if (NULL == keys) {
+		return DICTFILE_NOT_ENOUGH_MEMORY;
+	}
+
+	for (i = 0 ; i < total ; ++i) {
+		keys[i].entry = &(*words).entries[i];
+		keys[i].length = (*keys[i].entry).length;
+	}
+
+	*count = total;
+	*out = keys;
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Finds a seed and a displacement for every bucket    *
+ *          that send every key to its own entry.               *
+ *                                                              *
+ * Parameters: pool - The strings of the keys.                  *
+ *             keys - The keys, receiving their hashes and      *
+ *                    positions.                                *
+ *             count - The amount of keys.                      *
+ *             buckets - Receives the displacements.            *
+ *             bucket_count - The amount of buckets.            *
+ *             seed - Receives the seed.                        *
+ *                                                              *
+ * Returns: 0 if successful, otherwise DICTFILE_NOT_ENOUGH_     *
+ *          MEMORY or DICTFILE_TOO_LARGE.                       *
+ ****************************************************************/
+static int build_perfect_hash(const char *pool, dictfile_key_t *keys, uint32_t count, uint32_t *buckets,
+							  uint32_t bucket_count, uint64_t *seed)
+{
+	int rc = DICTFILE_TOO_LARGE;
+	int attempt = 0;
+	uint32_t i = 0;
+	uint32_t *members = (uint32_t *)malloc(sizeof(uint32_t) * (count + 1));
+	uint32_t *start = (uint32_t *)malloc(sizeof(uint32_t) * (bucket_count + 1));
+	char *taken = (char *)malloc(count + 1);
+
+	if (NULL == members || NULL == start || NULL == taken) {
+		free(members);
+		free(start);
+		free(taken);
+		return DICTFILE_NOT_ENOUGH_MEMORY;
+	}
+
+	for (attempt = 0 ; attempt < DICTFILE_MAX_SEEDS && 0 != rc ; ++attempt) {
+		*seed = DICTFILE_SEED + (uint64_t)attempt * 0x9e3779b97f4a7c15ULL;
+		for (i = 0 ; i < count ; ++i) {
+			keys[i].hash = hash_bytes(pool + (*keys[i].entry).word, keys[i].length, *seed);
+			keys[i].bucket = bucket_of(keys[i].hash, bucket_count);
+		}
+		rc = place_buckets(keys, count, buckets, bucket_count, members, start, taken);
+	}
+
+	free(members);
+	free(start);
+	free(taken);
+
+	return rc;
+}
+
+/****************************************************************
+ * Summary: Places the buckets of one seed, largest first.      *
+ *                                                              *
+ * Parameters: keys - The keys, with their buckets.             *
+ *             count - The amount of keys.                      *
+ *             buckets - Receives the displacements.            *
+ *             bucket_count - The amount of buckets.            *
+ *             members - Room for count key indexes.            *
+ *             start - Room for bucket_count + 1 indexes.       *
+ *             taken - Room for count flags.                    *
+ *                                                              *
+ * Returns: 0 if successful, DICTFILE_TOO_LARGE if a bucket     *
+ *          could not be placed.                                *
+ ****************************************************************/
+static int place_buckets(dictfile_key_t *keys, uint32_t count, uint32_t *buckets,
+						 uint32_t bucket_count, uint32_t *members, uint32_t *start, char *taken)
+{
+	uint32_t i = 0, j = 0, k = 0;
+	uint32_t b = 0;
+	uint32_t size = 0, largest = 0;
+	uint32_t d = 0;
+	uint32_t position = 0;
+	int fits = 0;
+
+	/* Group the keys by bucket, keeping the keys of a bucket in start[b]..start[b + 1] */
+	memset(start, 0, sizeof(uint32_t) * (bucket_count + 1));
+	for (i = 0 ; i < count ; ++i) {
+		++start[keys[i].bucket + 1];
+	}
+	for (b = 0 ; b < bucket_count ; ++b) {
+		if (start[b + 1] > largest) {
+			largest = start[b + 1];
+		}
+		start[b + 1] += start[b];
+	}
+	for (i = 0 ; i < count ; ++i) {
+		members[start[keys[i].bucket]++] = i;
+	}
+	for (b = bucket_count ; b > 0 ; --b) { /* undo the shift made by filling */
+		start[b] = start[b - 1];
+	}
+	start[0] = 0;
+
+	memset(taken, 0, count);
+	memset(buckets, 0, sizeof(uint32_t) * bucket_count);
+
+	for (size = largest ; size > 0 ; --size) {
+		for (b = 0 ; b < bucket_count ; ++b) {
+			if (start[b + 1] - start[b] != size) {
+				continue;
+			}
+
+			/* The first displacement that puts every key of the bucket on a free entry */
+			for (d = 0 ; d < DICTFILE_MAX_DISPLACEMENT ; ++d) {
+				fits = 1;
+				for (i = start[b] ; i < start[b + 1] && fits ; ++i) {
+					position = position_of(keys[members[i]].hash, d, count);
+					fits = !taken[position];
+					for (j = start[b] ; j < i && fits ; ++j) {
+						fits = (keys[members[j]].position != position);
+					}
+					keys[members[i]].position = position;
+				}
+				if (fits) {
+					break;
+				}
+			}
+			if (!fits) {
+				return DICTFILE_TOO_LARGE;
+			}
+
+			buckets[b] = d;
+			for (k = start[b] ; k < start[b + 1] ; ++k) {
+				taken[keys[members[k]].position] = 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Writes a compiled dictionary.                       *
+ *                                                              *
+ * Parameters: fp - The file, open for binary writing.          *
+ *             words - The words of the dictionary.             *
+ *             keys - The placed keys.                          *
+ *             count - The amount of keys.                      *
+ *             buckets - The displacements.                     *
+ *             bucket_count - The amount of buckets.            *
+ *             seed - The seed of the perfect hash.             *
+ *                                                              *
+ * Returns: 0 if successful, otherwise DICTFILE_NOT_ENOUGH_     *
+ *          MEMORY or DICTFILE_CANNOT_WRITE.                    *
+ ****************************************************************/
+static int write_file(FILE *fp, const dictfile_t *words, dictfile_key_t *keys, uint32_t count,
+					  uint32_t *buckets, uint32_t bucket_count, uint64_t seed)
+{
+	int rc = 0;
+	uint32_t i = 0, n = 0;
+	uint32_t synonyms = 0;
+	uint32_t pool_size = (*(*words).header).pool_size;
+	const dictfile_entry_t *from = NULL;
+	dictfile_entry_t *entry = NULL;
+	dictfile_header_t header;
+	dictfile_entry_t *entries = NULL;
+	uint32_t *offsets = NULL;
+	uint8_t *flags = NULL;
+
+	entries = (dictfile_entry_t *)calloc(count, sizeof(dictfile_entry_t));
+	offsets = (uint32_t *)malloc(sizeof(uint32_t) * ((size_t)(*(*words).header).synonym_count + 1));
+	flags = (uint8_t *)malloc(count);
+	if (NULL == entries || NULL == offsets || NULL == flags) {
+		free(entries);
+		free(offsets);
+		free(flags);
+		return DICTFILE_NOT_ENOUGH_MEMORY;
+	}
+
+	/* Every entry moves to its position, its ring starting where it is now */
+	for (i = 0 ; i < count ; ++i) {
+		from = keys[i].entry;
+		entry = &entries[keys[i].position];
+		*entry = *from;
+		flags[keys[i].position] = (*words).flags[from - (*words).entries];
+		(*entry).first_synonym = synonyms;
+		for (n = 0 ; n < (*from).synonym_count ; ++n) {
+			offsets[synonyms] = (*words).synonyms[(*from).first_synonym +
+				(n + (*words).rotation[from - (*words).entries]) % (*from).synonym_count];
+			++synonyms;
+		}
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, DICTFILE_MAGIC, sizeof(header.magic));
+	header.version = DICTFILE_VERSION;
+	header.byte_order = DICTFILE_BYTE_ORDER;
+	header.entry_count = count;
+	header.bucket_count = bucket_count;
+	header.synonym_count = synonyms;
+	header.pool_size = pool_size;
+	header.phrase_count = (*(*words).header).phrase_count;
+	header.prefix_count = (*(*words).header).prefix_count;
+	header.seed = seed;
+	header.buckets_offset = sizeof(header);
+	header.entries_offset = header.buckets_offset + sizeof(uint32_t) * (uint64_t)bucket_count;
+	header.synonyms_offset = header.entries_offset + sizeof(dictfile_entry_t) * (uint64_t)count;
+	header.flags_offset = header.synonyms_offset + sizeof(uint32_t) * (uint64_t)synonyms;
+	header.pool_offset = header.flags_offset + count;
+
+	if (1 != fwrite(&header, sizeof(header), 1, fp) ||
+		bucket_count != fwrite(buckets, sizeof(uint32_t), bucket_count, fp) ||
+		count != fwrite(entries, sizeof(dictfile_entry_t), count, fp) ||
+		synonyms != fwrite(offsets, sizeof(uint32_t), synonyms, fp) ||
+		count != fwrite(flags, 1, count, fp) ||
+		pool_size != fwrite((*words).pool, 1, pool_size, fp)) {
+		rc = DICTFILE_CANNOT_WRITE;
+	}
+
+	free(entries);
+	free(offsets);
+	free(flags);
+
+	return rc;
+}
+
+/* Spreads the high half of a hash over the buckets */
+static uint32_t bucket_of(uint64_t hash, uint32_t bucket_count)
+{
+	return (uint32_t)(((hash >> 32) * bucket_count) >> 32);
+}
+
+/* Remixes a hash with a displacement and spreads it over the entries */
+static uint32_t position_of(uint64_t hash, uint32_t displacement, uint32_t count)
+{
+	uint64_t x = hash ^ ((uint64_t)displacement * 0x9e3779b97f4a7c15ULL);
+
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+
+	return (uint32_t)(((x >> 32) * count) >> 32);
+}
+
+#if !defined(_WIN32)
+
+/* Maps a whole file read-only, shared with other processes */
+static int load(const char *path, dictfile_t *file)
+{
+	int fd = 0;
+	struct stat info;
+	void *data = NULL;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+	if (0 != fstat(fd, &info) || info.st_size < (off_t)sizeof(dictfile_header_t)) {
+		close(fd);
+		return -1;
+	}
+
+	data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == data) {
+		return -1;
+	}
+
+	(*file).data = data;
+	(*file).size = (size_t)info.st_size;
+	(*file).mapped = 1;
+
+	return 0;
+}
+
+#else
+
+/* Reads a whole file into memory */
+static int load(const char *path, dictfile_t *file)
+{
+	long size = 0;
+	void *data = NULL;
+	FILE *fp = fopen(path, "rb");
+
+	if (NULL == fp) {
+		return -1;
+	}
+	if (0 != fseek(fp, 0, SEEK_END) || (size = ftell(fp)) < (long)sizeof(dictfile_header_t) ||
+		0 != fseek(fp, 0, SEEK_SET)) {
+		fclose(fp);
+		return -1;
+	}
+
+	data = malloc((size_t)size);
+	if (NULL == data || (size_t)size != fread(data, 1, (size_t)size, fp)) {
+		free(data);
+		fclose(fp);
+		return -1;
+	}
+	fclose(fp);
+
+	(*file).data = data;
+	(*file).size = (size_t)size;
+	(*file).mapped = 0;
+
+	return 0;
+}
+
+#endif
+
+static void unload(dictfile_t *file)
+{
+#if !defined(_WIN32)
+	if ((*file).mapped) {
+		munmap((*file).data, (*file).size);
+		return;
+	}
+#endif
+	free((*file).data);
+}
+
+/****************************************************************
+ * Summary: Checks that the header of a file is valid and that  *
+ *          its arrays fit in the file. Entries are checked     *
+ *          when they are used.                                 *
+ *                                                              *
+ * Parameters: file - The loaded file.                          *
+ *                                                              *
+ * Returns: 0 if valid, otherwise -1.                           *
+ ****************************************************************/
+static int check(dictfile_t *file)
+{
+	const dictfile_header_t *header = (const dictfile_header_t *)(*file).data;
+	const char *base = (const char *)(*file).data;
+	uint64_t size = (*file).size;
+
+	if (0 != memcmp((*header).magic, DICTFILE_MAGIC, sizeof((*header).magic)) ||
+		DICTFILE_VERSION != (*header).version ||
+		DICTFILE_BYTE_ORDER != (*header).byte_order ||
+		0 == (*header).entry_count || 0 == (*header).bucket_count || 0 == (*header).pool_size) {
+		return -1;
+	}
+
+	/* The arrays follow each other, in order, up to the end of the file */
+	if ((*header).buckets_offset != sizeof(dictfile_header_t) ||
+		(*header).entries_offset != (*header).buckets_offset + sizeof(uint32_t) * (uint64_t)(*header).bucket_count ||
+		(*header).synonyms_offset != (*header).entries_offset + sizeof(dictfile_entry_t) * (uint64_t)(*header).entry_count ||
+		(*header).flags_offset != (*header).synonyms_offset + sizeof(uint32_t) * (uint64_t)(*header).synonym_count ||
+		(*header).pool_offset != (*header).flags_offset + (*header).entry_count ||
+		(*header).pool_offset + (*header).pool_size != size) {
+		return -1;
+	}
+
+	/* Every string ends inside the pool */
+	if ('\0' != base[size - 1]) {
+		return -1;
+	}
+
+	return 0;
+}
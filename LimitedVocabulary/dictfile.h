@@ -0,0 +1,87 @@
+#if !defined(_DICTFILE_H_)
+#define _DICTFILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DICTFILE_MAGIC ("LVDICT01")
+#define DICTFILE_VERSION (2)
+
+/* Tells a file written on a machine of the other byte order */
+#define DICTFILE_BYTE_ORDER (0x01020304u)
+
+/* Average amount of words per bucket of the perfect hash */
+#define DICTFILE_BUCKET_LOAD (4)
+
+/* Displacements tried for a bucket before starting over with another seed */
+#define DICTFILE_MAX_DISPLACEMENT (1u << 22)
+
+/* Flags of an entry: a phrase of more words starts with its words */
+#define DICTFILE_PREFIX (1)
+
+#define DICTFILE_NOT_ENOUGH_MEMORY (-1)
+#define DICTFILE_CANNOT_WRITE (-2)
+#define DICTFILE_TOO_LARGE (-3)
+
+/* The start of a compiled dictionary, followed by the arrays it points to */
+typedef struct dictfile_header_rec {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t entry_count;
+	uint32_t bucket_count;
+	uint32_t synonym_count;
+	uint32_t pool_size;
+	uint32_t phrase_count;			/* entries of more than one word */
+	uint32_t prefix_count;			/* entries with DICTFILE_PREFIX */
+	uint64_t seed;
+	uint64_t buckets_offset;		/* bytes from the start of the file */
+	uint64_t entries_offset;
+	uint64_t synonyms_offset;
+	uint64_t flags_offset;
+	uint64_t pool_offset;
+} dictfile_header_t;
+
+/*
+ * A word, at the position the perfect hash gives it. A phrase is its
+ * words joined by single spaces, and every shorter phrase it starts
+ * with has an entry too, without synonyms if it is not in the
+ * dictionary itself.
+ */
+typedef struct dictfile_entry_rec {
+	uint32_t word;					/* offset in the string pool */
+	uint32_t length;
+	uint32_t first_synonym;			/* index in the synonym array */
+	uint32_t synonym_count;
+} dictfile_entry_t;
+
+typedef struct dictfile_rec {
+	const dictfile_header_t *header;
+	const uint32_t *buckets;		/* displacement of every bucket */
+	const dictfile_entry_t *entries;
+	const uint32_t *synonyms;		/* pool offsets, in the order they are used */
+	const uint8_t *flags;			/* per entry */
+	const char *pool;
+	uint32_t *rotation;				/* next synonym of every entry, per process */
+	void *data;						/* the mapped file, or a copy of it */
+	size_t size;
+	int mapped;
+} dictfile_t;
+
+int dictfile_write(const dictfile_t *words, const char *path);
+
+int dictfile_is_compiled(const char *path);
+
+dictfile_t * dictfile_open(const char *path);
+
+void dictfile_close(dictfile_t *file);
+
+const dictfile_entry_t * dictfile_find(dictfile_t *file, const char *word, size_t length);
+
+char * dictfile_next_synonym(dictfile_t *file, const dictfile_entry_t *entry);
+
+char * dictfile_peek_synonym(dictfile_t *file, const dictfile_entry_t *entry, uint64_t turn);
+
+void dictfile_skip_synonyms(dictfile_t *file, const dictfile_entry_t *entry, uint64_t turns);
+
+#endif
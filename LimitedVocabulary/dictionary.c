@@ -1,115 +1,733 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE (200809L)
+#endif
+
 #include <stdlib.h>
 #include <string.h>
 #include "dictionary.h"
+#include "dictparse.h"
+#include "hash.h"
+#include "scan.h"
+#include "stats.h"
+#include "compat.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* Rounds a size of a block up to where a uint64_t can follow */
+#define ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+/* Bytes read from a stream at a time */
+#define DICTIONARY_CHUNK (1 << 16)
+
+/* Skipped lines told of one by one, the rest are counted */
+#define DICTIONARY_WARNINGS (10)
+
+static dictionary_t * parse(const char *path, const char *data, size_t size, int threads,
+							dictionary_error_t *error);
+
+static void locate(const char *data, size_t offset, dictionary_error_t *error);
 
-static list_node_t * interpret_line(char *line, list_node_t *last);
+static void warn_skipped(const char *path, const char *data, const dictparse_t *words);
+
+static dictionary_t * pack(dictparse_t *words);
+
+static const dictfile_entry_t * find(dictionary_t *dictionary, const char *word, size_t length);
+
+static dictionary_slot_t * lookup(dictionary_t *dictionary, const char *word, size_t length, uint64_t hash,
+								  size_t *probes);
+
+static dictionary_slot_t * place(dictionary_t *dictionary, const char *word, size_t length, uint64_t hash);
 
 /****************************************************************
  * Summary: Generates a dictionary from given dictionary file.  *
+ *          The file is read to its end and parsed as           *
+ *          load_dictionary does.                               *
  *                                                              *
  * Parameters: fp_dictionary - represents the dictionary file.  *
  *                                                              *
- * Returns: The first node in the dictionary if successful,     *
- *          otherwise NULL.                                     *
+ * Returns: The dictionary if successful, otherwise NULL.       *
+ ****************************************************************/
+dictionary_t * create_dictionary(FILE *fp_dictionary)
+{
+	size_t size = 0, used = 0;
+	char *data = NULL;
+	char *new_data = NULL;
+	dictionary_t *dictionary = NULL;
+
+	/* Read everything */
+	do {
+		if (used + DICTIONARY_CHUNK > size) {
+			size = (0 == size) ? DICTIONARY_CHUNK : size * 2;
+			new_data = (char *)realloc(data, size);
+			if (NULL == new_data) {
+				free(data);
+				return NULL;
+			}
+			data = new_data;
+		}
+		used += fread(data + used, 1, DICTIONARY_CHUNK, fp_dictionary);
+	} while (0 == feof(fp_dictionary) && 0 == ferror(fp_dictionary));
+
+	if (0 == ferror(fp_dictionary)) {
+		dictionary = parse(NULL, data, used, 1, NULL);
+	}
+	free(data);
+
+	return dictionary;
+}
+
+/****************************************************************
+ * Summary: Loads a dictionary file. The file is mapped and     *
+ *          parsed in one pass, on many threads if it is large. *
+ *          Every word is kept once per thread in one pool of   *
+ *          strings, whether it is a word or a synonym, and the *
+ *          synonyms of a word are an array of offsets in the   *
+ *          pool. A line whose word is not letters only, which  *
+ *          could never be looked up, is skipped with a warning *
+ *          on stderr.                                          *
+ *                                                              *
+ * Parameters: path - The dictionary file.                      *
+ *             threads - The most threads to parse on, or 0 for *
+ *                       one per online processor.              *
+ *             error - Receives why the file could not be       *
+ *                     loaded, and the line and column if the   *
+ *                     file is wrong, or NULL.                  *
+ *                                                              *
+ * Returns: The dictionary if successful, otherwise NULL.       *
+ ****************************************************************/
+dictionary_t * load_dictionary(const char *path, int threads, dictionary_error_t *error)
+{
+	dictionary_t *dictionary = NULL;
+	dictionary_error_t ignored;
+#if !defined(_WIN32)
+	int fd = 0;
+	struct stat info;
+	void *data = NULL;
+#else
+	FILE *fp = NULL;
+#endif
+
+	if (NULL == error) {
+		error = &ignored;
+	}
+	memset(error, 0, sizeof(dictionary_error_t));
+
+#if !defined(_WIN32)
+	fd = open(path, O_RDONLY);
+	if (fd < 0 || 0 != fstat(fd, &info)) {
+		if (fd >= 0) {
+			close(fd);
+		}
+		(*error).code = DICTIONARY_CANNOT_READ;
+		return NULL;
+	}
+	if (0 == info.st_size) {
+		close(fd);
+		(*error).code = DICTIONARY_NO_WORDS;
+		return NULL;
+	}
+
+	data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (MAP_FAILED == data) {
+		(*error).code = DICTIONARY_CANNOT_READ;
+		return NULL;
+	}
+	posix_madvise(data, (size_t)info.st_size, POSIX_MADV_SEQUENTIAL);
+
+	dictionary = parse(path, (const char *)data, (size_t)info.st_size, threads, error);
+	munmap(data, (size_t)info.st_size);
+#else
+	(void)threads;
+	fp = fopen(path, "rb");
+	if (NULL == fp) {
+		(*error).code = DICTIONARY_CANNOT_READ;
+		return NULL;
+	}
+	dictionary = create_dictionary(fp);
+	fclose(fp);
+	if (NULL == dictionary) {
+		(*error).code = DICTIONARY_NOT_ENOUGH_MEMORY;
+	}
+#endif
+
+	return dictionary;
+}
+
+/****************************************************************
+ * Summary: Opens a dictionary file of either kind: a compiled  *
+ *          one is mapped, a text one is loaded.                *
+ *                                                              *
+ * Parameters: path - The dictionary file.                      *
+ *             threads - As for load_dictionary.                *
+ *             error - As for load_dictionary.                  *
+ *                                                              *
+ * Returns: The dictionary if successful, otherwise NULL.       *
+ ****************************************************************/
+dictionary_t * open_dictionary(const char *path, int threads, dictionary_error_t *error)
+{
+	uint64_t started = STATS_NOW();
+	dictionary_t *dictionary = NULL;
+
+	if (0 == dictfile_is_compiled(path)) {
+		dictionary = load_dictionary(path, threads, error);
+	} else {
+		dictionary = open_compiled_dictionary(path);
+		if (NULL == dictionary && NULL != error) {
+			memset(error, 0, sizeof(dictionary_error_t));
+			(*error).code = DICTIONARY_BAD_COMPILED;
+		}
+	}
+	STATS_ADD(STATS_LOAD_NS, STATS_NOW() - started);
+
+	return dictionary;
+}
+
+/****************************************************************
+ * Summary: Describes why a dictionary could not be loaded.     *
+ *                                                              *
+ * Parameters: code - The code of a dictionary_error_t.         *
+ *                                                              *
+ * Returns: The description.                                    *
+ ****************************************************************/
+const char * dictionary_error_text(int code)
+{
+	switch (code) {
+	case DICTIONARY_NOT_ENOUGH_MEMORY:
+		return "not enough memory";
+	case DICTIONARY_EMPTY_LINE:
+		return "the line has no word";
+	case DICTIONARY_TOO_LARGE:
+		return "the dictionary is too large";
+	case DICTIONARY_NOT_A_WORD:
+		return "the word has a character that is not a letter, or an underscore between letters";
+	case DICTIONARY_NUL_CHARACTER:
+		return "the line has a NUL character";
+	case DICTIONARY_CANNOT_READ:
+		return "could not read the file";
+	case DICTIONARY_NO_WORDS:
+		return "the dictionary has no words";
+	case DICTIONARY_BAD_COMPILED:
+		return "not enough memory, or the compiled dictionary is damaged or of another version";
+	default:
+		return "unknown error";
+	}
+}
+
+/****************************************************************
+ * Summary: Frees a dictionary.                                 *
+ *                                                              *
+ * Parameters: dictionary - The dictionary to free.             *
+ *                                                              *
+ * Returns: void.                                               *
  ****************************************************************/
-list_node_t * create_dictionary(FILE *fp_dictionary)
+void destroy_dictionary(dictionary_t *dictionary)
 {
-	char *temp_word = NULL;
-	char *temp_line = NULL;
-	
-	list_node_t *first = NULL;
-	list_node_t *last = NULL;
-	
+	/* A dictionary read from text is a single block */
+	if (NULL == (*dictionary).slots) {
+		dictfile_close((*dictionary).words);
+	}
+	free(dictionary);
+}
+
+/****************************************************************
+ * Summary: Opens a dictionary compiled by compile_dictionary.  *
+ *          The file is mapped, not parsed.                     *
+ *                                                              *
+ * Parameters: path - The compiled dictionary file.             *
+ *                                                              *
+ * Returns: The dictionary if successful, otherwise NULL.       *
+ ****************************************************************/
+dictionary_t * open_compiled_dictionary(const char *path)
+{
+	dictionary_t *dictionary = NULL;
+
 	/* Allocate memory */
-	temp_line = (char *)malloc(sizeof(char) * DICTIONARY_MAX_LINE);
-	if (NULL == temp_line) {
+	dictionary = (dictionary_t *)malloc(sizeof(dictionary_t));
+	if (NULL == dictionary) {
+		return NULL;
+	}
+
+	memset(dictionary, 0, sizeof(dictionary_t));
+	(*dictionary).words = dictfile_open(path);
+	if (NULL == (*dictionary).words) {
+		free(dictionary);
 		return NULL;
 	}
 
-	/* Build dictionary */
-	while (NULL != fgets(temp_line, DICTIONARY_MAX_LINE, fp_dictionary)) {
-		last = interpret_line(temp_line, last);
+	return dictionary;
+}
 
-		/* If interpret_line failed, free memory and return NULL */
-		if(NULL == last) {
-			if (NULL != first) {
-				list_node_kill(first);
-			}
-			free(temp_line);
-			return NULL;
+/****************************************************************
+ * Summary: Writes a dictionary to a file that can be opened    *
+ *          with open_compiled_dictionary. Synonyms are written *
+ *          in the order find_synonym would return them next.   *
+ *                                                              *
+ * Parameters: dictionary - The dictionary.                     *
+ *             path - The file to write.                        *
+ *                                                              *
+ * Returns: 0 if successful, otherwise one of the DICTFILE      *
+ *          error codes.                                        *
+ ****************************************************************/
+int compile_dictionary(dictionary_t *dictionary, const char *path)
+{
+	return dictfile_write((*dictionary).words, path);
+}
+
+/* Parses and packs a dictionary, telling where it is wrong and which lines were skipped */
+static dictionary_t * parse(const char *path, const char *data, size_t size, int threads,
+							dictionary_error_t *error)
+{
+	int rc = 0;
+	dictparse_t words;
+	dictionary_t *dictionary = NULL;
+
+	dictparse_init(&words);
+	rc = dictparse_text(&words, data, size, threads);
+	if (0 == rc) {
+		warn_skipped(path, data, &words);
+	}
+	if (0 == rc && 0 == words.entry_count) {
+		rc = DICTIONARY_NO_WORDS;
+	}
+	if (0 == rc) {
+		dictionary = pack(&words);
+		if (NULL == dictionary) {
+			rc = DICTIONARY_NOT_ENOUGH_MEMORY;
 		}
+	}
 
-		if (NULL == first) {
-			first = last;
+	if (NULL != error) {
+		(*error).code = rc;
+		if (DICTIONARY_EMPTY_LINE == rc || DICTIONARY_NUL_CHARACTER == rc) {
+			locate(data, words.error_at, error);
 		}
 	}
-	
-	free(temp_line); /* Free memory */
+	dictparse_free(&words);
 
-	return first;
+	return dictionary;
+}
+
+/* Finds the line and column of an offset in a text */
+static void locate(const char *data, size_t offset, dictionary_error_t *error)
+{
+	size_t line_start = 0;
+	const char *newline = NULL;
+
+	(*error).line = 1;
+	while (NULL != (newline = (const char *)memchr(data + line_start, '\n', offset - line_start))) {
+		line_start = (size_t)(newline - data) + 1;
+		++(*error).line;
+	}
+	(*error).column = offset - line_start + 1;
+}
+
+/* Tells where the skipped lines are, counting lines in one pass as they are in order */
+static void warn_skipped(const char *path, const char *data, const dictparse_t *words)
+{
+	uint32_t i = 0;
+	size_t line = 1;
+	size_t line_start = 0;
+	size_t offset = 0;
+	const char *newline = NULL;
+
+	if (NULL == path) {
+		path = "dictionary";
+	}
+
+	for (i = 0 ; i < (*words).skipped_count && i < DICTIONARY_WARNINGS ; ++i) {
+		offset = (*words).skipped[i];
+		while (NULL != (newline = (const char *)memchr(data + line_start, '\n', offset - line_start))) {
+			line_start = (size_t)(newline - data) + 1;
+			++line;
+		}
+		fprintf(stderr, "%s:%lu:%lu: warning: %s, the line is skipped.\n", path, (unsigned long)line,
+				(unsigned long)(offset - line_start + 1), dictionary_error_text(DICTIONARY_NOT_A_WORD));
+	}
+	if ((*words).skipped_count > DICTIONARY_WARNINGS) {
+		fprintf(stderr, "%s: warning: %lu more lines skipped.\n", path,
+				(unsigned long)((*words).skipped_count - DICTIONARY_WARNINGS));
+	}
 }
 
 /****************************************************************
- * Summary: Converts a line from the dictionary file to a       *
- *          list_node_t for the dictionary.                     *
+ * Summary: Packs a dictionary that was read into one block,    *
+ *          indexing its words. The table is kept at most half  *
+ *          full. If a word is listed twice, its first line is  *
+ *          used. Every phrase a longer phrase starts with gets *
+ *          an entry flagged DICTFILE_PREFIX, after the entries *
+ *          of the lines.                                       *
  *                                                              *
- * Parameters: line - The line to interpret.                    *
- *             last - A pointer to the last node in the         *
- *                    dictionary, the new node is added after   *
- *                    this node.                                *
+ * Parameters: builder - The words that were parsed.            *
  *                                                              *
- * Returns: The new node if successful, otherwise NULL.         *
+ * Returns: The dictionary if successful, otherwise NULL.       *
  ****************************************************************/
-static list_node_t * interpret_line(char *line, list_node_t *last)
+static dictionary_t * pack(dictparse_t *builder)
 {
-	char *temp_word = NULL;
-	list_node_t *new_node = NULL;
+	uint32_t i = 0, n = 0;
+	uint32_t kept = 0, lines = 0;
+	uint32_t synonyms = 0;
+	uint32_t spaces = 0;				/* prefixes there may be */
+	size_t size = 16;
+	size_t slots_at = 0, entries_at = 0, synonyms_at = 0, rotation_at = 0, flags_at = 0, pool_at = 0;
+	size_t length = 0;
+	uint64_t hash = 0;
+	size_t probes = 0;
+	const char *word = NULL;
+	char *block = NULL;
+	dictionary_t *dictionary = NULL;
+	dictionary_slot_t *slot = NULL;
+	dictfile_entry_t *entries = NULL;
+	uint32_t *offsets = NULL;
+	uint8_t *flags = NULL;
 
-	/* Get the original word and create a node */
-	temp_word = strtok(line, DICTIONARY_SEPERATOR);
-	if (NULL != temp_word) {
-		new_node = list_node_add(last, temp_word);
-		if (NULL == new_node) {
-			return NULL;
+	for (i = 0 ; i < (*builder).entry_count ; ++i) {
+		word = (*builder).arena.pool + (*builder).entries[i].word;
+		for (n = 0 ; n < (*builder).entries[i].length ; ++n) {
+			spaces += (' ' == word[n]);
 		}
-	} else {
+	}
+	while (size < ((size_t)(*builder).entry_count + spaces) * 2) {
+		size *= 2;
+	}
+
+	/* Room for every line and prefix, a word listed twice leaves a little unused */
+	slots_at = ALIGN(sizeof(dictionary_t));
+	entries_at = slots_at + sizeof(dictionary_slot_t) * size;
+	synonyms_at = entries_at + sizeof(dictfile_entry_t) * ((size_t)(*builder).entry_count + spaces);
+	rotation_at = synonyms_at + sizeof(uint32_t) * (*builder).synonym_count;
+	flags_at = rotation_at + sizeof(uint32_t) * ((size_t)(*builder).entry_count + spaces);
+	pool_at = flags_at + (*builder).entry_count + spaces;
+	block = (char *)calloc(1, pool_at + (*builder).arena.used);
+	if (NULL == block) {
 		return NULL;
 	}
 
-	/* Add synonyms */
-	temp_word = strtok(NULL, DICTIONARY_SEPERATOR);
-	while (NULL != temp_word) {
-		if (NULL == (*new_node).synonyms) {
-			(*new_node).synonyms = circle_node_create(temp_word);
-		} else {
-			circle_node_add_after((*new_node).synonyms, temp_word);
+	dictionary = (dictionary_t *)block;
+	(*dictionary).slots = (dictionary_slot_t *)(block + slots_at);
+	(*dictionary).mask = size - 1;
+	(*dictionary).built.entries = entries = (dictfile_entry_t *)(block + entries_at);
+	(*dictionary).built.synonyms = offsets = (uint32_t *)(block + synonyms_at);
+	(*dictionary).built.rotation = (uint32_t *)(block + rotation_at);
+	(*dictionary).built.flags = flags = (uint8_t *)(block + flags_at);
+	(*dictionary).built.pool = block + pool_at;
+	(*dictionary).built.header = &(*dictionary).header;
+	(*dictionary).words = &(*dictionary).built;
+	memcpy(block + pool_at, (*builder).arena.pool, (*builder).arena.used);
+
+	for (i = 0 ; i < (*builder).entry_count ; ++i) {
+		word = (*builder).arena.pool + (*builder).entries[i].word;
+		hash = hash_bytes(word, (*builder).entries[i].length, DICTIONARY_SEED);
+		if (NULL != lookup(dictionary, word, (*builder).entries[i].length, hash, &probes)) { /* listed before */
+			continue;
+		}
+
+		entries[kept] = (*builder).entries[i];
+		entries[kept].first_synonym = synonyms;
+		for (n = 0 ; n < (*builder).entries[i].synonym_count ; ++n) {
+			offsets[synonyms] = (*builder).synonyms[(*builder).entries[i].first_synonym + n];
+			++synonyms;
+		}
+		slot = place(dictionary, word, entries[kept].length, hash);
+		++kept;
+		(*slot).entry = kept;
+	}
+
+	/* Flag the phrases every phrase starts with, adding those not listed */
+	for (lines = kept, i = 0 ; i < lines ; ++i) {
+		word = (*dictionary).built.pool + entries[i].word;
+		if (NULL != memchr(word, ' ', entries[i].length)) {
+			++(*dictionary).header.phrase_count;
+		}
+		for (length = 1 ; length < entries[i].length ; ++length) {
+			if (' ' != word[length]) {
+				continue;
+			}
+
+			hash = hash_bytes(word, length, DICTIONARY_SEED);
+			slot = lookup(dictionary, word, length, hash, &probes);
+			if (NULL == slot) {
+				entries[kept].word = entries[i].word;
+				entries[kept].length = (uint32_t)length;
+				entries[kept].first_synonym = synonyms;
+				entries[kept].synonym_count = 0;
+				slot = place(dictionary, word, length, hash);
+				++kept;
+				(*slot).entry = kept;
+			}
+			if (0 == flags[(*slot).entry - 1]) {
+				flags[(*slot).entry - 1] = DICTFILE_PREFIX;
+				++(*dictionary).header.prefix_count;
+			}
 		}
-		temp_word = strtok(NULL, DICTIONARY_SEPERATOR);
 	}
 
-	return new_node;
+	(*dictionary).header.entry_count = kept;
+	(*dictionary).header.synonym_count = synonyms;
+	(*dictionary).header.pool_size = (*builder).arena.used;
+
+	return dictionary;
+}
+
+/* Takes the free slot of a word that is not in the table, by linear probing */
+static dictionary_slot_t * place(dictionary_t *dictionary, const char *word, size_t length, uint64_t hash)
+{
+	dictionary_slot_t *slot = &(*dictionary).slots[hash & (*dictionary).mask];
+
+	while (0 != (*slot).entry) {
+		slot = &(*dictionary).slots[(slot - (*dictionary).slots + 1) & (*dictionary).mask];
+	}
+	(*slot).hash = hash;
+	(*slot).length = (uint32_t)length;
+	if (length < DICTIONARY_INLINE_KEY) {
+		memcpy((*slot).key, word, length);
+	}
+
+	return slot;
 }
 
 /****************************************************************
  * Summary: Searches for a synonym to word within given         *
- *          dictionary.                                         *
+ *          dictionary. word is converted to lowercase.         *
+ *          Every call for the same word returns the next       *
+ *          synonym in its ring.                                *
  *                                                              *
  * Parameters: word - The original word.                        *
- *             dictionary - A pointer to the first node in the  *
- *                          dictionary with the synonyms.       *
+ *             dictionary - The dictionary with the synonyms.   *
  *                                                              *
  * Returns: A synonym if found, otherwise the original word.    *
  ****************************************************************/
-char * find_synonym(char *word, list_node_t *dictionary)
+char * find_synonym(char *word, dictionary_t *dictionary)
+{
+	size_t length = strlen(strlwr(word));
+	char *synonym = NULL;
+	const dictfile_entry_t *entry = find(dictionary, word, length);
+
+	if (NULL == entry) { /* word is not in dictionary */
+		return word;
+	}
+
+	/* A word listed without synonyms stays as it is */
+	synonym = dictfile_next_synonym((*dictionary).words, entry);
+	return (NULL != synonym) ? synonym : word;
+}
+
+/****************************************************************
+ * Summary: Gets the amount of entries of a dictionary. Entries *
+ *          are numbered from 0 up to this amount.              *
+ *                                                              *
+ * Parameters: dictionary - The dictionary.                     *
+ *                                                              *
+ * Returns: The amount of entries.                              *
+ ****************************************************************/
+size_t dictionary_entry_count(dictionary_t *dictionary)
+{
+	return (*(*(*dictionary).words).header).entry_count;
+}
+
+/****************************************************************
+ * Summary: Finds the entry of a word. Nothing is changed, so   *
+ *          this can be called from many threads at once.       *
+ *                                                              *
+ * Parameters: dictionary - The dictionary.                     *
+ *             word - The word, in lowercase.                   *
+ *             length - The length of word.                     *
+ *                                                              *
+ * Returns: The entry if found, otherwise -1.                   *
+ ****************************************************************/
+long dictionary_find_entry(dictionary_t *dictionary, const char *word, size_t length)
+{
+	const dictfile_entry_t *entry = find(dictionary, word, length);
+
+	return (NULL == entry) ? -1 : (long)(entry - (*(*dictionary).words).entries);
+}
+
+/****************************************************************
+ * Summary: Checks whether a dictionary has phrases, so a text  *
+ *          can only be split between words that a character    *
+ *          other than a space is between.                      *
+ *                                                              *
+ * Parameters: dictionary - The dictionary.                     *
+ *                                                              *
+ * Returns: 1 if it has phrases, otherwise 0.                   *
+ ****************************************************************/
+int dictionary_has_phrases(dictionary_t *dictionary)
+{
+	return 0 != (*(*(*dictionary).words).header).prefix_count;
+}
+
+/****************************************************************
+ * Summary: Finds the entry a word of a text starts, the        *
+ *          longest phrase that has synonyms, or else the word  *
+ *          itself. The words of a phrase are apart by spaces,  *
+ *          tabs and newlines in the text. Nothing is changed,  *
+ *          so this can be called from many threads at once.    *
+ *                                                              *
+ * Parameters: dictionary - The dictionary.                     *
+ *             text - The text.                                 *
+ *             size - The length of text.                       *
+ *             start - Where the word starts.                   *
+ *             end - Where the word ends, at most               *
+ *                   DICTIONARY_MAX_LINE letters after start.   *
+ *             last - 1 if text ends where size says, 0 if it   *
+ *                    may go on.                                *
+ *             entry - Receives the entry, or -1 if the word is *
+ *                     not in the dictionary.                   *
+ *             match_end - Receives where the entry ends in     *
+ *                         text.                                *
+ *                                                              *
+ * Returns: 0 if successful, DICTIONARY_MORE_TEXT if the        *
+ *          phrase may go on past size.                         *
+ ****************************************************************/
+int dictionary_match(dictionary_t *dictionary, const char *text, size_t size, size_t start, size_t end, int last,
+					 long *entry, size_t *match_end)
+{
+	size_t length = end - start;
+	size_t from = 0, to = 0;
+	const dictfile_t *words = (*dictionary).words;
+	const dictfile_entry_t *found = NULL;
+	char key[DICTIONARY_MAX_PHRASE + 1];
+
+	scan_lower(key, text + start, length);
+	found = find(dictionary, key, length);
+	*entry = (NULL == found) ? -1 : (long)(found - (*words).entries);
+	*match_end = end;
+
+	/* Every word of a phrase but the last is flagged, and so is every phrase it starts with */
+	while (NULL != found && 0 != (DICTFILE_PREFIX & (*words).flags[found - (*words).entries])) {
+		for (from = end ; from < size && from - start <= DICTIONARY_MAX_PHRASE && SCAN_IS_SPACE(text[from]) ; ++from) {
+		}
+		for (to = from ; to < size && to - start <= DICTIONARY_MAX_PHRASE && SCAN_IS_LETTER(text[to]) ; ++to) {
+		}
+
+		/* Past DICTIONARY_MAX_PHRASE the text decides, not where it was cut */
+		if (to - start > DICTIONARY_MAX_PHRASE) {
+			break;
+		}
+		if (to == size && !last) {
+			return DICTIONARY_MORE_TEXT;
+		}
+		if (from == to || from == end) {
+			break;
+		}
+
+		key[length] = ' ';
+		scan_lower(key + length + 1, text + from, to - from);
+		length += 1 + to - from;
+		found = find(dictionary, key, length);
+		if (NULL != found && 0 != (*found).synonym_count) {
+			*entry = (long)(found - (*words).entries);
+			*match_end = to;
+		}
+		end = to;
+	}
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Gets the next synonym of an entry, in turn, as      *
+ *          find_synonym does for a word.                       *
+ *                                                              *
+ * Parameters: dictionary - The dictionary.                     *
+ *             entry - An entry from dictionary_match.          *
+ *                                                              *
+ * Returns: The synonym, or NULL if the entry has no synonyms.  *
+ ****************************************************************/
+char * dictionary_next_synonym(dictionary_t *dictionary, long entry)
+{
+	return dictfile_next_synonym((*dictionary).words, &(*(*dictionary).words).entries[entry]);
+}
+
+/****************************************************************
+ * Summary: Gets the synonym find_synonym would return for an   *
+ *          entry after turn more calls, without changing the   *
+ *          dictionary.                                         *
+ *                                                              *
+ * Parameters: dictionary - The dictionary.                     *
+ *             entry - An entry from dictionary_find_entry.     *
+ *             turn - The amount of calls to look past.         *
+ *                                                              *
+ * Returns: The synonym, or NULL if the word has no synonyms.   *
+ ****************************************************************/
+char * dictionary_peek_synonym(dictionary_t *dictionary, long entry, uint64_t turn)
+{
+	return dictfile_peek_synonym((*dictionary).words, &(*(*dictionary).words).entries[entry], turn);
+}
+
+/****************************************************************
+ * Summary: Moves the synonyms of an entry as if find_synonym   *
+ *          was called turns times.                             *
+ *                                                              *
+ * Parameters: dictionary - The dictionary.                     *
+ *             entry - An entry from dictionary_find_entry.     *
+ *             turns - The amount of calls.                     *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void dictionary_skip_synonyms(dictionary_t *dictionary, long entry, uint64_t turns)
+{
+	dictfile_skip_synonyms((*dictionary).words, &(*(*dictionary).words).entries[entry], turns);
+}
+
+/* Finds the entry of a word in lowercase, by perfect hash if compiled */
+static const dictfile_entry_t * find(dictionary_t *dictionary, const char *word, size_t length)
 {
-	/* Find word */
-	while (NULL != dictionary) {
-		if (0 == strcmp(strlwr(word), (*dictionary).word)) {/* found */
-			return list_node_get_synonym(dictionary);
-		} else {
-			dictionary = (*dictionary).next;
+	size_t probes = 1;					/* a perfect hash compares one entry */
+	dictionary_slot_t *slot = NULL;
+	const dictfile_entry_t *entry = NULL;
+
+	if (NULL == (*dictionary).slots) {
+		entry = dictfile_find((*dictionary).words, word, length);
+	} else {
+		probes = 0;
+		slot = lookup(dictionary, word, length, hash_bytes(word, length, DICTIONARY_SEED), &probes);
+		entry = (NULL == slot) ? NULL : &(*(*dictionary).words).entries[(*slot).entry - 1];
+	}
+
+	STATS_ADD(STATS_LOOKUPS, 1);
+	STATS_ADD(STATS_HITS, NULL != entry);
+	STATS_ADD(STATS_PROBES, probes);
+
+	return entry;
+}
+
+/****************************************************************
+ * Summary: Finds the slot of a word.                           *
+ *                                                              *
+ * Parameters: dictionary - The dictionary.                     *
+ *             word - The word, in lowercase.                   *
+ *             length - The length of word.                     *
+ *             hash - The hash of word.                         *
+ *             probes - Is added the amount of slots looked at. *
+ *                                                              *
+ * Returns: The slot if found, otherwise NULL.                  *
+ ****************************************************************/
+static dictionary_slot_t * lookup(dictionary_t *dictionary, const char *word, size_t length, uint64_t hash,
+								  size_t *probes)
+{
+	size_t i = hash & (*dictionary).mask;
+	const char *key = NULL;
+	dictionary_slot_t *slot = NULL;
+
+	for (slot = &(*dictionary).slots[i] ; 0 != (*slot).entry ; slot = &(*dictionary).slots[i]) {
+		++*probes;
+		if (hash == (*slot).hash && length == (*slot).length) {
+			/* Short words are compared without touching the pool */
+			key = (length < DICTIONARY_INLINE_KEY) ? (*slot).key :
+				(*(*dictionary).words).pool + (*(*dictionary).words).entries[(*slot).entry - 1].word;
+			if (0 == memcmp(key, word, length)) {
+				return slot;
+			}
 		}
+		i = (i + 1) & (*dictionary).mask;
 	}
-	/* word is not in dictionary */
-	return word;
-}
\ No newline at end of file
+	++*probes;							/* the empty slot */
+
+	return NULL;
+}
@@ -2,13 +2,89 @@
 #define _DICTOINARY_H_
 
 #include <stdio.h>
-#include "list.h"
+#include <stdint.h>
+#include "dictfile.h"
 
+/* Longest word that is looked up, a line of a dictionary may be longer */
 #define DICTIONARY_MAX_LINE (256)
-#define DICTIONARY_SEPERATOR (" \n")
 
-list_node_t * create_dictionary(FILE *fp_dictionary);
+/* Most bytes of text a phrase is looked up in, from its first word to its last */
+#define DICTIONARY_MAX_PHRASE (1024)
 
-char * find_synonym(char *word, list_node_t *dictionary);
+/* dictionary_match cannot tell where a phrase ends before the text goes on */
+#define DICTIONARY_MORE_TEXT (1)
 
-#endif
\ No newline at end of file
+#define DICTIONARY_NOT_ENOUGH_MEMORY (-1)
+#define DICTIONARY_EMPTY_LINE (-2)
+#define DICTIONARY_TOO_LARGE (-3)
+#define DICTIONARY_NOT_A_WORD (-4)
+#define DICTIONARY_NUL_CHARACTER (-5)
+#define DICTIONARY_CANNOT_READ (-6)
+#define DICTIONARY_NO_WORDS (-7)
+#define DICTIONARY_BAD_COMPILED (-8)
+
+/* Words shorter than this are kept in the slot itself */
+#define DICTIONARY_INLINE_KEY (16)
+
+#define DICTIONARY_SEED (0x2d358dccaa6c78a5ULL)
+
+/* Why a dictionary could not be loaded, and where */
+typedef struct dictionary_error_rec {
+	int code;
+	size_t line;					/* from 1, 0 if the error is not on a line */
+	size_t column;					/* from 1 */
+} dictionary_error_t;
+
+typedef struct dictionary_slot_rec {
+	uint64_t hash;
+	uint32_t length;
+	uint32_t entry;					/* index + 1, 0 if the slot is empty */
+	char key[DICTIONARY_INLINE_KEY];
+} dictionary_slot_t;
+
+/*
+ * Words, synonym rings and strings are laid out as in a compiled
+ * dictionary, whether they were mapped from one or read from text. A
+ * dictionary read from text is one allocation: this struct, then the
+ * slots that find its words, then the arrays words points to.
+ */
+typedef struct dictionary_rec {
+	dictfile_t *words;				/* entries in file order if read from text */
+	dictionary_slot_t *slots;		/* NULL if compiled, which has a perfect hash instead */
+	size_t mask;					/* amount of slots - 1 */
+	dictfile_header_t header;		/* the sizes of a dictionary read from text */
+	dictfile_t built;
+} dictionary_t;
+
+dictionary_t * create_dictionary(FILE *fp_dictionary);
+
+dictionary_t * load_dictionary(const char *path, int threads, dictionary_error_t *error);
+
+dictionary_t * open_dictionary(const char *path, int threads, dictionary_error_t *error);
+
+const char * dictionary_error_text(int code);
+
+dictionary_t * open_compiled_dictionary(const char *path);
+
+int compile_dictionary(dictionary_t *dictionary, const char *path);
+
+void destroy_dictionary(dictionary_t *dictionary);
+
+char * find_synonym(char *word, dictionary_t *dictionary);
+
+size_t dictionary_entry_count(dictionary_t *dictionary);
+
+long dictionary_find_entry(dictionary_t *dictionary, const char *word, size_t length);
+
+int dictionary_has_phrases(dictionary_t *dictionary);
+
+int dictionary_match(dictionary_t *dictionary, const char *text, size_t size, size_t start, size_t end, int last,
+					 long *entry, size_t *match_end);
+
+char * dictionary_next_synonym(dictionary_t *dictionary, long entry);
+
+char * dictionary_peek_synonym(dictionary_t *dictionary, long entry, uint64_t turn);
+
+void dictionary_skip_synonyms(dictionary_t *dictionary, long entry, uint64_t turns);
+
+#endif
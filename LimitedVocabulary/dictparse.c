@@ -0,0 +1,475 @@
+/****************************************************************
+ * Summary: Parses the text of a dictionary in one pass. The    *
+ *          text is classified SCAN_BLOCK bytes at a time into  *
+ *          masks of separators and newlines, and the words are *
+ *          taken from the masks with bit scans, so lines can   *
+ *          be of any length and nothing is copied but the      *
+ *          words themselves.                                   *
+ *                                                              *
+ *          A large text is split at newlines into ranges that  *
+ *          are parsed on threads of their own, and the ranges  *
+ *          are joined in order afterwards. A word is kept once *
+ *          per range it is in.                                 *
+ ****************************************************************/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE (200809L)
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "dictparse.h"
+#include "dictionary.h"
+#include "scan.h"
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+static void * parse_range(void *arg);
+
+static int add_token(dictparse_t *parse, size_t start, size_t end, int first);
+
+static int end_line(dictparse_t *parse, size_t line, int words);
+
+static int intern(dictparse_t *parse, const char *token, size_t length, uint32_t *offset);
+
+static int join(dictparse_t *parse, dictparse_t *from);
+
+static int grow(void **array, uint32_t *size, uint32_t needed, size_t item);
+
+/****************************************************************
+ * Summary: Starts an empty parse.                              *
+ *                                                              *
+ * Parameters: parse - The parse.                               *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void dictparse_init(dictparse_t *parse)
+{
+	memset(parse, 0, sizeof(dictparse_t));
+	arena_init(&(*parse).arena);
+}
+
+/****************************************************************
+ * Summary: Frees what a parse found.                           *
+ *                                                              *
+ * Parameters: parse - The parse.                               *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void dictparse_free(dictparse_t *parse)
+{
+	arena_free(&(*parse).arena);
+	free((*parse).entries);
+	free((*parse).synonyms);
+	free((*parse).word);
+	free((*parse).skipped);
+	dictparse_init(parse);
+}
+
+/****************************************************************
+ * Summary: Parses the text of a dictionary. Every line is a    *
+ *          word and its synonyms, separated by spaces, tabs or *
+ *          carriage returns. The word must be letters only, as *
+ *          no other word of a text is looked up, or a phrase   *
+ *          of words joined by underscores, otherwise the line  *
+ *          is skipped and listed in skipped. An underscore in  *
+ *          a synonym is written as a space.                    *
+ *                                                              *
+ * Parameters: parse - An empty parse, receiving the words.     *
+ *             data - The text.                                 *
+ *             size - The length of data.                       *
+ *             threads - The most threads to parse on, or 0 for *
+ *                       one per online processor.              *
+ *                                                              *
+ * Returns: 0 if successful, otherwise DICTIONARY_EMPTY_LINE or *
+ *          DICTIONARY_NUL_CHARACTER with the error_at of parse *
+ *          telling where, or DICTIONARY_NOT_ENOUGH_MEMORY or   *
+ *          DICTIONARY_TOO_LARGE.                               *
+ ****************************************************************/
+int dictparse_text(dictparse_t *parse, const char *data, size_t size, int threads)
+{
+	int rc = 0;
+	int t = 0;
+	int count = 0;
+	size_t position = 0;
+	const char *newline = NULL;
+	dictparse_t *ranges = NULL;
+#if !defined(_WIN32)
+	int started = 0;
+	pthread_t workers[DICTPARSE_MAX_THREADS];
+#endif
+
+	/* Small texts are parsed here */
+#if !defined(_WIN32)
+	if (0 == threads) {
+		threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+#endif
+	if (threads > DICTPARSE_MAX_THREADS) {
+		threads = DICTPARSE_MAX_THREADS;
+	}
+	if ((size_t)threads > size / DICTPARSE_MIN_RANGE) {
+		threads = (int)(size / DICTPARSE_MIN_RANGE);
+	}
+	if (threads <= 1) {
+		(*parse).data = data;
+		(*parse).start = 0;
+		(*parse).end = size;
+		parse_range(parse);
+		return (*parse).rc;
+	}
+
+	/* Split at newlines, so every range has whole lines */
+	ranges = (dictparse_t *)malloc(sizeof(dictparse_t) * threads);
+	if (NULL == ranges) {
+		return DICTIONARY_NOT_ENOUGH_MEMORY;
+	}
+	for (count = 0 ; count < threads && position < size ; ++count) {
+		dictparse_init(&ranges[count]);
+		ranges[count].data = data;
+		ranges[count].start = position;
+		position = size / threads * (count + 1);
+		if (position < ranges[count].start) { /* the last range had long lines */
+			position = ranges[count].start;
+		}
+		newline = (count + 1 < threads) ? (const char *)memchr(data + position, '\n', size - position) : NULL;
+		position = (NULL != newline) ? (size_t)(newline - data) + 1 : size;
+		ranges[count].end = position;
+	}
+
+#if !defined(_WIN32)
+	for (started = 1 ; started < count ; ++started) {
+		if (0 != pthread_create(&workers[started], NULL, parse_range, &ranges[started])) {
+			break;
+		}
+	}
+	parse_range(&ranges[0]);
+	for (t = started ; t < count ; ++t) {
+		parse_range(&ranges[t]);
+	}
+	for (t = 1 ; t < started ; ++t) {
+		pthread_join(workers[t], NULL);
+	}
+#else
+	for (t = 0 ; t < count ; ++t) {
+		parse_range(&ranges[t]);
+	}
+#endif
+
+	/* The first range that failed has the first error */
+	for (t = 0 ; t < count && 0 == rc ; ++t) {
+		rc = ranges[t].rc;
+		(*parse).error_at = ranges[t].error_at;
+	}
+	for (t = 0 ; t < count && 0 == rc ; ++t) {
+		rc = join(parse, &ranges[t]);
+	}
+
+	for (t = 0 ; t < count ; ++t) {
+		dictparse_free(&ranges[t]);
+	}
+	free(ranges);
+
+	(*parse).rc = rc;
+	return rc;
+}
+
+/****************************************************************
+ * Summary: Parses the lines of a range. A word starts where a  *
+ *          separator is followed by something else, and ends   *
+ *          at the next separator.                              *
+ *                                                              *
+ * Parameters: arg - The parse, with its range.                 *
+ *                                                              *
+ * Returns: NULL, the result is in the rc of the parse.         *
+ ****************************************************************/
+static void * parse_range(void *arg)
+{
+	int rc = 0;
+	int words = 0;						/* on the current line */
+	int in_token = 0;
+	int skipping = 0;					/* the word of the current line was skipped */
+	int bit = 0;
+	dictparse_t *parse = (dictparse_t *)arg;
+	const char *data = (*parse).data;
+	const char *nul = NULL;
+	size_t base = 0, offset = 0;
+	size_t stop = (*parse).end;
+	size_t token = 0;
+	size_t line = (*parse).start;
+	uint64_t separators = 0, newlines = 0, edges = 0;
+	uint64_t last = 1;					/* a line starts as if after a separator */
+	char padded[SCAN_BLOCK];
+
+	/* Nothing past a '\0' can be kept as a string */
+	nul = (const char *)memchr(data + (*parse).start, '\0', (*parse).end - (*parse).start);
+	if (NULL != nul) {
+		stop = (size_t)(nul - data);
+	}
+
+	for (base = (*parse).start ; base < stop && 0 == rc ; base += SCAN_BLOCK) {
+		/* A block past the end is padded with separators */
+		if (stop - base >= SCAN_BLOCK) {
+			separators = scan_separators(data + base, &newlines);
+		} else {
+			memset(padded, ' ', SCAN_BLOCK);
+			memcpy(padded, data + base, stop - base);
+			separators = scan_separators(padded, &newlines);
+		}
+		edges = (separators ^ ((separators << 1) | last)) | newlines;
+		last = separators >> (SCAN_BLOCK - 1);
+
+		while (0 != edges && 0 == rc) {
+			bit = scan_lowest_bit(edges);
+			edges &= edges - 1;
+			offset = base + (size_t)bit;
+
+			if (0 == ((separators >> bit) & 1)) {
+				token = offset;
+				in_token = 1;
+				continue;
+			}
+			if (in_token) {
+				in_token = 0;
+				if (!skipping) {
+					rc = add_token(parse, token, offset, 0 == words);
+				}
+				if (DICTPARSE_SKIPPED == rc) {
+					skipping = 1;
+					rc = 0;
+				}
+				++words;
+			}
+			if (0 == rc && 0 != ((newlines >> bit) & 1)) {
+				if (!skipping) {
+					rc = end_line(parse, line, words);
+				}
+				line = offset + 1;
+				words = 0;
+				skipping = 0;
+			}
+		}
+	}
+
+	if (0 == rc && NULL != nul) {
+		rc = DICTIONARY_NUL_CHARACTER;
+		(*parse).error_at = stop;
+	}
+
+	/* The text may end without a newline */
+	if (0 == rc && in_token && !skipping) {
+		rc = add_token(parse, token, stop, 0 == words);
+		if (DICTPARSE_SKIPPED == rc) {
+			skipping = 1;
+			rc = 0;
+		}
+		++words;
+	}
+	if (0 == rc && line < stop && !skipping) {
+		rc = end_line(parse, line, words);
+	}
+
+	(*parse).rc = rc;
+	return NULL;
+}
+
+/* Adds a word or a synonym of the last word, or skips a word that is never looked up */
+static int add_token(dictparse_t *parse, size_t start, size_t end, int first)
+{
+	int rc = 0;
+	size_t i = 0;
+	const char *token = (*parse).data + start;
+	dictfile_entry_t *entry = NULL;
+
+	if (!first) {
+		rc = grow((void **)&(*parse).synonyms, &(*parse).synonym_size, (*parse).synonym_count + 1,
+				  sizeof(uint32_t));
+		if (0 == rc) {
+			rc = intern(parse, token, end - start, &(*parse).synonyms[(*parse).synonym_count]);
+		}
+		if (0 == rc) {
+			++(*parse).synonym_count;
+			++(*parse).entries[(*parse).entry_count - 1].synonym_count;
+		}
+		return rc;
+	}
+
+	/* Words of a phrase are joined by single underscores */
+	for (i = 0 ; i < end - start ; ++i) {
+		if (!SCAN_IS_LETTER(token[i]) &&
+			('_' != token[i] || 0 == i || i + 1 == end - start || '_' == token[i + 1])) {
+			rc = grow((void **)&(*parse).skipped, &(*parse).skipped_size, (*parse).skipped_count + 1,
+					  sizeof(size_t));
+			if (0 != rc) {
+				return rc;
+			}
+			(*parse).skipped[(*parse).skipped_count] = start + i;
+			++(*parse).skipped_count;
+			return DICTPARSE_SKIPPED;
+		}
+	}
+
+	rc = grow((void **)&(*parse).entries, &(*parse).entry_size, (*parse).entry_count + 1,
+			  sizeof(dictfile_entry_t));
+	if (0 != rc) {
+		return rc;
+	}
+	entry = &(*parse).entries[(*parse).entry_count];
+	rc = intern(parse, token, end - start, &(*entry).word);
+	if (0 != rc) {
+		return rc;
+	}
+	(*entry).length = (uint32_t)(end - start);
+	(*entry).first_synonym = (*parse).synonym_count;
+	(*entry).synonym_count = 0;
+	++(*parse).entry_count;
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Ends a line. The synonyms are used in the order the *
+ *          dictionary has always used them: the first one,     *
+ *          then the rest from the end of the line back.        *
+ *                                                              *
+ * Parameters: parse - The parse.                               *
+ *             line - Where the line starts.                    *
+ *             words - The amount of words on the line.         *
+ *                                                              *
+ * Returns: 0 if successful, DICTIONARY_EMPTY_LINE if the line  *
+ *          has no word.                                        *
+ ****************************************************************/
+static int end_line(dictparse_t *parse, size_t line, int words)
+{
+	uint32_t first = 0, last = 0;
+	uint32_t offset = 0;
+	dictfile_entry_t *entry = NULL;
+
+	if (0 == words) {
+		(*parse).error_at = line;
+		return DICTIONARY_EMPTY_LINE;
+	}
+
+	entry = &(*parse).entries[(*parse).entry_count - 1];
+	if ((*entry).synonym_count > 2) {
+		first = (*entry).first_synonym + 1;
+		last = (*entry).first_synonym + (*entry).synonym_count - 1;
+		for ( ; first < last ; ++first, --last) {
+			offset = (*parse).synonyms[first];
+			(*parse).synonyms[first] = (*parse).synonyms[last];
+			(*parse).synonyms[last] = offset;
+		}
+	}
+
+	return 0;
+}
+
+/* Adds a token to the arena in lowercase, underscores as spaces, or finds it there */
+static int intern(dictparse_t *parse, const char *token, size_t length, uint32_t *offset)
+{
+	size_t i = 0;
+	char *word = NULL;
+
+	if (length > (*parse).word_size) {
+		word = (char *)realloc((*parse).word, length * 2);
+		if (NULL == word) {
+			return DICTIONARY_NOT_ENOUGH_MEMORY;
+		}
+		(*parse).word = word;
+		(*parse).word_size = length * 2;
+	}
+	for (i = 0 ; i < length ; ++i) {
+		if ('A' <= token[i] && token[i] <= 'Z') {
+			(*parse).word[i] = (char)(token[i] | 0x20);
+		} else {
+			(*parse).word[i] = ('_' == token[i]) ? ' ' : token[i];
+		}
+	}
+
+	switch (arena_intern(&(*parse).arena, (*parse).word, length, offset)) {
+	case 0:
+		return 0;
+	case ARENA_TOO_LARGE:
+		return DICTIONARY_TOO_LARGE;
+	default:
+		return DICTIONARY_NOT_ENOUGH_MEMORY;
+	}
+}
+
+/* Adds the words of a range after those of the parse */
+static int join(dictparse_t *parse, dictparse_t *from)
+{
+	int rc = 0;
+	uint32_t i = 0;
+	uint32_t base = 0;
+	uint32_t entries = (*parse).entry_count;
+	uint32_t synonyms = (*parse).synonym_count;
+
+	rc = grow((void **)&(*parse).entries, &(*parse).entry_size, entries + (*from).entry_count,
+			  sizeof(dictfile_entry_t));
+	if (0 == rc) {
+		rc = grow((void **)&(*parse).synonyms, &(*parse).synonym_size, synonyms + (*from).synonym_count,
+				  sizeof(uint32_t));
+	}
+	if (0 == rc) {
+		rc = grow((void **)&(*parse).skipped, &(*parse).skipped_size,
+				  (*parse).skipped_count + (*from).skipped_count, sizeof(size_t));
+	}
+	if (0 == rc) {
+		rc = arena_append(&(*parse).arena, &(*from).arena, &base);
+		if (ARENA_TOO_LARGE == rc) {
+			return DICTIONARY_TOO_LARGE;
+		}
+		if (0 != rc) {
+			return DICTIONARY_NOT_ENOUGH_MEMORY;
+		}
+	}
+	if (0 != rc) {
+		return rc;
+	}
+
+	for (i = 0 ; i < (*from).entry_count ; ++i) {
+		(*parse).entries[entries + i] = (*from).entries[i];
+		(*parse).entries[entries + i].word += base;
+		(*parse).entries[entries + i].first_synonym += synonyms;
+	}
+	for (i = 0 ; i < (*from).synonym_count ; ++i) {
+		(*parse).synonyms[synonyms + i] = (*from).synonyms[i] + base;
+	}
+	if (0 != (*from).skipped_count) {
+		memcpy((*parse).skipped + (*parse).skipped_count, (*from).skipped, sizeof(size_t) * (*from).skipped_count);
+	}
+	(*parse).entry_count += (*from).entry_count;
+	(*parse).synonym_count += (*from).synonym_count;
+	(*parse).skipped_count += (*from).skipped_count;
+
+	return 0;
+}
+
+/* Makes room for needed items in an array, doubling it */
+static int grow(void **array, uint32_t *size, uint32_t needed, size_t item)
+{
+	size_t new_size = (0 == *size) ? 64 : (size_t)*size;
+	void *new_array = NULL;
+
+	if (needed <= *size) {
+		return 0;
+	}
+	while (new_size < needed) {
+		new_size *= 2;
+	}
+	if (new_size > UINT32_MAX) {
+		return DICTIONARY_TOO_LARGE;
+	}
+
+	new_array = realloc(*array, new_size * item);
+	if (NULL == new_array) {
+		return DICTIONARY_NOT_ENOUGH_MEMORY;
+	}
+	*array = new_array;
+	*size = (uint32_t)new_size;
+
+	return 0;
+}
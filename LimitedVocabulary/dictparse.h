@@ -0,0 +1,45 @@
+#if !defined(_DICTPARSE_H_)
+#define _DICTPARSE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "dictfile.h"
+
+/* Most threads a dictionary is parsed on */
+#define DICTPARSE_MAX_THREADS (64)
+
+/* Less text than this per thread is not worth a thread */
+#define DICTPARSE_MIN_RANGE (1 << 20)
+
+/* add_token found a word that cannot be looked up, its line is skipped */
+#define DICTPARSE_SKIPPED (1)
+
+/* The words of a dictionary text, before they are packed and indexed */
+typedef struct dictparse_rec {
+	arena_t arena;
+	dictfile_entry_t *entries;		/* in file order, a word listed twice is listed twice */
+	uint32_t entry_count;
+	uint32_t entry_size;
+	uint32_t *synonyms;				/* pool offsets, every ring in the order it is used */
+	uint32_t synonym_count;
+	uint32_t synonym_size;
+	char *word;						/* a word in lowercase, on its way to the arena */
+	size_t word_size;
+	const char *data;				/* the text, parsed from start to end */
+	size_t start;
+	size_t end;
+	int rc;
+	size_t error_at;				/* where in data the text is wrong */
+	size_t *skipped;				/* where in data every skipped line's word goes wrong, in order */
+	uint32_t skipped_count;
+	uint32_t skipped_size;
+} dictparse_t;
+
+void dictparse_init(dictparse_t *parse);
+
+void dictparse_free(dictparse_t *parse);
+
+int dictparse_text(dictparse_t *parse, const char *data, size_t size, int threads);
+
+#endif
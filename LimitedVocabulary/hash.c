@@ -0,0 +1,89 @@
+/****************************************************************
+ * Summary: A fast 64-bit string hash in the style of wyhash:   *
+ *          the key is read in 4 and 8 byte pieces and mixed    *
+ *          with 64x64->128 bit multiplications.                *
+ ****************************************************************/
+#include <string.h>
+#include "hash.h"
+
+#define HASH_P0 (0xa0761d6478bd642fULL)
+#define HASH_P1 (0xe7037ed1a0b428dbULL)
+#define HASH_P2 (0x8ebc6af09c88c6e3ULL)
+
+static uint64_t mix(uint64_t a, uint64_t b);
+static uint64_t read64(const unsigned char *p);
+static uint64_t read32(const unsigned char *p);
+
+/****************************************************************
+ * Summary: Hashes a key.                                       *
+ *                                                              *
+ * Parameters: key - The bytes to hash.                         *
+ *             length - The amount of bytes.                    *
+ *             seed - Selects one of many hash functions.       *
+ *                                                              *
+ * Returns: The hash of the key.                                *
+ ****************************************************************/
+uint64_t hash_bytes(const void *key, size_t length, uint64_t seed)
+{
+	size_t i = length;
+	uint64_t a = 0, b = 0;
+	const unsigned char *p = (const unsigned char *)key;
+
+	seed ^= mix(seed ^ HASH_P0, HASH_P1);
+
+	if (length <= 16) {
+		if (length >= 4) {
+			/* Two overlapping reads cover 4 to 16 bytes */
+			a = (read32(p) << 32) | read32(p + ((length >> 3) << 2));
+			b = (read32(p + length - 4) << 32) | read32(p + length - 4 - ((length >> 3) << 2));
+		} else if (length > 0) {
+			a = ((uint64_t)p[0] << 16) | ((uint64_t)p[length >> 1] << 8) | p[length - 1];
+		}
+	} else {
+		while (i > 16) {
+			seed = mix(read64(p) ^ HASH_P1, read64(p + 8) ^ seed);
+			p += 16;
+			i -= 16;
+		}
+		a = read64(p + i - 16);
+		b = read64(p + i - 8);
+	}
+
+	return mix(HASH_P2 ^ length, mix(a ^ HASH_P1, b ^ seed));
+}
+
+/* Multiplies into 128 bits and folds the halves together */
+static uint64_t mix(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+	unsigned __int128 r = (unsigned __int128)a * b;
+
+	return (uint64_t)r ^ (uint64_t)(r >> 64);
+#else
+	uint64_t a_lo = a & 0xffffffffULL, a_hi = a >> 32;
+	uint64_t b_lo = b & 0xffffffffULL, b_hi = b >> 32;
+	uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi;
+	uint64_t hl = a_hi * b_lo, hh = a_hi * b_hi;
+	uint64_t middle = (ll >> 32) + (lh & 0xffffffffULL) + (hl & 0xffffffffULL);
+	uint64_t lo = (middle << 32) | (ll & 0xffffffffULL);
+	uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (middle >> 32);
+
+	return lo ^ hi;
+#endif
+}
+
+static uint64_t read64(const unsigned char *p)
+{
+	uint64_t v = 0;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static uint64_t read32(const unsigned char *p)
+{
+	uint32_t v = 0;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
@@ -0,0 +1,9 @@
+#if !defined(_HASH_H_)
+#define _HASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+uint64_t hash_bytes(const void *key, size_t length, uint64_t seed);
+
+#endif
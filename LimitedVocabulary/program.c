@@ -2,13 +2,32 @@
  * Summary: This program recieves a text file and replaces      *
  *          words according to a given dictionary.              *
  *                                                              *
+ *          A dictionary can be compiled once to a file that    *
+ *          is mapped instead of parsed, and used the same way. *
+ *          The text is streamed, so any size can be rewritten. *
+ *          In batch mode, many files and directories are       *
+ *          rewritten with one dictionary on a pool of threads. *
+ *          As a server, the dictionary stays loaded and is     *
+ *          reloaded whenever its file changes. Built with      *
+ *          LV_ENABLE_STATS, --stats tells where the time went. *
+ *                                                              *
  * Example: limited_vocab dictionary.txt essay.txt              *
+ *          limited_vocab --compile dictionary.txt dict.lv      *
+ *          limited_vocab dict.lv essay.txt                     *
+ *          limited_vocab --stdout dict.lv - < essay.txt        *
+ *          limited_vocab --batch -j 8 dict.lv essays/          *
+ *          limited_vocab --serve dict.lv /tmp/vocab.sock       *
+ *          limited_vocab --stats=json dict.lv essay.txt        *
  ****************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 #include "dictionary.h"
+#include "dictfile.h"
+#include "rewrite.h"
+#include "batch.h"
+#include "serve.h"
+#include "stats.h"
 
 #define WRONG_ARGUMENTS			(-1)
 #define CANNOT_BUILD_DICTIONARY	(-2)
@@ -17,156 +36,271 @@
 #define CANNOT_OPEN_INPUT_FILE	(-5)
 #define CANNOT_CLOSE_VOCAB_FILE (-6)
 #define CANNOT_CLOSE_INPUT_FILE (-7)
+#define CANNOT_COMPILE_DICTIONARY (-8)
+
+#define CANNOT_WRITE_OUTPUT		(-9)
+#define CANNOT_SERVE			(-10)
+
+static int compile(const char *vocab_path, const char *compiled_path);
 
-#define MAX_WORD (30)
+static int rewrite(char *paths[], int count, dictionary_t *dictionary, int flags, int threads, int batch);
 
-static int rewrite(FILE *fp_text, list_node_t *dictionary);
+static int serve_vocabulary(const char *vocab_path, const char *address, int threads);
 
-static char * read_all(FILE * fp);
+static dictionary_t * open_vocabulary(const char *path, int threads, int *rc);
+
+static void print_usage(const char *program);
 
 int main(int argc, char *argv[])
 {
     int rc = 0;
-	
-	FILE *fp_vocab = NULL;
-	FILE *fp_text = NULL;
+	int i = 0;
+	int flags = 0;
+	int threads = 1;
+	int batch = 0;
+	int server = 0;
+	int compiling = 0;
+	int stats = -1;						/* the format, or -1 for none */
+	int path_count = 0;
+	char **paths = NULL;
+	uint64_t started = 0;
 
-	list_node_t *dictionary = NULL;
+	dictionary_t *dictionary = NULL;
 
-	/* Check argument count */
-	if (3 != argc) {
-		printf("Usage: %s vocabulary_file text_file\n", argv[0]);
+	/* Check arguments */
+	paths = (char **)malloc(sizeof(char *) * argc);
+	if (NULL == paths) {
+		fprintf(stderr, "Not enough memory.\n");
+		return NOT_ENOUGH_MEMORY;
+	}
+	for (i = 1 ; i < argc ; ++i) {
+		if (0 == strcmp(argv[i], "--batch")) {
+			batch = 1;
+		} else if (0 == strcmp(argv[i], "--serve")) {
+			server = 1;
+		} else if (0 == strcmp(argv[i], "--compile")) {
+			compiling = 1;
+		} else if (0 == strcmp(argv[i], "--stats")) {
+			stats = STATS_TEXT;
+		} else if (0 == strcmp(argv[i], "--stats=json")) {
+			stats = STATS_JSON;
+		} else if (0 == strcmp(argv[i], "--stdout")) {
+			flags |= REWRITE_TO_STDOUT;
+		} else if (0 == strcmp(argv[i], "--zero-copy")) {
+			flags |= REWRITE_ZERO_COPY;
+		} else if (0 == strcmp(argv[i], "-j") && i + 1 < argc) {
+			++i;
+			threads = atoi(argv[i]);
+		} else if ('-' == argv[i][0] && '-' == argv[i][1]) { /* unknown option */
+			path_count = -1;
+			break;
+		} else {
+			paths[path_count] = argv[i];
+			++path_count;
+		}
+	}
+	if ((!batch && 2 != path_count) || path_count < 2 || batch + server + compiling > 1) {
+		print_usage(argv[0]);
+		free(paths);
 		return WRONG_ARGUMENTS;
 	}
 
-	/* Open files */
-	fp_vocab = fopen(argv[1], "r");
-	if (NULL == fp_vocab) {
-		printf("Could not open %s.\n", argv[1]);
-		return CANNOT_OPEN_VOCAB_FILE;
+	if (compiling) {
+		rc = compile(paths[0], paths[1]);
+	} else if (server) {
+		rc = serve_vocabulary(paths[0], paths[1], threads);
+	} else {
+		/* Build dictionary, or map a compiled one */
+		dictionary = open_vocabulary(paths[0], threads, &rc);
+		if (NULL != dictionary) {
+			/* Rewrite text files */
+			started = STATS_NOW();
+			rc = rewrite(paths + 1, path_count - 1, dictionary, flags, threads, batch);
+			STATS_ADD(STATS_REWRITE_NS, STATS_NOW() - started);
+
+			/* Free dictionary */
+			destroy_dictionary(dictionary);
+		}
 	}
+	free(paths);
 
-	fp_text = fopen(argv[2], "r+");
-	if (NULL == fp_text) {
-		printf("Could not open %s.\n", argv[2]);
-		return CANNOT_OPEN_INPUT_FILE;
+	if (stats >= 0) {
+		stats_print(stderr, stats);
 	}
 
-	/* Build dictionary */
-	dictionary = create_dictionary(fp_vocab);
-	if(NULL == dictionary) {
-		printf("Not enough memory or dictionary file is in incorrect format.\n"
-				"Format is:\n\tword synonym1 synonym2...\n\tword synonym1 synonym2...\n");
-		return CANNOT_BUILD_DICTIONARY;
+	return rc;
+}
+
+/****************************************************************
+ * Summary: Rewrites a text file, or a batch of files and       *
+ *          directories, reporting what went wrong.             *
+ *                                                              *
+ * Parameters: paths - The text files.                          *
+ *             count - The amount of paths, 1 unless batch.     *
+ *             dictionary - The dictionary with the synonyms.   *
+ *             flags - As for rewrite_file.                     *
+ *             threads - The amount of threads.                 *
+ *             batch - 1 to rewrite paths with batch_rewrite.   *
+ *                                                              *
+ * Returns: 0 if successful, otherwise NOT_ENOUGH_MEMORY,       *
+ *          CANNOT_OPEN_INPUT_FILE or CANNOT_WRITE_OUTPUT.      *
+ ****************************************************************/
+static int rewrite(char *paths[], int count, dictionary_t *dictionary, int flags, int threads, int batch)
+{
+	if (batch) {
+		/* The report goes to stderr, as the text may go to stdout */
+		switch (batch_rewrite(dictionary, paths, count, flags, threads, stderr)) {
+		case 0:
+			return 0;
+		case BATCH_NOT_ENOUGH_MEMORY:
+			fprintf(stderr, "Not enough memory.\n");
+			return NOT_ENOUGH_MEMORY;
+		case BATCH_CANNOT_LIST:
+			fprintf(stderr, "Could not list a directory.\n");
+			return CANNOT_OPEN_INPUT_FILE;
+		default:
+			return CANNOT_WRITE_OUTPUT;
+		}
 	}
 
-	/* Rewrite text file */
-	if(0 != rewrite(fp_text, dictionary)) {
-		printf("Not enough memory.\n");
+	switch (rewrite_file(paths[0], dictionary, flags, threads)) {
+	case 0:
+		return 0;
+	case REWRITE_NOT_ENOUGH_MEMORY:
+		fprintf(stderr, "Not enough memory.\n");
 		return NOT_ENOUGH_MEMORY;
+	case REWRITE_CANNOT_READ:
+		fprintf(stderr, "Could not read %s.\n", paths[0]);
+		return CANNOT_OPEN_INPUT_FILE;
+	default:
+		fprintf(stderr, "Could not write the rewritten %s.\n", paths[0]);
+		return CANNOT_WRITE_OUTPUT;
 	}
+}
+
+/* Prints how the program is used */
+static void print_usage(const char *program)
+{
+	fprintf(stderr, "Usage: %s [--stdout] [--zero-copy] [-j threads] vocabulary_file text_file\n"
+			"       %s --batch [--stdout] [-j threads] vocabulary_file path...\n"
+			"       %s --serve [-j threads] vocabulary_file socket_path\n"
+			"       %s --compile vocabulary_file compiled_file\n"
+			"Every form also takes --stats, or --stats=json, to print to standard\n"
+			"error how long loading, rewriting and writing took and how the\n"
+			"vocabulary was used, in a build with -DLV_ENABLE_STATS.\n"
+			"text_file is rewritten in place, or to standard output with --stdout.\n"
+			"A text_file of - is read from standard input.\n"
+			"--zero-copy maps text_file and writes unchanged text straight from it.\n"
+			"-j rewrites text_file, and loads a large vocabulary_file, on that many\n"
+			"threads, 0 for one per processor.\n"
+			"--batch rewrites every file, and every file under a directory, on a pool\n"
+			"of -j threads, and reports how long each took.\n"
+			"--serve rewrites the texts of requests on a Unix socket, or on standard\n"
+			"input and output with a socket_path of -. A request is the length of its\n"
+			"text and a newline, followed by the text. vocabulary_file is reloaded\n"
+			"when it changes.\n"
+			"A vocabulary_file line is a word, or words joined by underscores for a\n"
+			"phrase, and its synonyms. The longest phrase in the text is replaced.\n",
+			program, program, program, program);
+}
 
-	/* Free dictionary */
-	list_node_kill(dictionary);
+/****************************************************************
+ * Summary: Compiles a dictionary file for faster loading.      *
+ *                                                              *
+ * Parameters: vocab_path - The dictionary file to compile.     *
+ *             compiled_path - The compiled file to write.      *
+ *                                                              *
+ * Returns: 0 if successful, otherwise CANNOT_OPEN_VOCAB_FILE,  *
+ *          CANNOT_BUILD_DICTIONARY or                          *
+ *          CANNOT_COMPILE_DICTIONARY.                          *
+ ****************************************************************/
+static int compile(const char *vocab_path, const char *compiled_path)
+{
+	int rc = 0;
+	dictionary_t *dictionary = NULL;
 
-	/* Close files */
-	rc = 0;
-	
-	if (0 != fclose(fp_vocab)) {
-		printf("Could not close %s.\n", argv[1]);
-		rc = CANNOT_CLOSE_VOCAB_FILE;
+	dictionary = open_vocabulary(vocab_path, 0, &rc);
+	if (NULL == dictionary) {
+		return rc;
 	}
-	
-	if (0 != fclose(fp_text)) {
-		printf("Could not close %s.\n", argv[2]);
-		rc =  CANNOT_CLOSE_INPUT_FILE;
+
+	if (0 != compile_dictionary(dictionary, compiled_path)) {
+		fprintf(stderr, "Could not write %s.\n", compiled_path);
+		rc = CANNOT_COMPILE_DICTIONARY;
 	}
 
+	destroy_dictionary(dictionary);
+
 	return rc;
 }
 
 /****************************************************************
- * Summary: Rewrites the given text file, replacing word with   *
- *          synonyms from dictionary.                           *
+ * Summary: Serves rewrites until interrupted.                  *
  *                                                              *
- * Parameters: fp_text - Represents the text file to rewrite.   *
- *             dictionary - A pointer to the first node in the  *
- *                          dictionary with the synonyms.       *
+ * Parameters: vocab_path - The dictionary file to serve.       *
+ *             address - The socket path, or - for standard     *
+ *                       input and output.                      *
+ *             threads - The most threads to load a text        *
+ *                       dictionary on, 0 for one per processor.*
  *                                                              *
- * Returns: 0 if successful, can return NOT_ENOUGH_MEMORY.      *
+ * Returns: 0 if successful, otherwise CANNOT_BUILD_DICTIONARY, *
+ *          NOT_ENOUGH_MEMORY or CANNOT_SERVE.                  *
  ****************************************************************/
-static int rewrite(FILE *fp_text, list_node_t *dictionary)
+static int serve_vocabulary(const char *vocab_path, const char *address, int threads)
 {
-	int i = 0, j = 0;
-	char *buffer = NULL;
-	char temp[MAX_WORD] = { 0 };
-	
-	/* Save text to buffer */
-	buffer = read_all(fp_text);
-	if (NULL == buffer) {
+	switch (serve(address, vocab_path, threads)) {
+	case 0:
+		return 0;
+	case SERVE_CANNOT_LOAD:
+		return CANNOT_BUILD_DICTIONARY;
+	case SERVE_NOT_ENOUGH_MEMORY:
+		fprintf(stderr, "Not enough memory.\n");
 		return NOT_ENOUGH_MEMORY;
+	case SERVE_NOT_SUPPORTED:
+		fprintf(stderr, "Serving is not supported on this system.\n");
+		return CANNOT_SERVE;
+	default:
+		return CANNOT_SERVE;
 	}
-
-	/* Reset write index */
-	fseek(fp_text, 0, SEEK_SET);
-
-	/* Seperate to words */
-	j = 0;
-	i = 0;
-	while ('\0' != buffer[i]) {
-		if (0 == isalpha(buffer[i])) {
-			temp[j] = '\0';
-			j = 0;
-			if (temp[0] != '\0') fprintf(fp_text, "%s", find_synonym(temp, dictionary));
-			memset(temp, 0, sizeof(char) * MAX_WORD);
-			fputc(buffer[i], fp_text);
-		} else {
-			temp[j] = buffer[i];
-			++j;
-		}
-		++i;
-	}
-	if (temp[0] != '\0') fprintf(fp_text, "%s", find_synonym(temp, dictionary));
-	
-	/* Free memory */
-	free(buffer);
-
-	return 0;
 }
 
 /****************************************************************
- * Summary: Reads a text file to a buffer.                      *
+ * Summary: Maps a compiled dictionary, or loads a text one,    *
+ *          telling what is wrong with it if it cannot be used. *
  *                                                              *
- * Parameters: fp - Represents the text file to read.           *
+ * Parameters: path - The dictionary file.                      *
+ *             threads - The most threads to parse a text       *
+ *                       dictionary on, 0 for one per processor.*
+ *             rc - Receives CANNOT_OPEN_VOCAB_FILE or          *
+ *                  CANNOT_BUILD_DICTIONARY on failure.         *
  *                                                              *
- * Returns: A buffer with the text if successful, otherwise     *
- *          NULL.                                               *
+ * Returns: The dictionary if successful, otherwise NULL.       *
  ****************************************************************/
-static char * read_all(FILE * fp)
+static dictionary_t * open_vocabulary(const char *path, int threads, int *rc)
 {
-	int i = 0;
-	int c = 0;
-	int fsize = 0;
-	char *buffer = NULL;
-
-	/* Get file size */
-	fseek(fp, 0, SEEK_END);
-	fsize = ftell(fp) + 1;
-	fseek(fp, 0, SEEK_SET);
-
-	/* Allocate memory */
-	buffer = (char *)malloc(sizeof(char) * fsize);
-	if (NULL == buffer) {
-		return NULL;
+	dictionary_t *dictionary = NULL;
+	dictionary_error_t error;
+
+	dictionary = open_dictionary(path, threads, &error);
+	if (NULL != dictionary) {
+		return dictionary;
 	}
 
-	/* Copy to buffer */
-	i = 0;
-	while (EOF != (c = fgetc(fp))) {
-		buffer[i] = (char)c;
-		++i;
+	if (DICTIONARY_CANNOT_READ == error.code) {
+		fprintf(stderr, "Could not open %s.\n", path);
+		*rc = CANNOT_OPEN_VOCAB_FILE;
+		return NULL;
 	}
-	buffer[i] = '\0';
+	if (0 != error.line) {
+		fprintf(stderr, "%s:%lu:%lu: %s.\n", path, (unsigned long)error.line, (unsigned long)error.column,
+				dictionary_error_text(error.code));
+	} else {
+		fprintf(stderr, "%s: %s.\n", path, dictionary_error_text(error.code));
+	}
+	if (DICTIONARY_BAD_COMPILED != error.code) {
+		fprintf(stderr, "Format is:\n\tword synonym1 synonym2...\n\tphrase_of_words synonym1 synonym2...\n");
+	}
+	*rc = CANNOT_BUILD_DICTIONARY;
 
-	return buffer;
-}
\ No newline at end of file
+	return NULL;
+}
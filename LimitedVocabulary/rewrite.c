@@ -0,0 +1,800 @@
+/****************************************************************
+ * Summary: Rewrites a stream, replacing words and phrases with *
+ *          synonyms. The input is read in chunks and the       *
+ *          output is collected in a buffer, so memory stays    *
+ *          the same whatever the size of the text. A word, or  *
+ *          a phrase, cut by the end of a chunk is carried to   *
+ *          the next one.                                       *
+ *                                                              *
+ *          A file is rewritten to a temporary file next to it, *
+ *          which then replaces it, so a failure part way       *
+ *          leaves the original as it was.                      *
+ *                                                              *
+ *          The zero copy rewrite maps the file instead. The    *
+ *          output is gathered as slices of the mapping between *
+ *          the words that change, and of the synonyms, and     *
+ *          written with writev, so unchanged text is never     *
+ *          copied by the program.                              *
+ ****************************************************************/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE (200809L)
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "rewrite.h"
+#include "scan.h"
+#include "stats.h"
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+typedef struct slice_writer_rec {
+	int fd;
+	struct iovec slices[REWRITE_SLICES];
+	int count;
+	char *scratch;					/* copied words, kept until written */
+	size_t used;
+} slice_writer_t;
+#endif
+
+static int feed(rewriter_t *rewriter, const char *text, size_t size, int last, size_t *used);
+
+static int put(rewriter_t *rewriter, const char *data, size_t size);
+
+static int put_lower(rewriter_t *rewriter, const char *letters, size_t length);
+
+static int flush(rewriter_t *rewriter);
+
+static int write_out(FILE *out, const char *data, size_t size);
+
+static FILE * open_temp(const char *path, char *temp_path);
+
+static int stream(rewrite_worker_t *worker, FILE *in, FILE *out);
+
+static void start(rewriter_t *rewriter, rewrite_worker_t *worker, FILE *out);
+
+static int finish(rewriter_t *rewriter);
+
+static int rewrite_path(rewrite_worker_t *worker, const char *path, int flags, int threads);
+
+static int rewrite_into(rewrite_worker_t *worker, FILE *in, FILE *out, int flags, int threads);
+
+static char * next_synonym(rewrite_worker_t *worker, long entry);
+
+#if !defined(_WIN32)
+static int rewrite_mapped(int fd_in, int fd_out, dictionary_t *dictionary);
+
+static int add_slice(slice_writer_t *writer, const char *data, size_t size);
+
+static int add_copy(slice_writer_t *writer, const char *data, size_t size);
+
+static int write_slices(slice_writer_t *writer);
+#endif
+
+/****************************************************************
+ * Summary: Rewrites a stream into another, replacing words     *
+ *          with synonyms from dictionary. Words are converted  *
+ *          to lowercase.                                       *
+ *                                                              *
+ * Parameters: in - The text to rewrite.                        *
+ *             out - Receives the rewritten text.               *
+ *             dictionary - The dictionary with the synonyms.   *
+ *                                                              *
+ * Returns: 0 if successful, otherwise REWRITE_NOT_ENOUGH_      *
+ *          MEMORY, REWRITE_CANNOT_READ or REWRITE_CANNOT_WRITE.*
+ ****************************************************************/
+int rewrite_stream(FILE *in, FILE *out, dictionary_t *dictionary)
+{
+	int rc = 0;
+	rewrite_worker_t *worker = rewrite_worker_create(dictionary, 0);
+
+	if (NULL == worker) {
+		return REWRITE_NOT_ENOUGH_MEMORY;
+	}
+	rc = stream(worker, in, out);
+	rewrite_worker_destroy(worker);
+
+	return rc;
+}
+
+/****************************************************************
+ * Summary: Rewrites a file in place, or to standard output.    *
+ *          REWRITE_STANDARD_STREAM rewrites standard input to  *
+ *          standard output.                                    *
+ *                                                              *
+ * Parameters: path - The file to rewrite.                      *
+ *             dictionary - The dictionary with the synonyms.   *
+ *             flags - REWRITE_TO_STDOUT to write to standard   *
+ *                     output instead of replacing the file,    *
+ *                     REWRITE_ZERO_COPY to map the file if it  *
+ *                     can be mapped.                           *
+ *             threads - The amount of threads to rewrite a     *
+ *                       file that can be mapped with, or 0 for *
+ *                       one per online processor.              *
+ *                                                              *
+ * Returns: 0 if successful, otherwise REWRITE_NOT_ENOUGH_      *
+ *          MEMORY, REWRITE_CANNOT_READ or REWRITE_CANNOT_WRITE.*
+ ****************************************************************/
+int rewrite_file(const char *path, dictionary_t *dictionary, int flags, int threads)
+{
+	int rc = 0;
+	rewrite_worker_t *worker = rewrite_worker_create(dictionary, 0);
+
+	if (NULL == worker) {
+		return REWRITE_NOT_ENOUGH_MEMORY;
+	}
+	rc = rewrite_path(worker, path, flags, threads);
+	rewrite_worker_destroy(worker);
+
+	return rc;
+}
+
+/****************************************************************
+ * Summary: Creates what a thread needs to rewrite files. With  *
+ *          its own rotation, a worker only reads the           *
+ *          dictionary, so workers on many threads can share    *
+ *          it, and every file gets the synonyms it would get   *
+ *          if it were rewritten alone.                         *
+ *                                                              *
+ * Parameters: dictionary - The dictionary with the synonyms.   *
+ *             own_rotation - 1 to keep the synonym rotation in *
+ *                            the worker, 0 to move the         *
+ *                            dictionary's.                     *
+ *                                                              *
+ * Returns: The worker if successful, otherwise NULL.           *
+ ****************************************************************/
+rewrite_worker_t * rewrite_worker_create(dictionary_t *dictionary, int own_rotation)
+{
+	size_t entries = dictionary_entry_count(dictionary);
+	rewrite_worker_t *worker = NULL;
+
+	/* Allocate memory */
+	worker = (rewrite_worker_t *)calloc(1, sizeof(rewrite_worker_t));
+	if (NULL == worker) {
+		return NULL;
+	}
+	(*worker).dictionary = dictionary;
+	(*worker).chunk = (char *)malloc(sizeof(char) * REWRITE_CHUNK);
+	(*worker).buffer = (char *)malloc(sizeof(char) * REWRITE_BUFFER);
+	if (own_rotation) {
+		(*worker).turns = (uint64_t *)calloc(entries, sizeof(uint64_t));
+		(*worker).touched = (long *)malloc(sizeof(long) * entries);
+	}
+	if (NULL == (*worker).chunk || NULL == (*worker).buffer ||
+		(own_rotation && (NULL == (*worker).turns || NULL == (*worker).touched))) {
+		rewrite_worker_destroy(worker);
+		return NULL;
+	}
+
+	return worker;
+}
+
+/****************************************************************
+ * Summary: Frees a worker.                                     *
+ *                                                              *
+ * Parameters: worker - The worker to free.                     *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void rewrite_worker_destroy(rewrite_worker_t *worker)
+{
+	free((*worker).chunk);
+	free((*worker).buffer);
+	free((*worker).turns);
+	free((*worker).touched);
+	free(worker);
+}
+
+/****************************************************************
+ * Summary: Rewrites a file with a worker, like rewrite_file on *
+ *          one thread. A worker with its own rotation always   *
+ *          streams the file, as the other rewrites move the    *
+ *          dictionary's rotation.                              *
+ *                                                              *
+ * Parameters: worker - The worker.                             *
+ *             path - The file to rewrite.                      *
+ *             flags - As for rewrite_file.                     *
+ *                                                              *
+ * Returns: 0 if successful, otherwise REWRITE_NOT_ENOUGH_      *
+ *          MEMORY, REWRITE_CANNOT_READ or REWRITE_CANNOT_WRITE.*
+ ****************************************************************/
+int rewrite_worker_file(rewrite_worker_t *worker, const char *path, int flags)
+{
+	return rewrite_path(worker, path, flags, 1);
+}
+
+/****************************************************************
+ * Summary: Rewrites text in memory with a worker, like         *
+ *          rewrite_stream. A worker with its own rotation      *
+ *          starts it over, so the same text always gets the    *
+ *          same synonyms.                                      *
+ *                                                              *
+ * Parameters: worker - The worker.                             *
+ *             text - The text to rewrite.                      *
+ *             size - The length of text.                       *
+ *             out - Receives the rewritten text.               *
+ *                                                              *
+ * Returns: 0 if successful, otherwise REWRITE_CANNOT_WRITE.    *
+ ****************************************************************/
+int rewrite_worker_text(rewrite_worker_t *worker, const char *text, size_t size, FILE *out)
+{
+	int rc = 0;
+	size_t used = 0;
+	rewriter_t rewriter;
+
+	STATS_ADD(STATS_BYTES_IN, size);
+	start(&rewriter, worker, out);
+	rc = feed(&rewriter, text, size, 1, &used);
+	if (0 == rc) {
+		rc = finish(&rewriter);
+	}
+
+	return rc;
+}
+
+/* Rewrites a stream with a worker, starting its own rotation over */
+static int stream(rewrite_worker_t *worker, FILE *in, FILE *out)
+{
+	int rc = 0;
+	size_t size = 0;
+	size_t kept = 0;					/* text carried to the front of the chunk */
+	size_t used = 0;
+	rewriter_t rewriter;
+
+	/* What is carried is at most a phrase, so every read adds to it */
+	start(&rewriter, worker, out);
+	while (0 == rc && 0 != (size = fread((*worker).chunk + kept, 1, REWRITE_CHUNK - kept, in))) {
+		STATS_ADD(STATS_BYTES_IN, size);
+		rc = feed(&rewriter, (*worker).chunk, kept + size, 0, &used);
+		kept = kept + size - used;
+		memmove((*worker).chunk, (*worker).chunk + used, kept);
+	}
+	if (0 == rc && 0 != ferror(in)) {
+		rc = REWRITE_CANNOT_READ;
+	}
+	if (0 == rc) {
+		rc = feed(&rewriter, (*worker).chunk, kept, 1, &used);
+	}
+	if (0 == rc) {
+		rc = finish(&rewriter);
+	}
+
+	return rc;
+}
+
+/* Starts a rewrite, and the worker's own rotation over */
+static void start(rewriter_t *rewriter, rewrite_worker_t *worker, FILE *out)
+{
+	while (0 != (*worker).touched_count) {
+		--(*worker).touched_count;
+		(*worker).turns[(*worker).touched[(*worker).touched_count]] = 0;
+	}
+
+	(*rewriter).worker = worker;
+	(*rewriter).out = out;
+	(*rewriter).used = 0;
+	(*rewriter).long_word = 0;
+}
+
+/* Ends a rewrite, writing what is buffered */
+static int finish(rewriter_t *rewriter)
+{
+	int rc = flush(rewriter);
+
+	if (0 == rc && 0 != fflush((*rewriter).out)) {
+		rc = REWRITE_CANNOT_WRITE;
+	}
+
+	return rc;
+}
+
+/* Rewrites a file in place or to standard output, as rewrite_file */
+static int rewrite_path(rewrite_worker_t *worker, const char *path, int flags, int threads)
+{
+	int rc = 0;
+	FILE *in = NULL;
+	FILE *out = NULL;
+	char *temp_path = NULL;
+
+	if (0 == strcmp(path, REWRITE_STANDARD_STREAM)) {
+		return stream(worker, stdin, stdout);
+	}
+
+	in = fopen(path, "rb");
+	if (NULL == in) {
+		return REWRITE_CANNOT_READ;
+	}
+
+	if (flags & REWRITE_TO_STDOUT) {
+		rc = rewrite_into(worker, in, stdout, flags, threads);
+		fclose(in);
+		return rc;
+	}
+
+	/* Room for the path and a suffix */
+	temp_path = (char *)malloc(sizeof(char) * (strlen(path) + 8));
+	if (NULL == temp_path) {
+		fclose(in);
+		return REWRITE_NOT_ENOUGH_MEMORY;
+	}
+	out = open_temp(path, temp_path);
+	if (NULL == out) {
+		fclose(in);
+		free(temp_path);
+		return REWRITE_CANNOT_WRITE;
+	}
+
+	rc = rewrite_into(worker, in, out, flags, threads);
+	fclose(in);
+
+#if !defined(_WIN32)
+	/* Make sure the text is on disk before it replaces the original */
+	if (0 == rc && 0 != fsync(fileno(out))) {
+		rc = REWRITE_CANNOT_WRITE;
+	}
+#endif
+	if (0 != fclose(out) && 0 == rc) {
+		rc = REWRITE_CANNOT_WRITE;
+	}
+
+	if (0 == rc) {
+#if defined(_WIN32)
+		remove(path); /* rename does not replace files on Windows */
+#endif
+		if (0 != rename(temp_path, path)) {
+			rc = REWRITE_CANNOT_WRITE;
+		}
+	}
+	if (0 != rc) {
+		remove(temp_path);
+	}
+
+	free(temp_path);
+
+	return rc;
+}
+
+/* Rewrites an open file, in parallel or mapped if asked and possible */
+static int rewrite_into(rewrite_worker_t *worker, FILE *in, FILE *out, int flags, int threads)
+{
+#if !defined(_WIN32)
+	int rc = 0;
+
+	if (NULL != (*worker).turns) {
+		return stream(worker, in, out);
+	}
+	if (1 != threads) {
+		rc = rewrite_parallel(fileno(in), out, (*worker).dictionary, threads);
+		if (REWRITE_NOT_MAPPED != rc) {
+			return rc;
+		}
+	}
+	if (flags & REWRITE_ZERO_COPY) {
+		/* Nothing may be left in out's buffer, it is written around */
+		if (0 != fflush(out)) {
+			return REWRITE_CANNOT_WRITE;
+		}
+		rc = rewrite_mapped(fileno(in), fileno(out), (*worker).dictionary);
+		if (REWRITE_NOT_MAPPED != rc) {
+			return rc;
+		}
+	}
+#else
+	(void)flags;
+	(void)threads;
+#endif
+
+	return stream(worker, in, out);
+}
+
+/****************************************************************
+ * Summary: Rewrites text up to where it is known what it       *
+ *          becomes. A word or a phrase that may go on past the *
+ *          end of the text is left for the next text, unless   *
+ *          this is the last. Words too long to have a synonym  *
+ *          are only lowercased, even if they go on.            *
+ *                                                              *
+ * Parameters: rewriter - The state of the rewrite.             *
+ *             text - The text.                                 *
+ *             size - The length of text.                       *
+ *             last - 1 if no text follows.                     *
+ *             used - Receives the length of the text that was  *
+ *                    rewritten, size if last.                  *
+ *                                                              *
+ * Returns: 0 if successful, otherwise REWRITE_CANNOT_WRITE.    *
+ ****************************************************************/
+static int feed(rewriter_t *rewriter, const char *text, size_t size, int last, size_t *used)
+{
+	int rc = 0;
+	int left = 0;						/* the end of text is left for the next one */
+	int long_word = (*rewriter).long_word;
+	size_t words = 0, replaced = 0, phrases = 0;
+	size_t position = 0;				/* end of the text rewritten */
+	size_t start = 0, end = 0;
+	size_t match_end = 0;
+	long entry = 0;
+	char *synonym = NULL;
+	scanner_t scanner;
+
+	(*rewriter).long_word = 0;
+	scanner_init(&scanner, text, size);
+	while (0 == rc && 0 != scanner_next(&scanner, &start, &end)) {
+		if (start < position) { /* in the phrase just replaced */
+			continue;
+		}
+		rc = put(rewriter, text + position, start - position);
+		position = start;
+		if (0 != rc) {
+			break;
+		}
+
+		if ((long_word && 0 == start) || end - start > REWRITE_MAX_WORD) {
+			rc = put_lower(rewriter, text + start, end - start);
+			(*rewriter).long_word = (end == size && !last);
+			words += !long_word || 0 != start;
+			position = end;
+			continue;
+		}
+		if ((end == size && !last) ||
+			DICTIONARY_MORE_TEXT == dictionary_match((*(*rewriter).worker).dictionary, text, size, start, end, last,
+													 &entry, &match_end)) {
+			left = 1;
+			break;
+		}
+
+		synonym = next_synonym((*rewriter).worker, entry);
+		++words;
+		if (NULL != synonym) {
+			++replaced;
+			phrases += (match_end != end);
+			rc = put(rewriter, synonym, strlen(synonym));
+		} else {
+			rc = put_lower(rewriter, text + start, end - start);
+		}
+		position = match_end;
+	}
+
+	if (0 == rc && !left) {
+		rc = put(rewriter, text + position, size - position);
+		position = size;
+	}
+	*used = position;
+	STATS_ADD(STATS_WORDS, words);
+	STATS_ADD(STATS_REPLACED, replaced);
+	STATS_ADD(STATS_PHRASES, phrases);
+
+	return rc;
+}
+
+/* Takes the next synonym of an entry, NULL if it has none or the word is not in the dictionary */
+static char * next_synonym(rewrite_worker_t *worker, long entry)
+{
+	char *synonym = NULL;
+
+	if (entry < 0) {
+		return NULL;
+	}
+	if (NULL == (*worker).turns) {
+		return dictionary_next_synonym((*worker).dictionary, entry);
+	}
+
+	if (0 == (*worker).turns[entry]) {
+		(*worker).touched[(*worker).touched_count] = entry;
+		++(*worker).touched_count;
+	}
+	synonym = dictionary_peek_synonym((*worker).dictionary, entry, (*worker).turns[entry]);
+	++(*worker).turns[entry];
+
+	return synonym;
+}
+
+/* Adds to the output, writing the buffer whenever it fills */
+static int put(rewriter_t *rewriter, const char *data, size_t size)
+{
+	if ((*rewriter).used + size > REWRITE_BUFFER) {
+		if (0 != flush(rewriter)) {
+			return REWRITE_CANNOT_WRITE;
+		}
+
+		/* Too large to buffer */
+		if (size > REWRITE_BUFFER) {
+			return write_out((*rewriter).out, data, size);
+		}
+	}
+
+	memcpy((*(*rewriter).worker).buffer + (*rewriter).used, data, size);
+	(*rewriter).used += size;
+
+	return 0;
+}
+
+/* Adds letters to the output in lowercase */
+static int put_lower(rewriter_t *rewriter, const char *letters, size_t length)
+{
+	size_t piece = 0;
+
+	while (0 != length) {
+		if (REWRITE_BUFFER == (*rewriter).used && 0 != flush(rewriter)) {
+			return REWRITE_CANNOT_WRITE;
+		}
+
+		piece = REWRITE_BUFFER - (*rewriter).used;
+		piece = (length < piece) ? length : piece;
+		scan_lower((*(*rewriter).worker).buffer + (*rewriter).used, letters, piece);
+		(*rewriter).used += piece;
+		letters += piece;
+		length -= piece;
+	}
+
+	return 0;
+}
+
+static int flush(rewriter_t *rewriter)
+{
+	size_t used = (*rewriter).used;
+
+	(*rewriter).used = 0;
+
+	return write_out((*rewriter).out, (*(*rewriter).worker).buffer, used);
+}
+
+/* Writes output, timing it */
+static int write_out(FILE *out, const char *data, size_t size)
+{
+	uint64_t started = STATS_NOW();
+	size_t written = (0 == size) ? 0 : fwrite(data, 1, size, out);
+
+	STATS_ADD(STATS_WRITE_NS, STATS_NOW() - started);
+	STATS_ADD(STATS_BYTES_OUT, written);
+
+	return (size == written) ? 0 : REWRITE_CANNOT_WRITE;
+}
+
+/****************************************************************
+ * Summary: Creates a temporary file in the directory of path,  *
+ *          with the permissions of path.                       *
+ *                                                              *
+ * Parameters: path - The file to be replaced.                  *
+ *             temp_path - Room for strlen(path) + 8 chars,     *
+ *                         receives the name of the file.       *
+ *                                                              *
+ * Returns: The file, open for binary writing, or NULL.         *
+ ****************************************************************/
+static FILE * open_temp(const char *path, char *temp_path)
+{
+#if !defined(_WIN32)
+	int fd = 0;
+	struct stat info;
+	FILE *fp = NULL;
+
+	strcpy(temp_path, path);
+	strcat(temp_path, ".XXXXXX");
+
+	fd = mkstemp(temp_path);
+	if (fd < 0) {
+		return NULL;
+	}
+	if (0 == stat(path, &info)) {
+		fchmod(fd, info.st_mode & 07777);
+	}
+
+	fp = fdopen(fd, "wb");
+	if (NULL == fp) {
+		close(fd);
+		remove(temp_path);
+	}
+
+	return fp;
+#else
+	strcpy(temp_path, path);
+	strcat(temp_path, ".tmp");
+
+	return fopen(temp_path, "wb");
+#endif
+}
+
+#if !defined(_WIN32)
+
+/****************************************************************
+ * Summary: Rewrites a file by mapping it. Unchanged text,      *
+ *          including words already in lowercase that have no   *
+ *          synonym, is written straight from the mapping.      *
+ *                                                              *
+ * Parameters: fd_in - The file to rewrite.                     *
+ *             fd_out - Receives the rewritten text.            *
+ *             dictionary - The dictionary with the synonyms.   *
+ *                                                              *
+ * Returns: 0 if successful, REWRITE_NOT_MAPPED if the file     *
+ *          cannot be mapped, otherwise REWRITE_NOT_ENOUGH_     *
+ *          MEMORY or REWRITE_CANNOT_WRITE.                     *
+ ****************************************************************/
+static int rewrite_mapped(int fd_in, int fd_out, dictionary_t *dictionary)
+{
+	int rc = 0;
+	size_t j = 0;
+	size_t size = 0;
+	size_t start = 0, end = 0;
+	size_t span = 0;					/* start of the unchanged text */
+	size_t length = 0;
+	size_t match_end = 0;
+	long entry = 0;
+	int changed = 0;
+	size_t words = 0, replaced = 0, phrases = 0;
+	struct stat info;
+	char *data = NULL;
+	char *synonym = NULL;
+	char word[REWRITE_MAX_WORD + 1];
+	scanner_t scanner;
+	slice_writer_t *writer = NULL;
+
+	/* Only a regular file with something in it can be mapped */
+	if (0 != fstat(fd_in, &info) || !S_ISREG(info.st_mode) || 0 == info.st_size) {
+		return REWRITE_NOT_MAPPED;
+	}
+	size = (size_t)info.st_size;
+	data = (char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd_in, 0);
+	if (MAP_FAILED == (void *)data) {
+		return REWRITE_NOT_MAPPED;
+	}
+	posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+	STATS_ADD(STATS_BYTES_IN, size);
+
+	/* Allocate memory */
+	writer = (slice_writer_t *)malloc(sizeof(slice_writer_t));
+	if (NULL == writer || NULL == ((*writer).scratch = (char *)malloc(sizeof(char) * REWRITE_BUFFER))) {
+		free(writer);
+		munmap(data, size);
+		return REWRITE_NOT_ENOUGH_MEMORY;
+	}
+	(*writer).fd = fd_out;
+	(*writer).count = 0;
+	(*writer).used = 0;
+
+	scanner_init(&scanner, data, size);
+	while (0 == rc && 0 != scanner_next(&scanner, &start, &end)) {
+		length = end - start;
+		if (start < span) { /* in the phrase just replaced */
+			continue;
+		}
+		++words;
+
+		if (length > REWRITE_MAX_WORD) {
+			/* Too long to have a synonym, only its case can change */
+			for (j = start, changed = 0 ; j < end && !changed ; ++j) {
+				changed = (0 == (data[j] & 0x20));
+			}
+			if (changed) {
+				rc = add_slice(writer, data + span, start - span);
+				for (j = start ; j < end && 0 == rc ; j += REWRITE_MAX_WORD) {
+					length = (end - j < REWRITE_MAX_WORD) ? end - j : REWRITE_MAX_WORD;
+					scan_lower(word, data + j, length);
+					rc = add_copy(writer, word, length);
+				}
+				span = end;
+			}
+			continue;
+		}
+
+		dictionary_match(dictionary, data, size, start, end, 1, &entry, &match_end);
+		synonym = (entry >= 0) ? dictionary_next_synonym(dictionary, entry) : NULL;
+		replaced += (NULL != synonym);
+		phrases += (NULL != synonym && match_end != end);
+		scan_lower(word, data + start, length);
+		if (NULL == synonym && 0 == memcmp(word, data + start, length)) { /* unchanged */
+			continue;
+		}
+
+		rc = add_slice(writer, data + span, start - span);
+		if (0 == rc) {
+			if (NULL == synonym) { /* only lowercased, the copy is needed */
+				rc = add_copy(writer, word, length);
+			} else { /* synonyms stay where they are */
+				rc = add_slice(writer, synonym, strlen(synonym));
+			}
+		}
+		span = match_end;
+	}
+
+	if (0 == rc) {
+		rc = add_slice(writer, data + span, size - span);
+	}
+	if (0 == rc) {
+		rc = write_slices(writer);
+	}
+	STATS_ADD(STATS_WORDS, words);
+	STATS_ADD(STATS_REPLACED, replaced);
+	STATS_ADD(STATS_PHRASES, phrases);
+
+	/* Free memory */
+	free((*writer).scratch);
+	free(writer);
+	munmap(data, size);
+
+	return rc;
+}
+
+/* Adds a slice of output, joining it to the last one if they touch */
+static int add_slice(slice_writer_t *writer, const char *data, size_t size)
+{
+	struct iovec *last = NULL;
+
+	if (0 == size) {
+		return 0;
+	}
+
+	if (0 != (*writer).count) {
+		last = &(*writer).slices[(*writer).count - 1];
+		if ((char *)(*last).iov_base + (*last).iov_len == data) {
+			(*last).iov_len += size;
+			return 0;
+		}
+	}
+
+	if (REWRITE_SLICES == (*writer).count && 0 != write_slices(writer)) {
+		return REWRITE_CANNOT_WRITE;
+	}
+	(*writer).slices[(*writer).count].iov_base = (void *)data;
+	(*writer).slices[(*writer).count].iov_len = size;
+	++(*writer).count;
+
+	return 0;
+}
+
+/* Adds output that does not outlive the call, up to REWRITE_BUFFER bytes */
+static int add_copy(slice_writer_t *writer, const char *data, size_t size)
+{
+	/* Write everything first if the copy or its slice would not fit */
+	if ((*writer).used + size > REWRITE_BUFFER || REWRITE_SLICES == (*writer).count) {
+		if (0 != write_slices(writer)) {
+			return REWRITE_CANNOT_WRITE;
+		}
+	}
+
+	memcpy((*writer).scratch + (*writer).used, data, size);
+	(*writer).used += size;
+
+	return add_slice(writer, (*writer).scratch + (*writer).used - size, size);
+}
+
+/* Writes the gathered slices, and empties the scratch buffer */
+static int write_slices(slice_writer_t *writer)
+{
+	int first = 0;
+	ssize_t written = 0;
+	uint64_t started = STATS_NOW();
+	struct iovec *slices = (*writer).slices;
+
+	while (first < (*writer).count) {
+		written = writev((*writer).fd, slices + first, (*writer).count - first);
+		if (written < 0) {
+			if (EINTR == errno) {
+				continue;
+			}
+			return REWRITE_CANNOT_WRITE;
+		}
+		STATS_ADD(STATS_BYTES_OUT, written);
+
+		/* Skip what was written, which may end inside a slice */
+		while (first < (*writer).count && (size_t)written >= slices[first].iov_len) {
+			written -= (ssize_t)slices[first].iov_len;
+			++first;
+		}
+		if (first < (*writer).count) {
+			slices[first].iov_base = (char *)slices[first].iov_base + written;
+			slices[first].iov_len -= (size_t)written;
+		}
+	}
+
+	(*writer).count = 0;
+	(*writer).used = 0;
+	STATS_ADD(STATS_WRITE_NS, STATS_NOW() - started);
+
+	return 0;
+}
+
+#endif
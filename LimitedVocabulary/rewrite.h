@@ -0,0 +1,67 @@
+#if !defined(_REWRITE_H_)
+#define _REWRITE_H_
+
+#include <stdio.h>
+#include "dictionary.h"
+
+/* Bytes read from the input at a time, with room for a phrase carried from the last chunk */
+#define REWRITE_CHUNK (1 << 16)
+
+/* Bytes of output collected before they are written */
+#define REWRITE_BUFFER (1 << 16)
+
+/* Longer words cannot be in a dictionary and are only lowercased */
+#define REWRITE_MAX_WORD (DICTIONARY_MAX_LINE)
+
+/* Names standard input, or standard output, instead of a file */
+#define REWRITE_STANDARD_STREAM ("-")
+
+/* Slices of output gathered before they are written by the zero copy rewrite */
+#define REWRITE_SLICES (1024)
+
+/* Bytes of the input every thread of the parallel rewrite takes at a time */
+#define REWRITE_PARALLEL_BLOCK (1 << 23)
+
+/* Flags of rewrite_file */
+#define REWRITE_TO_STDOUT (1)
+#define REWRITE_ZERO_COPY (2)
+
+#define REWRITE_NOT_ENOUGH_MEMORY (-1)
+#define REWRITE_CANNOT_READ (-2)
+#define REWRITE_CANNOT_WRITE (-3)
+
+/* The input cannot be mapped, and must be streamed instead */
+#define REWRITE_NOT_MAPPED (1)
+
+/* What a thread keeps between the files it rewrites */
+typedef struct rewrite_worker_rec {
+	dictionary_t *dictionary;
+	char *chunk;					/* input being rewritten */
+	char *buffer;					/* output not yet written */
+	uint64_t *turns;				/* per entry, own synonym rotation, or NULL to use the dictionary's */
+	long *touched;					/* entries whose turn is not 0 */
+	size_t touched_count;
+} rewrite_worker_t;
+
+typedef struct rewriter_rec {
+	rewrite_worker_t *worker;
+	FILE *out;
+	size_t used;					/* bytes in the worker's buffer */
+	int long_word;					/* a word too long to look up goes on in the next chunk */
+} rewriter_t;
+
+int rewrite_stream(FILE *in, FILE *out, dictionary_t *dictionary);
+
+int rewrite_file(const char *path, dictionary_t *dictionary, int flags, int threads);
+
+int rewrite_parallel(int fd_in, FILE *out, dictionary_t *dictionary, int threads);
+
+rewrite_worker_t * rewrite_worker_create(dictionary_t *dictionary, int own_rotation);
+
+void rewrite_worker_destroy(rewrite_worker_t *worker);
+
+int rewrite_worker_file(rewrite_worker_t *worker, const char *path, int flags);
+
+int rewrite_worker_text(rewrite_worker_t *worker, const char *text, size_t size, FILE *out);
+
+#endif
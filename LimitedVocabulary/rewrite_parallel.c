@@ -0,0 +1,500 @@
+/****************************************************************
+ * Summary: Rewrites a mapped file on many threads, with the    *
+ *          same output as the sequential rewrite.              *
+ *                                                              *
+ *          The file is taken in rounds of one block per        *
+ *          thread, split at word boundaries. Every round runs  *
+ *          twice over its blocks: first every thread counts    *
+ *          the words of its block per dictionary entry, then   *
+ *          the counts are summed in block order so every       *
+ *          thread knows which synonym each of its words would  *
+ *          have got, and the blocks are rewritten. The blocks  *
+ *          are written in order at the end of the round, so    *
+ *          memory stays the same whatever the size of the      *
+ *          file. A dictionary with phrases only splits the     *
+ *          file between words where no phrase from the words   *
+ *          before can go on, which is looked up from the words *
+ *          of the last DICTIONARY_MAX_PHRASE bytes before the  *
+ *          block would end. Where phrases chain on and on      *
+ *          without such a gap, the words of the block are      *
+ *          matched as the sequential rewrite would, to end it  *
+ *          where a match ends.                                 *
+ ****************************************************************/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE (200809L)
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "rewrite.h"
+#include "scan.h"
+#include "stats.h"
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Most threads a rewrite runs on */
+#define MAX_THREADS (256)
+
+#define PHASE_COUNT (0)
+#define PHASE_REWRITE (1)
+
+typedef struct parallel_job_rec {
+	dictionary_t *dictionary;
+	const char *data;
+	size_t start;					/* the block, from start to end */
+	size_t end;
+	uint64_t *turns;				/* per entry, counted words, then the next turn */
+	char *output;					/* the rewritten block */
+	size_t used;
+	size_t size;
+	int phase;
+	int rc;
+} parallel_job_t;
+
+static void * run_job(void *arg);
+
+static void count_words(parallel_job_t *job);
+
+static int rewrite_words(parallel_job_t *job);
+
+static int put(parallel_job_t *job, const char *data, size_t size);
+
+static int run_phase(parallel_job_t *jobs, int count, int phase);
+
+static size_t block_boundary(dictionary_t *dictionary, const char *data, size_t size, size_t block, size_t position);
+
+static size_t greedy_boundary(dictionary_t *dictionary, const char *data, size_t size, size_t block, size_t position);
+
+/****************************************************************
+ * Summary: Rewrites a file on many threads. Words get the same *
+ *          synonyms as with rewrite_stream, and the            *
+ *          dictionary is left as rewrite_stream would leave    *
+ *          it.                                                 *
+ *                                                              *
+ * Parameters: fd_in - The file to rewrite.                     *
+ *             out - Receives the rewritten text.               *
+ *             dictionary - The dictionary with the synonyms.   *
+ *             threads - The amount of threads, or 0 for one    *
+ *                       per online processor.                  *
+ *                                                              *
+ * Returns: 0 if successful, REWRITE_NOT_MAPPED if the file     *
+ *          cannot be mapped, otherwise REWRITE_NOT_ENOUGH_     *
+ *          MEMORY or REWRITE_CANNOT_WRITE.                     *
+ ****************************************************************/
+int rewrite_parallel(int fd_in, FILE *out, dictionary_t *dictionary, int threads)
+{
+	int rc = 0;
+	int t = 0;
+	size_t e = 0;
+	size_t size = 0;
+	size_t position = 0;
+	size_t entries = dictionary_entry_count(dictionary);
+	uint64_t running = 0, counted = 0;
+	uint64_t *base = NULL;				/* per entry, words before this round */
+	uint64_t started = 0;
+	struct stat info;
+	char *data = NULL;
+	parallel_job_t *jobs = NULL;
+
+	if (0 == threads) {
+		threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if (threads < 1) {
+		threads = 1;
+	} else if (threads > MAX_THREADS) {
+		threads = MAX_THREADS;
+	}
+
+	/* Only a regular file with something in it can be mapped */
+	if (0 != fstat(fd_in, &info) || !S_ISREG(info.st_mode) || 0 == info.st_size) {
+		return REWRITE_NOT_MAPPED;
+	}
+	size = (size_t)info.st_size;
+	data = (char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd_in, 0);
+	if (MAP_FAILED == (void *)data) {
+		return REWRITE_NOT_MAPPED;
+	}
+	posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+	STATS_ADD(STATS_BYTES_IN, size);
+
+	/* Allocate memory */
+	jobs = (parallel_job_t *)calloc(threads, sizeof(parallel_job_t));
+	base = (uint64_t *)calloc(entries, sizeof(uint64_t));
+	if (NULL == jobs || NULL == base) {
+		rc = REWRITE_NOT_ENOUGH_MEMORY;
+	}
+	for (t = 0 ; t < threads && 0 == rc ; ++t) {
+		jobs[t].dictionary = dictionary;
+		jobs[t].data = data;
+		jobs[t].turns = (uint64_t *)malloc(sizeof(uint64_t) * entries);
+		if (NULL == jobs[t].turns) {
+			rc = REWRITE_NOT_ENOUGH_MEMORY;
+		}
+	}
+
+	while (0 == rc && position < size) {
+		/* Split the round into blocks that end between words */
+		for (t = 0 ; t < threads ; ++t) {
+			jobs[t].start = position;
+			if (size - position > REWRITE_PARALLEL_BLOCK) {
+				position = block_boundary(dictionary, data, size, position, position + REWRITE_PARALLEL_BLOCK);
+			} else {
+				position = size;
+			}
+			jobs[t].end = position;
+			memset(jobs[t].turns, 0, sizeof(uint64_t) * entries);
+		}
+
+		rc = run_phase(jobs, threads, PHASE_COUNT);
+
+		/* Every block starts counting where the blocks before it stopped */
+		for (e = 0 ; e < entries && 0 == rc ; ++e) {
+			running = base[e];
+			for (t = 0 ; t < threads ; ++t) {
+				counted = jobs[t].turns[e];
+				jobs[t].turns[e] = running;
+				running += counted;
+			}
+			base[e] = running;
+		}
+
+		if (0 == rc) {
+			rc = run_phase(jobs, threads, PHASE_REWRITE);
+		}
+		started = STATS_NOW();
+		for (t = 0 ; t < threads && 0 == rc ; ++t) {
+			if (0 != jobs[t].used && jobs[t].used != fwrite(jobs[t].output, 1, jobs[t].used, out)) {
+				rc = REWRITE_CANNOT_WRITE;
+			}
+			STATS_ADD(STATS_BYTES_OUT, jobs[t].used);
+		}
+		STATS_ADD(STATS_WRITE_NS, STATS_NOW() - started);
+	}
+	if (0 == rc && 0 != fflush(out)) {
+		rc = REWRITE_CANNOT_WRITE;
+	}
+
+	/* Leave the synonyms where the sequential rewrite would */
+	for (e = 0 ; e < entries && 0 == rc ; ++e) {
+		if (0 != base[e]) {
+			dictionary_skip_synonyms(dictionary, (long)e, base[e]);
+		}
+	}
+
+	/* Free memory */
+	for (t = 0 ; NULL != jobs && t < threads ; ++t) {
+		free(jobs[t].turns);
+		free(jobs[t].output);
+	}
+	free(jobs);
+	free(base);
+	munmap(data, size);
+
+	return rc;
+}
+
+/* Runs a phase of every job, the first on the calling thread */
+static int run_phase(parallel_job_t *jobs, int count, int phase)
+{
+	int t = 0;
+	int started = 0;
+	int rc = 0;
+	pthread_t workers[MAX_THREADS];
+
+	for (t = 0 ; t < count ; ++t) {
+		jobs[t].phase = phase;
+		jobs[t].rc = 0;
+		jobs[t].used = 0;
+	}
+
+	for (started = 1 ; started < count ; ++started) {
+		if (0 != pthread_create(&workers[started], NULL, run_job, &jobs[started])) {
+			break;
+		}
+	}
+
+	/* Jobs without a thread run here */
+	run_job(&jobs[0]);
+	for (t = started ; t < count ; ++t) {
+		run_job(&jobs[t]);
+	}
+
+	for (t = 1 ; t < started ; ++t) {
+		pthread_join(workers[t], NULL);
+	}
+	for (t = 0 ; t < count ; ++t) {
+		if (0 != jobs[t].rc) {
+			rc = jobs[t].rc;
+		}
+	}
+
+	return rc;
+}
+
+static void * run_job(void *arg)
+{
+	parallel_job_t *job = (parallel_job_t *)arg;
+
+	if (PHASE_COUNT == (*job).phase) {
+		count_words(job);
+	} else {
+		(*job).rc = rewrite_words(job);
+	}
+
+	return NULL;
+}
+
+/* Counts the words and phrases of a block per dictionary entry */
+static void count_words(parallel_job_t *job)
+{
+	size_t start = 0, end = 0;
+	size_t position = 0;				/* end of the last match */
+	long entry = 0;
+	const char *data = (*job).data + (*job).start;
+	size_t size = (*job).end - (*job).start;
+	scanner_t scanner;
+
+	scanner_init(&scanner, data, size);
+	while (0 != scanner_next(&scanner, &start, &end)) {
+		if (start < position || end - start > REWRITE_MAX_WORD) {
+			continue;
+		}
+
+		dictionary_match((*job).dictionary, data, size, start, end, 1, &entry, &position);
+		if (entry >= 0) {
+			++(*job).turns[entry];
+		}
+	}
+}
+
+/****************************************************************
+ * Summary: Rewrites a block, taking the synonym of every word  *
+ *          and phrase from the turn of its entry.              *
+ *                                                              *
+ * Parameters: job - The job, with the first turn of every      *
+ *                   entry.                                     *
+ *                                                              *
+ * Returns: 0 if successful, otherwise                          *
+ *          REWRITE_NOT_ENOUGH_MEMORY.                          *
+ ****************************************************************/
+static int rewrite_words(parallel_job_t *job)
+{
+	int rc = 0;
+	size_t j = 0;
+	size_t position = 0;				/* end of the last word */
+	size_t start = 0, end = 0;
+	size_t length = 0;
+	size_t match_end = 0;
+	long entry = 0;
+	size_t words = 0, replaced = 0, phrases = 0;
+	char *synonym = NULL;
+	char word[REWRITE_MAX_WORD + 1];
+	const char *data = (*job).data + (*job).start;
+	size_t size = (*job).end - (*job).start;
+	scanner_t scanner;
+
+	scanner_init(&scanner, data, size);
+	while (0 == rc && 0 != scanner_next(&scanner, &start, &end)) {
+		if (start < position) { /* in the phrase just replaced */
+			continue;
+		}
+		++words;
+		rc = put(job, data + position, start - position);
+		position = end;
+		length = end - start;
+
+		if (length > REWRITE_MAX_WORD) {
+			/* Too long to have a synonym, only lowercased */
+			for (j = start ; j < end && 0 == rc ; j += length) {
+				length = (end - j < REWRITE_MAX_WORD) ? end - j : REWRITE_MAX_WORD;
+				scan_lower(word, data + j, length);
+				rc = put(job, word, length);
+			}
+			continue;
+		}
+		if (0 != rc) {
+			continue;
+		}
+
+		dictionary_match((*job).dictionary, data, size, start, end, 1, &entry, &match_end);
+		synonym = NULL;
+		if (entry >= 0) {
+			synonym = dictionary_peek_synonym((*job).dictionary, entry, (*job).turns[entry]);
+			++(*job).turns[entry];
+		}
+		if (NULL != synonym) {
+			++replaced;
+			phrases += (match_end != end);
+			rc = put(job, synonym, strlen(synonym));
+			position = match_end;
+		} else {
+			scan_lower(word, data + start, length);
+			rc = put(job, word, length);
+		}
+	}
+	if (0 == rc) {
+		rc = put(job, data + position, size - position);
+	}
+	STATS_ADD(STATS_WORDS, words);
+	STATS_ADD(STATS_REPLACED, replaced);
+	STATS_ADD(STATS_PHRASES, phrases);
+
+	return rc;
+}
+
+/* Adds to the output of a block, growing it as needed */
+static int put(parallel_job_t *job, const char *data, size_t size)
+{
+	size_t new_size = 0;
+	char *new_output = NULL;
+
+	if (0 == size) {
+		return 0;
+	}
+	if ((*job).used + size > (*job).size) {
+		new_size = ((*job).size < REWRITE_BUFFER) ? REWRITE_BUFFER : (*job).size;
+		while (new_size < (*job).used + size) {
+			new_size *= 2;
+		}
+		new_output = (char *)realloc((*job).output, new_size);
+		if (NULL == new_output) {
+			return REWRITE_NOT_ENOUGH_MEMORY;
+		}
+		(*job).output = new_output;
+		(*job).size = new_size;
+	}
+
+	memcpy((*job).output + (*job).used, data, size);
+	(*job).used += size;
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Moves a position forward to where a block can end.  *
+ *          With phrases, that is the first place between words *
+ *          that no phrase from a word before it goes past, or  *
+ *          if there is none for another REWRITE_PARALLEL_BLOCK *
+ *          bytes, where greedy_boundary says.                  *
+ *                                                              *
+ * Parameters: dictionary - The dictionary.                     *
+ *             data - The file.                                 *
+ *             size - The length of the file.                   *
+ *             block - Where the block starts, between matches. *
+ *             position - Where the block would end.            *
+ *                                                              *
+ * Returns: Where the block ends.                               *
+ ****************************************************************/
+static size_t block_boundary(dictionary_t *dictionary, const char *data, size_t size, size_t block, size_t position)
+{
+	size_t from = 0;
+	size_t start = 0, end = 0;
+	size_t gap = 0;						/* where the text since the last word starts */
+	size_t reach = 0;					/* the furthest the words so far go, phrases and all */
+	size_t match_end = 0;
+	long entry = 0;
+	scanner_t scanner;
+
+	/* The end of the word it is in */
+	while (position < size && SCAN_IS_LETTER(data[position]) && SCAN_IS_LETTER(data[position - 1])) {
+		++position;
+	}
+	if (!dictionary_has_phrases(dictionary)) {
+		return position;
+	}
+
+	/* A word that starts earlier than a phrase is long cannot reach position, nor can the word from is in */
+	reach = position;
+	from = (position > DICTIONARY_MAX_PHRASE) ? position - DICTIONARY_MAX_PHRASE : 0;
+	while (0 != from && from < position && SCAN_IS_LETTER(data[from - 1]) && SCAN_IS_LETTER(data[from])) {
+		++from;
+	}
+
+	gap = from;
+	scanner_init(&scanner, data + from, size - from);
+	while (0 != scanner_next(&scanner, &start, &end)) {
+		start += from;
+		end += from;
+		if (gap > reach) {
+			reach = gap;
+		}
+		if (reach <= start) {
+			return reach;
+		}
+		if (start - position > REWRITE_PARALLEL_BLOCK) {
+			return greedy_boundary(dictionary, data, size, block, position);
+		}
+
+		if (end - start <= REWRITE_MAX_WORD) {
+			dictionary_match(dictionary, data, size, start, end, 1, &entry, &match_end);
+			if (match_end > reach) {
+				reach = match_end;
+			}
+		}
+		if (end > reach) {
+			reach = end;
+		}
+		gap = end;
+	}
+
+	return (gap > reach) ? gap : reach;
+}
+
+/****************************************************************
+ * Summary: Matches the words of a block as the sequential      *
+ *          rewrite does, to find the first word from position  *
+ *          on that is not in a phrase started before it.       *
+ *                                                              *
+ * Parameters: dictionary - The dictionary.                     *
+ *             data - The file.                                 *
+ *             size - The length of the file.                   *
+ *             block - Where the block starts, between matches. *
+ *             position - Where the block would end.            *
+ *                                                              *
+ * Returns: Where the block ends.                               *
+ ****************************************************************/
+static size_t greedy_boundary(dictionary_t *dictionary, const char *data, size_t size, size_t block, size_t position)
+{
+	size_t start = 0, end = 0;
+	size_t match_end = 0;				/* end of the last match */
+	long entry = 0;
+	scanner_t scanner;
+
+	scanner_init(&scanner, data + block, size - block);
+	while (0 != scanner_next(&scanner, &start, &end)) {
+		start += block;
+		end += block;
+		if (start < match_end) { /* in the phrase just matched */
+			continue;
+		}
+		if (start >= position) {
+			return start;
+		}
+
+		match_end = end;
+		if (end - start <= REWRITE_MAX_WORD) {
+			dictionary_match(dictionary, data, size, start, end, 1, &entry, &match_end);
+		}
+	}
+
+	return size;
+}
+
+#else
+
+/* Threads and mapping are POSIX, the rewrite is streamed instead */
+int rewrite_parallel(int fd_in, FILE *out, dictionary_t *dictionary, int threads)
+{
+	(void)fd_in;
+	(void)out;
+	(void)dictionary;
+	(void)threads;
+
+	return REWRITE_NOT_MAPPED;
+}
+
+#endif
@@ -0,0 +1,294 @@
+/****************************************************************
+ * Summary: Finds the words of a text. The text is classified   *
+ *          SCAN_BLOCK bytes at a time into a mask with a bit   *
+ *          per letter, using AVX2 or SSE2 if the processor has *
+ *          them, and the starts and ends of words are taken    *
+ *          from the mask with bit scans instead of testing     *
+ *          every byte.                                         *
+ ****************************************************************/
+#include <string.h>
+#include "scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define SCAN_X86
+#include <immintrin.h>
+#endif
+
+static uint64_t classify_scalar(const char *block);
+
+#if defined(SCAN_X86)
+static uint64_t classify_sse2(const char *block);
+
+static uint64_t classify_avx2(const char *block);
+#endif
+
+static scan_classify_t pick_classify(void);
+
+/****************************************************************
+ * Summary: Starts scanning a text for words.                   *
+ *                                                              *
+ * Parameters: scanner - The scanner to start.                  *
+ *             data - The text.                                 *
+ *             size - The length of data.                       *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void scanner_init(scanner_t *scanner, const char *data, size_t size)
+{
+	char padded[SCAN_BLOCK] = { 0 };
+	uint64_t mask = 0;
+
+	(*scanner).data = data;
+	(*scanner).size = size;
+	(*scanner).base = 0;
+	(*scanner).start = 0;
+	(*scanner).in_word = 0;
+	(*scanner).classify = pick_classify();
+
+	/* A block past the end of the text is padded with non-letters */
+	if (size >= SCAN_BLOCK) {
+		mask = (*scanner).classify(data);
+	} else if (0 != size) {
+		memcpy(padded, data, size);
+		mask = (*scanner).classify(padded);
+	}
+	(*scanner).edges = mask ^ (mask << 1);
+	(*scanner).last = mask >> (SCAN_BLOCK - 1);
+}
+
+/****************************************************************
+ * Summary: Finds the next word. A word is a run of letters,    *
+ *          the text around it is everything else.              *
+ *                                                              *
+ * Parameters: scanner - The scanner.                           *
+ *             start - Receives the offset of the word.         *
+ *             end - Receives the offset after the word.        *
+ *                                                              *
+ * Returns: 1 if a word was found, 0 at the end of the text.    *
+ ****************************************************************/
+int scanner_next(scanner_t *scanner, size_t *start, size_t *end)
+{
+	char padded[SCAN_BLOCK] = { 0 };
+	size_t offset = 0;
+	uint64_t mask = 0;
+
+	for (;;) {
+		/* Classify blocks until one has an edge */
+		while (0 == (*scanner).edges) {
+			if ((*scanner).base + SCAN_BLOCK >= (*scanner).size) {
+				if ((*scanner).in_word) { /* the text ends with a word */
+					(*scanner).in_word = 0;
+					*start = (*scanner).start;
+					*end = (*scanner).size;
+					return 1;
+				}
+				return 0;
+			}
+
+			(*scanner).base += SCAN_BLOCK;
+			if ((*scanner).size - (*scanner).base >= SCAN_BLOCK) {
+				mask = (*scanner).classify((*scanner).data + (*scanner).base);
+			} else {
+				memcpy(padded, (*scanner).data + (*scanner).base, (*scanner).size - (*scanner).base);
+				mask = (*scanner).classify(padded);
+			}
+			(*scanner).edges = mask ^ ((mask << 1) | (*scanner).last);
+			(*scanner).last = mask >> (SCAN_BLOCK - 1);
+		}
+
+		offset = (*scanner).base + (size_t)scan_lowest_bit((*scanner).edges);
+		(*scanner).edges &= (*scanner).edges - 1;
+
+		if (!(*scanner).in_word) {
+			(*scanner).start = offset;
+			(*scanner).in_word = 1;
+		} else {
+			(*scanner).in_word = 0;
+			*start = (*scanner).start;
+			*end = offset;
+			return 1;
+		}
+	}
+}
+
+/****************************************************************
+ * Summary: Copies letters in lowercase.                        *
+ *                                                              *
+ * Parameters: destination - Room for length chars.             *
+ *             letters - The letters to copy, nothing else.     *
+ *             length - The amount of letters.                  *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void scan_lower(char *destination, const char *letters, size_t length)
+{
+	size_t i = 0;
+
+	/* Every ASCII letter is lowercase with its 0x20 bit set */
+#if defined(SCAN_X86)
+	const __m128i lower = _mm_set1_epi8(0x20);
+
+	for ( ; i + 16 <= length ; i += 16) {
+		_mm_storeu_si128((__m128i *)(destination + i),
+						 _mm_or_si128(_mm_loadu_si128((const __m128i *)(letters + i)), lower));
+	}
+#endif
+	for ( ; i < length ; ++i) {
+		destination[i] = (char)(letters[i] | 0x20);
+	}
+}
+
+/****************************************************************
+ * Summary: Finds the separators of the words of a dictionary:  *
+ *          spaces, tabs, carriage returns and newlines.        *
+ *                                                              *
+ * Parameters: block - SCAN_BLOCK bytes.                        *
+ *             newlines - Receives a bit per newline.           *
+ *                                                              *
+ * Returns: A bit per separator.                                *
+ ****************************************************************/
+uint64_t scan_separators(const char *block, uint64_t *newlines)
+{
+	int i = 0;
+	uint64_t separators = 0;
+
+#if defined(SCAN_X86)
+	__m128i bytes;
+	__m128i lines;
+	const __m128i newline = _mm_set1_epi8('\n');
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i carriage = _mm_set1_epi8('\r');
+
+	*newlines = 0;
+	for (i = 0 ; i < SCAN_BLOCK ; i += 16) {
+		bytes = _mm_loadu_si128((const __m128i *)(block + i));
+		lines = _mm_cmpeq_epi8(bytes, newline);
+		*newlines |= (uint64_t)(unsigned int)_mm_movemask_epi8(lines) << i;
+		lines = _mm_or_si128(_mm_or_si128(lines, _mm_cmpeq_epi8(bytes, space)),
+							 _mm_or_si128(_mm_cmpeq_epi8(bytes, tab), _mm_cmpeq_epi8(bytes, carriage)));
+		separators |= (uint64_t)(unsigned int)_mm_movemask_epi8(lines) << i;
+	}
+#else
+	*newlines = 0;
+	for (i = 0 ; i < SCAN_BLOCK ; ++i) {
+		*newlines |= (uint64_t)('\n' == block[i]) << i;
+		separators |= (uint64_t)('\n' == block[i] || ' ' == block[i] || '\t' == block[i] || '\r' == block[i]) << i;
+	}
+#endif
+
+	return separators;
+}
+
+/****************************************************************
+ * Summary: Names the classifier this processor uses.           *
+ *                                                              *
+ * Parameters: None.                                            *
+ *                                                              *
+ * Returns: "avx2", "sse2" or "scalar".                         *
+ ****************************************************************/
+const char * scan_implementation(void)
+{
+	scan_classify_t classify = pick_classify();
+
+#if defined(SCAN_X86)
+	if (classify_avx2 == classify) {
+		return "avx2";
+	}
+	if (classify_sse2 == classify) {
+		return "sse2";
+	}
+#endif
+
+	return (classify_scalar == classify) ? "scalar" : "unknown";
+}
+
+static scan_classify_t pick_classify(void)
+{
+#if defined(SCAN_X86)
+	if (__builtin_cpu_supports("avx2")) {
+		return classify_avx2;
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		return classify_sse2;
+	}
+#endif
+
+	return classify_scalar;
+}
+
+static uint64_t classify_scalar(const char *block)
+{
+	int i = 0;
+	uint64_t mask = 0;
+
+	for (i = 0 ; i < SCAN_BLOCK ; ++i) {
+		mask |= (uint64_t)SCAN_IS_LETTER(block[i]) << i;
+	}
+
+	return mask;
+}
+
+#if defined(SCAN_X86)
+
+/*
+ * A byte is a letter if (byte | 0x20) is in 'a'..'z'. Adding 0x80 - 'a'
+ * moves that range to the bottom of the signed bytes, so one signed
+ * compare tests it.
+ */
+
+static uint64_t classify_sse2(const char *block)
+{
+	int i = 0;
+	uint64_t mask = 0;
+	__m128i bytes;
+	const __m128i lower = _mm_set1_epi8(0x20);
+	const __m128i shift = _mm_set1_epi8((char)(0x80 - 'a'));
+	const __m128i limit = _mm_set1_epi8((char)(-128 + 26));
+
+	for (i = 0 ; i < SCAN_BLOCK ; i += 16) {
+		bytes = _mm_loadu_si128((const __m128i *)(block + i));
+		bytes = _mm_add_epi8(_mm_or_si128(bytes, lower), shift);
+		mask |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmplt_epi8(bytes, limit)) << i;
+	}
+
+	return mask;
+}
+
+__attribute__((target("avx2")))
+static uint64_t classify_avx2(const char *block)
+{
+	int i = 0;
+	uint64_t mask = 0;
+	__m256i bytes;
+	const __m256i lower = _mm256_set1_epi8(0x20);
+	const __m256i shift = _mm256_set1_epi8((char)(0x80 - 'a'));
+	const __m256i limit = _mm256_set1_epi8((char)(-128 + 26));
+
+	for (i = 0 ; i < SCAN_BLOCK ; i += 32) {
+		bytes = _mm256_loadu_si256((const __m256i *)(block + i));
+		bytes = _mm256_add_epi8(_mm256_or_si256(bytes, lower), shift);
+		mask |= (uint64_t)(unsigned int)_mm256_movemask_epi8(_mm256_cmpgt_epi8(limit, bytes)) << i;
+	}
+
+	return mask;
+}
+
+#endif
+
+/* Index of the lowest set bit of a mask that is not 0 */
+int scan_lowest_bit(uint64_t bits)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(bits);
+#else
+	int i = 0;
+
+	while (0 == (bits & 1)) {
+		bits >>= 1;
+		++i;
+	}
+
+	return i;
+#endif
+}
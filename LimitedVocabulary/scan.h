@@ -0,0 +1,42 @@
+#if !defined(_SCAN_H_)
+#define _SCAN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Bytes classified at a time */
+#define SCAN_BLOCK (64)
+
+/* Words are ASCII letters, as isalpha decides in the "C" locale */
+#define SCAN_IS_LETTER(c) ((unsigned int)(((unsigned char)(c) | 0x20) - 'a') < 26u)
+
+/* The words of a phrase are apart by these, as the words of a dictionary line are */
+#define SCAN_IS_SPACE(c) (' ' == (c) || '\t' == (c) || '\r' == (c) || '\n' == (c))
+
+/* Sets one bit per letter in the SCAN_BLOCK bytes at block */
+typedef uint64_t (*scan_classify_t)(const char *block);
+
+typedef struct scanner_rec {
+	const char *data;
+	size_t size;
+	size_t base;					/* start of the current block */
+	uint64_t edges;					/* bits where a word starts or ends, not yet taken */
+	uint64_t last;					/* 1 if the last byte of the block is a letter */
+	size_t start;					/* start of the word being read */
+	int in_word;
+	scan_classify_t classify;
+} scanner_t;
+
+void scanner_init(scanner_t *scanner, const char *data, size_t size);
+
+int scanner_next(scanner_t *scanner, size_t *start, size_t *end);
+
+void scan_lower(char *destination, const char *letters, size_t length);
+
+uint64_t scan_separators(const char *block, uint64_t *newlines);
+
+int scan_lowest_bit(uint64_t bits);
+
+const char * scan_implementation(void);
+
+#endif
@@ -0,0 +1,520 @@
+/****************************************************************
+ * Summary: Serves rewrites from a process that keeps its       *
+ *          dictionary loaded, on a Unix domain socket or on    *
+ *          standard input and output.                          *
+ *                                                              *
+ *          A request is the length of a text in decimal, a     *
+ *          newline, and the text. The answer is "OK", the      *
+ *          length of the rewritten text, a newline and the     *
+ *          text, or "ERR" and a reason on one line. Every      *
+ *          request is rewritten as if it was the only one.     *
+ *                                                              *
+ *          When the dictionary file changes, a new dictionary  *
+ *          is loaded on a thread of its own and published in   *
+ *          place of the old one with one atomic store. Every   *
+ *          connection announces the dictionary it is using in  *
+ *          a hazard slot of its own, and the old dictionary is *
+ *          freed once no slot holds it, so requests never wait *
+ *          for a reload.                                       *
+ ****************************************************************/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE (200809L)
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "serve.h"
+#include "dictionary.h"
+#include "rewrite.h"
+#include "stats.h"
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/* Longest request header, the length of a text */
+#define SERVE_MAX_HEADER (32)
+
+typedef struct server_rec {
+	dictionary_t *current;			/* read and written atomically */
+	dictionary_t *hazards[SERVE_MAX_CLIENTS];	/* the dictionary every connection is using */
+	int claimed[SERVE_MAX_CLIENTS];	/* the connections' slots */
+	const char *vocabulary;
+	int threads;
+	struct stat loaded;				/* the file as it was when last loaded */
+	int stopping;					/* read and written atomically */
+} server_t;
+
+typedef struct client_rec {
+	server_t *server;
+	int slot;
+	FILE *in;
+	FILE *out;
+} client_t;
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void stop(int signal_number);
+
+static int listen_on(const char *address);
+
+static int claim_slot(server_t *server);
+
+static void * run_client(void *arg);
+
+static int answer(client_t *client, rewrite_worker_t **worker, size_t *entries, const char *text, size_t size);
+
+static dictionary_t * acquire(server_t *server, int slot);
+
+static void release(server_t *server, int slot);
+
+static void * run_reloader(void *arg);
+
+static void retire(server_t *server, dictionary_t *dictionary);
+
+static int changed(const struct stat *before, const struct stat *now);
+
+static void sleep_ms(long ms);
+
+static void print_error(const char *path, const dictionary_error_t *error);
+
+/****************************************************************
+ * Summary: Serves rewrites until interrupted, or until         *
+ *          standard input ends.                                *
+ *                                                              *
+ * Parameters: address - The path of the socket to listen on,   *
+ *                       or SERVE_STANDARD_STREAMS.             *
+ *             vocabulary - The dictionary file, text or        *
+ *                          compiled. It is watched for         *
+ *                          changes, and should be replaced by  *
+ *                          renaming a new file over it.        *
+ *             threads - As for load_dictionary.                *
+ *                                                              *
+ * Returns: 0 if successful, otherwise SERVE_CANNOT_LOAD,       *
+ *          SERVE_CANNOT_LISTEN or SERVE_NOT_ENOUGH_MEMORY.     *
+ ****************************************************************/
+int serve(const char *address, const char *vocabulary, int threads)
+{
+	int rc = 0;
+	int i = 0;
+	int in_use = 0;
+	int listener = -1;
+	int fd = -1;
+	int slot = 0;
+	int standard = (0 == strcmp(address, SERVE_STANDARD_STREAMS));
+	server_t *server = NULL;
+	client_t *client = NULL;
+	client_t local;
+	dictionary_error_t error;
+	struct sigaction action;
+	sigset_t signals;
+	pthread_t reloader;
+	pthread_t thread;
+
+	/* Allocate memory */
+	server = (server_t *)calloc(1, sizeof(server_t));
+	if (NULL == server) {
+		return SERVE_NOT_ENOUGH_MEMORY;
+	}
+	(*server).vocabulary = vocabulary;
+	(*server).threads = threads;
+
+	stat(vocabulary, &(*server).loaded);
+	(*server).current = open_dictionary(vocabulary, threads, &error);
+	if (NULL == (*server).current) {
+		print_error(vocabulary, &error);
+		free(server);
+		return SERVE_CANNOT_LOAD;
+	}
+
+	if (!standard) {
+		listener = listen_on(address);
+		if (listener < 0) {
+			destroy_dictionary((*server).current);
+			free(server);
+			return SERVE_CANNOT_LISTEN;
+		}
+	}
+
+	/* Interrupts end the server; a client that goes away only ends its connection */
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = SIG_IGN;
+	sigaction(SIGPIPE, &action, NULL);
+	action.sa_handler = stop;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	/* Only this thread takes the interrupts, so they wake accept */
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+	if (0 != pthread_create(&reloader, NULL, run_reloader, server)) {
+		rc = SERVE_NOT_ENOUGH_MEMORY;
+	}
+
+	if (0 == rc && standard) {
+		pthread_sigmask(SIG_UNBLOCK, &signals, NULL);
+		local.server = server;
+		local.slot = claim_slot(server);
+		local.in = stdin;
+		local.out = stdout;
+		run_client(&local);
+	}
+
+	while (0 == rc && !standard && !interrupted) {
+		pthread_sigmask(SIG_UNBLOCK, &signals, NULL);
+		fd = accept(listener, NULL, NULL);
+		pthread_sigmask(SIG_BLOCK, &signals, NULL);
+		if (fd < 0) {
+			continue; /* interrupted, or a connection that went away */
+		}
+
+		slot = claim_slot(server);
+		client = (client_t *)calloc(1, sizeof(client_t));
+		if (slot < 0 || NULL == client) {
+			fprintf(stderr, "Too many connections.\n");
+			free(client);
+			close(fd);
+			if (slot >= 0) {
+				__atomic_store_n(&(*server).claimed[slot], 0, __ATOMIC_RELEASE);
+			}
+			continue;
+		}
+
+		(*client).server = server;
+		(*client).slot = slot;
+		(*client).in = fdopen(fd, "rb");
+		(*client).out = (NULL != (*client).in) ? fdopen(dup(fd), "wb") : NULL;
+		if (NULL == (*client).out || 0 != pthread_create(&thread, NULL, run_client, client)) {
+			if (NULL != (*client).out) {
+				fclose((*client).out);
+			}
+			if (NULL != (*client).in) {
+				fclose((*client).in);
+			} else {
+				close(fd);
+			}
+			__atomic_store_n(&(*server).claimed[slot], 0, __ATOMIC_RELEASE);
+			free(client);
+			continue;
+		}
+		pthread_detach(thread);
+	}
+
+	/* Stop watching the dictionary */
+	__atomic_store_n(&(*server).stopping, 1, __ATOMIC_RELEASE);
+	if (0 == rc) {
+		pthread_join(reloader, NULL);
+	}
+	if (!standard) {
+		close(listener);
+		unlink(address);
+	}
+
+	/* Connections still open keep using the dictionary until the process ends */
+	for (i = 0 ; i < SERVE_MAX_CLIENTS ; ++i) {
+		in_use |= __atomic_load_n(&(*server).claimed[i], __ATOMIC_ACQUIRE);
+	}
+	if (!in_use) {
+		destroy_dictionary((*server).current);
+		free(server);
+	}
+
+	return rc;
+}
+
+static void stop(int signal_number)
+{
+	int saved = errno;
+
+	(void)signal_number;
+	interrupted = 1;
+	errno = saved;
+}
+
+/* Listens on a Unix domain socket, replacing one left by an earlier server */
+static int listen_on(const char *address)
+{
+	int fd = -1;
+	struct sockaddr_un name;
+	struct stat info;
+
+	memset(&name, 0, sizeof(name));
+	name.sun_family = AF_UNIX;
+	if (strlen(address) >= sizeof(name.sun_path)) {
+		fprintf(stderr, "The socket path %s is too long.\n", address);
+		return -1;
+	}
+	strcpy(name.sun_path, address);
+
+	if (0 == stat(address, &info) && S_ISSOCK(info.st_mode)) {
+		unlink(address);
+	}
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || 0 != bind(fd, (struct sockaddr *)&name, sizeof(name)) || 0 != listen(fd, SOMAXCONN)) {
+		fprintf(stderr, "Could not listen on %s: %s.\n", address, strerror(errno));
+		if (fd >= 0) {
+			close(fd);
+		}
+		return -1;
+	}
+
+	return fd;
+}
+
+/* Takes a free hazard slot, or returns -1 */
+static int claim_slot(server_t *server)
+{
+	int i = 0;
+	int expected = 0;
+
+	for (i = 0 ; i < SERVE_MAX_CLIENTS ; ++i) {
+		expected = 0;
+		if (__atomic_compare_exchange_n(&(*server).claimed[i], &expected, 1, 0,
+										__ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/****************************************************************
+ * Summary: Answers the requests of a connection until it ends  *
+ *          or sends something that is not a request.           *
+ *                                                              *
+ * Parameters: arg - The client, freed at the end unless it is  *
+ *                   on the standard streams.                   *
+ *                                                              *
+ * Returns: NULL.                                               *
+ ****************************************************************/
+static void * run_client(void *arg)
+{
+	client_t *client = (client_t *)arg;
+	server_t *server = (*client).server;
+	size_t size = 0;
+	size_t capacity = 0;
+	size_t entries = 0;
+	char *end = NULL;
+	char *text = NULL;
+	char *new_text = NULL;
+	char header[SERVE_MAX_HEADER];
+	rewrite_worker_t *worker = NULL;
+
+	while (NULL != fgets(header, sizeof(header), (*client).in)) {
+		size = (size_t)strtoul(header, &end, 10);
+		if (end == header || '\n' != *end || size > SERVE_MAX_REQUEST) {
+			fprintf((*client).out, "ERR bad request\n");
+			break;
+		}
+
+		if (size > capacity) {
+			new_text = (char *)realloc(text, size);
+			if (NULL == new_text) {
+				fprintf((*client).out, "ERR not enough memory\n");
+				break;
+			}
+			text = new_text;
+			capacity = size;
+		}
+		if (size != fread(text, 1, size, (*client).in)) {
+			break;
+		}
+
+		if (0 != answer(client, &worker, &entries, text, size) || 0 != fflush((*client).out)) {
+			break;
+		}
+	}
+	fflush((*client).out);
+
+	if (NULL != worker) {
+		rewrite_worker_destroy(worker);
+	}
+	free(text);
+	__atomic_store_n(&(*server).claimed[(*client).slot], 0, __ATOMIC_RELEASE);
+	if (stdin != (*client).in) {
+		fclose((*client).in);
+		fclose((*client).out);
+		free(client);
+	}
+
+	return NULL;
+}
+
+/****************************************************************
+ * Summary: Rewrites the text of a request with the dictionary  *
+ *          published now, and writes the answer.               *
+ *                                                              *
+ * Parameters: client - The connection.                         *
+ *             worker - The connection's worker, replaced when  *
+ *                      the dictionary has another size.        *
+ *             entries - The size of the worker's dictionary.   *
+ *             text - The text.                                 *
+ *             size - The length of text.                       *
+ *                                                              *
+ * Returns: 0 if the connection can go on, otherwise -1.        *
+ ****************************************************************/
+static int answer(client_t *client, rewrite_worker_t **worker, size_t *entries, const char *text, size_t size)
+{
+	int rc = 0;
+	char *result = NULL;
+	size_t result_size = 0;
+	uint64_t started = STATS_NOW();
+	FILE *memory = NULL;
+	dictionary_t *dictionary = acquire((*client).server, (*client).slot);
+
+	/* The rotation of a worker has one turn per entry */
+	if (NULL == *worker || *entries != dictionary_entry_count(dictionary)) {
+		if (NULL != *worker) {
+			rewrite_worker_destroy(*worker);
+		}
+		*entries = dictionary_entry_count(dictionary);
+		*worker = rewrite_worker_create(dictionary, 1);
+	} else {
+		(**worker).dictionary = dictionary;
+	}
+
+	memory = open_memstream(&result, &result_size);
+	if (NULL == *worker || NULL == memory) {
+		rc = REWRITE_NOT_ENOUGH_MEMORY;
+	} else {
+		rc = rewrite_worker_text(*worker, text, size, memory);
+	}
+	release((*client).server, (*client).slot);
+	STATS_ADD(STATS_REWRITE_NS, STATS_NOW() - started);
+	if (NULL != memory && 0 != fclose(memory) && 0 == rc) {
+		rc = REWRITE_NOT_ENOUGH_MEMORY;
+	}
+
+	if (0 != rc) {
+		fprintf((*client).out, "ERR not enough memory\n");
+	} else {
+		fprintf((*client).out, "OK %lu\n", (unsigned long)result_size);
+		if (result_size != fwrite(result, 1, result_size, (*client).out)) {
+			rc = -1;
+		}
+	}
+	free(result);
+
+	return (ferror((*client).out)) ? -1 : 0;
+}
+
+/* Announces the dictionary a connection uses, until it is released */
+static dictionary_t * acquire(server_t *server, int slot)
+{
+	dictionary_t *dictionary = NULL;
+
+	/* Once announced, a dictionary that is still published cannot be freed */
+	do {
+		dictionary = __atomic_load_n(&(*server).current, __ATOMIC_SEQ_CST);
+		__atomic_store_n(&(*server).hazards[slot], dictionary, __ATOMIC_SEQ_CST);
+	} while (dictionary != __atomic_load_n(&(*server).current, __ATOMIC_SEQ_CST));
+
+	return dictionary;
+}
+
+static void release(server_t *server, int slot)
+{
+	__atomic_store_n(&(*server).hazards[slot], NULL, __ATOMIC_RELEASE);
+}
+
+/****************************************************************
+ * Summary: Watches the dictionary file, and publishes a new    *
+ *          dictionary whenever it changes. A file that cannot  *
+ *          be loaded is reported and the old dictionary kept.  *
+ *                                                              *
+ * Parameters: arg - The server.                                *
+ *                                                              *
+ * Returns: NULL.                                               *
+ ****************************************************************/
+static void * run_reloader(void *arg)
+{
+	server_t *server = (server_t *)arg;
+	struct stat now;
+	dictionary_t *dictionary = NULL;
+	dictionary_error_t error;
+
+	while (!__atomic_load_n(&(*server).stopping, __ATOMIC_ACQUIRE)) {
+		sleep_ms(SERVE_POLL_MS);
+		if (0 != stat((*server).vocabulary, &now) || !changed(&(*server).loaded, &now)) {
+			continue;
+		}
+
+		(*server).loaded = now;
+		dictionary = open_dictionary((*server).vocabulary, (*server).threads, &error);
+		if (NULL == dictionary) {
+			print_error((*server).vocabulary, &error);
+			fprintf(stderr, "Keeping the dictionary loaded before.\n");
+			continue;
+		}
+
+		dictionary = __atomic_exchange_n(&(*server).current, dictionary, __ATOMIC_SEQ_CST);
+		retire(server, dictionary);
+		fprintf(stderr, "Reloaded %s.\n", (*server).vocabulary);
+	}
+
+	return NULL;
+}
+
+/* Frees a dictionary that is no longer published, once no connection uses it */
+static void retire(server_t *server, dictionary_t *dictionary)
+{
+	int i = 0;
+
+	for (i = 0 ; i < SERVE_MAX_CLIENTS ; ++i) {
+		while (dictionary == __atomic_load_n(&(*server).hazards[i], __ATOMIC_SEQ_CST)) {
+			sleep_ms(1);
+		}
+	}
+
+	destroy_dictionary(dictionary);
+}
+
+static int changed(const struct stat *before, const struct stat *now)
+{
+	return (*before).st_ino != (*now).st_ino || (*before).st_dev != (*now).st_dev ||
+		(*before).st_size != (*now).st_size || (*before).st_mtim.tv_sec != (*now).st_mtim.tv_sec ||
+		(*before).st_mtim.tv_nsec != (*now).st_mtim.tv_nsec;
+}
+
+static void sleep_ms(long ms)
+{
+	struct timespec time;
+
+	time.tv_sec = ms / 1000;
+	time.tv_nsec = (ms % 1000) * 1000000L;
+	nanosleep(&time, NULL);
+}
+
+static void print_error(const char *path, const dictionary_error_t *error)
+{
+	if (0 != (*error).line) {
+		fprintf(stderr, "%s:%lu:%lu: %s.\n", path, (unsigned long)(*error).line,
+				(unsigned long)(*error).column, dictionary_error_text((*error).code));
+	} else {
+		fprintf(stderr, "%s: %s.\n", path, dictionary_error_text((*error).code));
+	}
+}
+
+#else
+
+/* Sockets, threads and signals are POSIX */
+int serve(const char *address, const char *vocabulary, int threads)
+{
+	(void)address;
+	(void)vocabulary;
+	(void)threads;
+
+	return SERVE_NOT_SUPPORTED;
+}
+
+#endif
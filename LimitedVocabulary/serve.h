@@ -0,0 +1,23 @@
+#if !defined(_SERVE_H_)
+#define _SERVE_H_
+
+/* Serves requests on standard input and output instead of a socket */
+#define SERVE_STANDARD_STREAMS ("-")
+
+/* Most connections served at once */
+#define SERVE_MAX_CLIENTS (256)
+
+/* Milliseconds between checks of the dictionary file */
+#define SERVE_POLL_MS (500)
+
+/* Longest text a request may have */
+#define SERVE_MAX_REQUEST (64 << 20)
+
+#define SERVE_CANNOT_LOAD (-1)
+#define SERVE_CANNOT_LISTEN (-2)
+#define SERVE_NOT_ENOUGH_MEMORY (-3)
+#define SERVE_NOT_SUPPORTED (-4)
+
+int serve(const char *address, const char *vocabulary, int threads);
+
+#endif
@@ -0,0 +1,137 @@
+/****************************************************************
+ * Summary: Counters of where a run spends its time and how the *
+ *          dictionary is used: how long loading, rewriting and *
+ *          writing took, how many words were looked up and     *
+ *          found, how many slots a lookup compared, the bytes  *
+ *          read and written, and the peak memory.              *
+ *                                                              *
+ *          The counters are only kept when built with          *
+ *          LV_ENABLE_STATS, see stats.h. They are shared by    *
+ *          every thread and added to atomically.               *
+ ****************************************************************/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE (200809L)
+#endif
+
+#include <time.h>
+#include "stats.h"
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+static uint64_t counters[STATS_COUNT];
+
+static long peak_memory_kb(void);
+
+static double percent(uint64_t part, uint64_t whole);
+
+/****************************************************************
+ * Summary: Adds to a counter. Use STATS_ADD instead, so the    *
+ *          call is left out when the counters are not kept.    *
+ *                                                              *
+ * Parameters: counter - One of the STATS_ counters.            *
+ *             amount - What to add.                            *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void stats_add(int counter, uint64_t amount)
+{
+	__atomic_fetch_add(&counters[counter], amount, __ATOMIC_RELAXED);
+}
+
+/****************************************************************
+ * Summary: Gets the time to measure a phase from. Use          *
+ *          STATS_NOW instead.                                  *
+ *                                                              *
+ * Returns: Nanoseconds from some fixed point.                  *
+ ****************************************************************/
+uint64_t stats_now(void)
+{
+#if !defined(_WIN32)
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#else
+	return (uint64_t)clock() * (1000000000u / CLOCKS_PER_SEC);
+#endif
+}
+
+/****************************************************************
+ * Summary: Prints the counters.                                *
+ *                                                              *
+ * Parameters: out - Receives the counters.                     *
+ *             format - STATS_TEXT for people, STATS_JSON for   *
+ *                      one JSON object on one line.            *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void stats_print(FILE *out, int format)
+{
+	const char *enabled = "true";
+	uint64_t lookups = counters[STATS_LOOKUPS];
+	double probes = (0 == lookups) ? 0.0 : (double)counters[STATS_PROBES] / (double)lookups;
+
+#if !defined(LV_ENABLE_STATS)
+	enabled = "false";
+	if (STATS_TEXT == format) {
+		fprintf(out, "Statistics are not kept by this build, build with -DLV_ENABLE_STATS.\n");
+		return;
+	}
+#endif
+
+	if (STATS_JSON == format) {
+		fprintf(out, "{\"enabled\":%s,\"load_ms\":%.3f,\"rewrite_ms\":%.3f,\"write_ms\":%.3f,"
+				"\"words\":%llu,\"replaced\":%llu,\"phrases\":%llu,"
+				"\"lookups\":%llu,\"hits\":%llu,\"misses\":%llu,\"probes_per_lookup\":%.3f,"
+				"\"bytes_in\":%llu,\"bytes_out\":%llu,\"peak_memory_kb\":%ld}\n", enabled,
+				counters[STATS_LOAD_NS] / 1e6, counters[STATS_REWRITE_NS] / 1e6, counters[STATS_WRITE_NS] / 1e6,
+				(unsigned long long)counters[STATS_WORDS], (unsigned long long)counters[STATS_REPLACED],
+				(unsigned long long)counters[STATS_PHRASES], (unsigned long long)lookups,
+				(unsigned long long)counters[STATS_HITS], (unsigned long long)(lookups - counters[STATS_HITS]),
+				probes, (unsigned long long)counters[STATS_BYTES_IN],
+				(unsigned long long)counters[STATS_BYTES_OUT], peak_memory_kb());
+		return;
+	}
+
+	fprintf(out, "load            %12.3f ms\n", counters[STATS_LOAD_NS] / 1e6);
+	fprintf(out, "rewrite         %12.3f ms\n", counters[STATS_REWRITE_NS] / 1e6);
+	fprintf(out, "  of it writing %12.3f ms\n", counters[STATS_WRITE_NS] / 1e6);
+	fprintf(out, "words           %12llu\n", (unsigned long long)counters[STATS_WORDS]);
+	fprintf(out, "replaced        %12llu  %6.2f%% of words\n", (unsigned long long)counters[STATS_REPLACED],
+			percent(counters[STATS_REPLACED], counters[STATS_WORDS]));
+	fprintf(out, "  phrases       %12llu\n", (unsigned long long)counters[STATS_PHRASES]);
+	fprintf(out, "lookups         %12llu  %.3f probes each\n", (unsigned long long)lookups, probes);
+	fprintf(out, "  hits          %12llu  %6.2f%%\n", (unsigned long long)counters[STATS_HITS],
+			percent(counters[STATS_HITS], lookups));
+	fprintf(out, "  misses        %12llu  %6.2f%%\n", (unsigned long long)(lookups - counters[STATS_HITS]),
+			percent(lookups - counters[STATS_HITS], lookups));
+	fprintf(out, "bytes in        %12llu\n", (unsigned long long)counters[STATS_BYTES_IN]);
+	fprintf(out, "bytes out       %12llu\n", (unsigned long long)counters[STATS_BYTES_OUT]);
+	fprintf(out, "peak memory     %12ld KB\n", peak_memory_kb());
+}
+
+/* The largest resident size the process had, 0 if unknown */
+static long peak_memory_kb(void)
+{
+#if !defined(_WIN32)
+	struct rusage usage;
+
+	if (0 != getrusage(RUSAGE_SELF, &usage)) {
+		return 0;
+	}
+#if defined(__APPLE__)
+	return usage.ru_maxrss / 1024; /* in bytes there */
+#else
+	return usage.ru_maxrss;
+#endif
+#else
+	return 0;
+#endif
+}
+
+static double percent(uint64_t part, uint64_t whole)
+{
+	return (0 == whole) ? 0.0 : 100.0 * (double)part / (double)whole;
+}
@@ -0,0 +1,44 @@
+#if !defined(_STATS_H_)
+#define _STATS_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* What is counted, times in nanoseconds of the threads that spent them */
+#define STATS_LOAD_NS (0)
+#define STATS_REWRITE_NS (1)
+#define STATS_WRITE_NS (2)
+#define STATS_WORDS (3)					/* words rewritten */
+#define STATS_REPLACED (4)				/* words and phrases given a synonym */
+#define STATS_PHRASES (5)				/* phrases of more than one word given a synonym */
+#define STATS_LOOKUPS (6)
+#define STATS_HITS (7)
+#define STATS_PROBES (8)				/* slots or entries compared by the lookups */
+#define STATS_BYTES_IN (9)
+#define STATS_BYTES_OUT (10)
+#define STATS_COUNT (11)
+
+/* Formats of stats_print */
+#define STATS_TEXT (0)
+#define STATS_JSON (1)
+
+/*
+ * Built with LV_ENABLE_STATS, the macros count with atomic adds.
+ * Without it they are not compiled at all, and their arguments are
+ * not evaluated.
+ */
+#if defined(LV_ENABLE_STATS)
+#define STATS_ADD(counter, amount) stats_add((counter), (uint64_t)(amount))
+#define STATS_NOW() stats_now()
+#else
+#define STATS_ADD(counter, amount) ((void)sizeof(amount))
+#define STATS_NOW() ((uint64_t)0)
+#endif
+
+void stats_add(int counter, uint64_t amount);
+
+uint64_t stats_now(void);
+
+void stats_print(FILE *out, int format);
+
+#endif
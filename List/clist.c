@@ -0,0 +1,314 @@
+/****************************************************************
+ * Summary: This library implements a compact bi-directional    *
+ *          linked list. Nodes live in one growable array and   *
+ *          are linked by 32-bit indices, so a node takes 12    *
+ *          bytes instead of 24 on 64-bit hosts, and handles    *
+ *          stay valid when the array is reallocated.           *
+ ****************************************************************/
+
+#include <stdlib.h>
+#include "clist.h"
+
+#define CLIST_INITIAL_CAPACITY (16)
+
+static int grow(clist_t * list);
+
+/****************************************************************
+ * Summary: Creates an empty list and returns a pointer         *
+ *          to the list.                                        *
+ *                                                              *
+ * Parameters: None.                                            *
+ *                                                              *
+ * Returns: A pointer to clist_t or NULL if failed.             *
+ ****************************************************************/
+clist_t * clist_create()
+{
+	/* Allocate memory. */
+	clist_t * new_list = (clist_t *)malloc(sizeof(clist_t));
+
+	/* Check if malloc succeeded. */
+	if (new_list == NULL) {
+		return NULL;
+	}
+
+	/* Initialize members. */
+	new_list->count = 0;
+	new_list->sum = 0;
+	new_list->head = CLIST_NONE;
+	new_list->tail = CLIST_NONE;
+	new_list->free_head = CLIST_NONE;
+	new_list->used = 0;
+	new_list->capacity = 0;
+	new_list->nodes = NULL;
+
+	return new_list;
+}
+
+/****************************************************************
+ * Summary: Destroys a list, freeing memory.                    *
+ *                                                              *
+ * Parameters: list - A pointer to the clist_t to destroy.      *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void clist_destroy(clist_t * list)
+{
+	free(list->nodes);
+	free(list);
+}
+
+/****************************************************************
+ * Summary: Adds value to the end of the list, reusing the slot *
+ *          of the last removed node if there is one.           *
+ *                                                              *
+ * Parameters: list - A pointer to the clist_t.                 *
+ *             value - The value to add.                        *
+ *                                                              *
+ * Returns: The handle of the added node or CLIST_NONE if       *
+ *          failed.                                             *
+ ****************************************************************/
+clist_handle_t clist_add_node(clist_t * list, int value)
+{
+	clist_handle_t new_node;
+	clist_node_t * nodes;
+
+	/* Take a free slot, or a new one. */
+	if (list->free_head != CLIST_NONE) {
+		new_node = list->free_head;
+		list->free_head = list->nodes[new_node].next;
+	} else {
+		if (list->used == list->capacity && grow(list) != 0) {
+			return CLIST_NONE;
+		}
+		new_node = list->used;
+		++(list->used);
+	}
+	nodes = list->nodes;
+
+	/* Initialize and add to list. */
+	nodes[new_node].val = value;
+	nodes[new_node].prev = list->tail;
+	nodes[new_node].next = CLIST_NONE;
+	if (list->tail != CLIST_NONE) { /* if not adding to an empty list */
+		nodes[list->tail].next = new_node;
+	}
+	list->tail = new_node;
+	if (list->head == CLIST_NONE) { /* if adding to an empty list */
+		list->head = new_node;
+	}
+
+	/* Update list's count and sum. */
+	++(list->count);
+	list->sum += value;
+
+	return new_node;
+}
+
+/****************************************************************
+ * Summary: Removes a node from a list, its slot goes on the    *
+ *          free chain.                                         *
+ *                                                              *
+ * Parameters: list - A pointer to the clist_t.                 *
+ *             node - The handle of the node to remove.         *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void clist_remove_node(clist_t * list, clist_handle_t node)
+{
+	clist_node_t * nodes = list->nodes;
+
+	/* Update list's count and sum. */
+	--(list->count);
+	list->sum -= nodes[node].val;
+
+	/* Remove from list. */
+	if (nodes[node].next == CLIST_NONE) { /* if removing tail */
+		list->tail = nodes[node].prev;
+	} else {
+		nodes[nodes[node].next].prev = nodes[node].prev;
+	}
+	if (nodes[node].prev == CLIST_NONE) { /* if removing head */
+		list->head = nodes[node].next;
+	} else { /* if removing a node from the middle */
+		nodes[nodes[node].prev].next = nodes[node].next;
+	}
+
+	/* Put the slot on the free chain. */
+	nodes[node].next = list->free_head;
+	list->free_head = node;
+}
+
+/****************************************************************
+ * Summary: Gets the amount of values in a list.                *
+ *                                                              *
+ * Parameters: list - A pointer to the clist_t.                 *
+ *                                                              *
+ * Returns: The amount of values in the list.                   *
+ ****************************************************************/
+int clist_get_count(clist_t * list)
+{
+	return list->count;
+}
+
+/****************************************************************
+ * Summary: Gets the average of the values in a list.           *
+ *                                                              *
+ * Parameters: list - A pointer to the clist_t.                 *
+ *                                                              *
+ * Returns: The average of the values in the list, 0 if the     *
+ *          list is empty.                                      *
+ ****************************************************************/
+double clist_get_average(clist_t * list)
+{
+	if (list->count == 0) {
+		return 0;
+	}
+	return (double)(list->sum) / (list->count);
+}
+
+/****************************************************************
+ * Summary: Gets the first node in a list.                      *
+ *                                                              *
+ * Parameters: list - A pointer to the clist_t.                 *
+ *                                                              *
+ * Returns: The handle of the first node, CLIST_NONE if empty.  *
+ ****************************************************************/
+clist_handle_t clist_get_head(clist_t * list)
+{
+	return list->head;
+}
+
+/****************************************************************
+ * Summary: Gets the last node in a list.                       *
+ *                                                              *
+ * Parameters: list - A pointer to the clist_t.                 *
+ *                                                              *
+ * Returns: The handle of the last node, CLIST_NONE if empty.   *
+ ****************************************************************/
+clist_handle_t clist_get_tail(clist_t * list)
+{
+	return list->tail;
+}
+
+/****************************************************************
+ * Summary: Gets the next node.                                 *
+ *                                                              *
+ * Parameters: list - A pointer to the clist_t.                 *
+ *             node - The handle of the node.                   *
+ *                                                              *
+ * Returns: The handle of the next node, CLIST_NONE at the end. *
+ ****************************************************************/
+clist_handle_t clist_get_next_node(clist_t * list, clist_handle_t node)
+{
+	return list->nodes[node].next;
+}
+
+/****************************************************************
+ * Summary: Gets the previous node.                             *
+ *                                                              *
+ * Parameters: list - A pointer to the clist_t.                 *
+ *             node - The handle of the node.                   *
+ *                                                              *
+ * Returns: The handle of the previous node, CLIST_NONE at the  *
+ *          start.                                              *
+ ****************************************************************/
+clist_handle_t clist_get_prev_node(clist_t * list, clist_handle_t node)
+{
+	return list->nodes[node].prev;
+}
+
+/****************************************************************
+ * Summary: Gets the value of a node.                           *
+ *                                                              *
+ * Parameters: list - A pointer to the clist_t.                 *
+ *             node - The handle of the node.                   *
+ *                                                              *
+ * Returns: The value of the node.                              *
+ ****************************************************************/
+int clist_get_node_value(clist_t * list, clist_handle_t node)
+{
+	return list->nodes[node].val;
+}
+
+/****************************************************************
+ * Summary: Rewrites the node array in traversal order, so that *
+ *          the i-th node is at index i, and releases the free  *
+ *          slots. Traversal then reads memory sequentially.    *
+ *          Every handle changes.                               *
+ *                                                              *
+ * Parameters: list - A pointer to the clist_t.                 *
+ *             remap - An array of list->used handles that gets *
+ *                     the new handle of every old handle, or   *
+ *                     CLIST_NONE for free slots. May be NULL.  *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if failed.          *
+ ****************************************************************/
+int clist_compact(clist_t * list, clist_handle_t * remap)
+{
+	unsigned int i = 0;
+	unsigned int capacity = 0;
+	clist_handle_t node;
+	clist_node_t * nodes = NULL;
+
+	if (remap != NULL) {
+		for (i = 0 ; i < list->used ; ++i) {
+			remap[i] = CLIST_NONE;
+		}
+	}
+
+	/* Copy the nodes in traversal order to a right-sized array. */
+	if (list->count > 0) {
+		capacity = (unsigned int)(list->count);
+		nodes = (clist_node_t *)malloc(sizeof(clist_node_t) * capacity);
+		if (nodes == NULL) {
+			return -1;
+		}
+	}
+	i = 0;
+	for (node = list->head ; node != CLIST_NONE ; node = list->nodes[node].next) {
+		nodes[i].val = list->nodes[node].val;
+		nodes[i].prev = (i == 0) ? CLIST_NONE : i - 1;
+		nodes[i].next = (i + 1 == capacity) ? CLIST_NONE : i + 1;
+		if (remap != NULL) {
+			remap[node] = i;
+		}
+		++i;
+	}
+
+	free(list->nodes);
+	list->nodes = nodes;
+	list->capacity = capacity;
+	list->used = capacity;
+	list->free_head = CLIST_NONE;
+	list->head = (capacity == 0) ? CLIST_NONE : 0;
+	list->tail = (capacity == 0) ? CLIST_NONE : capacity - 1;
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Doubles the node array.                             *
+ *                                                              *
+ * Parameters: list - A pointer to the clist_t.                 *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if failed.          *
+ ****************************************************************/
+static int grow(clist_t * list)
+{
+	unsigned int capacity;
+	clist_node_t * nodes;
+
+	capacity = (list->capacity == 0) ? CLIST_INITIAL_CAPACITY : list->capacity * 2;
+	if (capacity <= list->capacity || capacity >= CLIST_NONE) { /* out of handles */
+		return -1;
+	}
+
+	nodes = (clist_node_t *)realloc(list->nodes, sizeof(clist_node_t) * capacity);
+	if (nodes == NULL) {
+		return -1;
+	}
+	list->nodes = nodes;
+	list->capacity = capacity;
+
+	return 0;
+}
@@ -0,0 +1,51 @@
+#if !defined(_CLIST_H_)
+#define _CLIST_H_
+
+/* A handle is the index of a node in the list's node array. */
+typedef unsigned int clist_handle_t;
+
+/* No node: the end of the list, or a failed allocation. */
+#define CLIST_NONE (0xffffffffu)
+
+typedef struct clist_node_rec {
+	int val;
+	unsigned int next;
+	unsigned int prev;
+} clist_node_t;
+
+typedef struct clist_rec {
+	int count;
+	long long sum;
+	unsigned int head;
+	unsigned int tail;
+	unsigned int free_head;		/* removed slots, linked through next */
+	unsigned int used;			/* slots ever handed out */
+	unsigned int capacity;		/* slots allocated */
+	struct clist_node_rec * nodes;
+} clist_t;
+
+clist_t * clist_create();
+
+void clist_destroy(clist_t * list);
+
+clist_handle_t clist_add_node(clist_t * list, int value);
+
+void clist_remove_node(clist_t * list, clist_handle_t node);
+
+int clist_get_count(clist_t * list);
+
+double clist_get_average(clist_t * list);
+
+clist_handle_t clist_get_head(clist_t * list);
+
+clist_handle_t clist_get_tail(clist_t * list);
+
+clist_handle_t clist_get_next_node(clist_t * list, clist_handle_t node);
+
+clist_handle_t clist_get_prev_node(clist_t * list, clist_handle_t node);
+
+int clist_get_node_value(clist_t * list, clist_handle_t node);
+
+int clist_compact(clist_t * list, clist_handle_t * remap);
+
+#endif
@@ -4,7 +4,31 @@
  ****************************************************************/
 
 #include <stdlib.h>
+#include <limits.h>
 #include "list.h"
+#include "ostree.h"
+#include "vmap.h"
+#include "slab.h"
+
+/* Enough runs of doubling length to sort INT_MAX nodes. */
+#define LIST_SORT_RUNS (32)
+
+static list_node_t * node_alloc(list_t * list);
+static void node_free(list_t * list, list_node_t * node);
+static list_node_t * copy_nodes(list_t * list, list_node_t * first, list_node_t ** last);
+static void free_nodes(list_t * list, list_node_t * first);
+static void sumsq_add(list_t * list, int value);
+static void sumsq_sub(list_t * list, int value);
+static void mul_u64(unsigned long long a, unsigned long long b,
+					unsigned long long * lo, unsigned long long * hi);
+static void refresh_min_max(list_t * list);
+static int collect(list_t * list, int value, list_node_t ** out, int size, int found);
+static int extras_add(list_t * list, list_node_t * first);
+static void extras_remove(list_t * list, list_node_t * first, list_node_t * end);
+static void measure(list_node_t * first, list_node_t * end, list_t * part);
+static void copy_aggregates(list_t * dest, list_t * src);
+static void take_part(list_t * list, list_t * part);
+static list_node_t * merge(list_node_t * left, list_node_t * right);
 
 /****************************************************************
  * Summary: Creates an empty list and returns a pointer         *
@@ -26,13 +50,49 @@ list_t * list_create()
 
 	/* Initialize members. */
 	new_list->count = 0;
-	new_list->avg = 0;
+	new_list->sum = 0;
+	new_list->sumsq_lo = 0;
+	new_list->sumsq_hi = 0;
+	new_list->min = 0;
+	new_list->max = 0;
+	new_list->minmax_stale = 0;
+	new_list->order = NULL;
+	new_list->index = NULL;
+	new_list->slab = NULL;
 	new_list->head = NULL;
 	new_list->tail = NULL;
 
 	return new_list;
 }
 
+/****************************************************************
+ * Summary: Creates an empty list whose nodes come from its own *
+ *          slab allocator, so nodes are laid out contiguously  *
+ *          in creation order, removed nodes are reused and     *
+ *          list_destroy frees whole slabs at once.             *
+ *                                                              *
+ * Parameters: nodes_per_slab - Nodes per slab, or 0 for the    *
+ *                              default.                        *
+ *                                                              *
+ * Returns: A pointer to list_t or NULL if failed.              *
+ ****************************************************************/
+list_t * list_create_pooled(int nodes_per_slab)
+{
+	list_t * new_list = list_create();
+
+	if (new_list == NULL) {
+		return NULL;
+	}
+
+	new_list->slab = slab_create((int)sizeof(list_node_t), nodes_per_slab);
+	if (new_list->slab == NULL) {
+		free(new_list);
+		return NULL;
+	}
+
+	return new_list;
+}
+
 /****************************************************************
  * Summary: Destroys a list, freeing memory.                    *
  *                                                              *
@@ -42,9 +102,25 @@ list_t * list_create()
  ****************************************************************/
 void list_destroy(list_t * list)
 {
+	list_node_t * node = list->head;
+	list_node_t * next;
+
 	/* Free all nodes' memory. */
-	while (list->head != NULL) {
-		list_remove_node(list, list->head);
+	if (list->slab != NULL) {
+		slab_destroy(list->slab);
+	} else {
+		while (node != NULL) {
+			next = node->next;
+			free(node);
+			node = next;
+		}
+	}
+	/* Free the sorted values. */
+	if (list->order != NULL) {
+		ostree_destroy(list->order);
+	}
+	if (list->index != NULL) {
+		vmap_destroy(list->index);
 	}
 	/* Free list memory. */
 	free(list);
@@ -61,17 +137,29 @@ void list_destroy(list_t * list)
  ****************************************************************/
 list_node_t * list_add_node(list_t * list, int value)
 {
-	double sum;
 	list_node_t * new_node;
 	
 	/* Allocate memory. */
-	new_node = (list_node_t *)malloc(sizeof(list_node_t));
+	new_node = node_alloc(list);
 	
-	/* Check if malloc succeeded. */
+	/* Check if allocation succeeded. */
 	if (new_node == NULL) {
 		return NULL;
 	}
 
+	/* Add to the sorted values and the index. */
+	if (list->order != NULL && ostree_insert(list->order, value) != 0) {
+		node_free(list, new_node);
+		return NULL;
+	}
+	if (list->index != NULL && vmap_insert(list->index, value, new_node) != 0) {
+		if (list->order != NULL) {
+			ostree_remove(list->order, value);
+		}
+		node_free(list, new_node);
+		return NULL;
+	}
+
 	/* Initialize and add to list. */
 	new_node->val = value;
 	new_node->prev = list->tail;
@@ -84,11 +172,22 @@ list_node_t * list_add_node(list_t * list, int value)
 		list->head = new_node;
 	}
 
-	/* Update list's count and avg. */
-	sum = (list->avg) * (list->count);
-	sum += value;
+	/* Update list's aggregates. */
+	if (list->count == 0) {
+		list->min = value;
+		list->max = value;
+		list->minmax_stale = 0;
+	} else if (!list->minmax_stale) {
+		if (value < list->min) {
+			list->min = value;
+		}
+		if (value > list->max) {
+			list->max = value;
+		}
+	}
 	++(list->count);
-	list->avg = sum / (list->count);
+	list->sum += value;
+	sumsq_add(list, value);
 
 	return new_node;
 }
@@ -103,13 +202,21 @@ list_node_t * list_add_node(list_t * list, int value)
  ****************************************************************/
 void list_remove_node(list_t * list, list_node_t * node)
 {
-	double sum;
-
-	/* Update list's count and avg. */
-	sum = (list->avg) * (list->count);
-	sum -= (node->val);
+	/* Update list's aggregates. */
 	--(list->count);
-	list->avg = sum / (list->count);
+	list->sum -= node->val;
+	sumsq_sub(list, node->val);
+	if (list->count == 0) {
+		list->minmax_stale = 0;
+	} else if (node->val == list->min || node->val == list->max) {
+		list->minmax_stale = 1;
+	}
+	if (list->order != NULL) {
+		ostree_remove(list->order, node->val);
+	}
+	if (list->index != NULL) {
+		vmap_remove(list->index, node->val, node);
+	}
 
 	/* Remove from list. */
 	if (node->next == NULL) { /* if removing tail */
@@ -124,7 +231,7 @@ void list_remove_node(list_t * list, list_node_t * node)
 	}
 	
 	/* Free memory. */
-	free(node);
+	node_free(list, node);
 }
 
 /****************************************************************
@@ -144,11 +251,755 @@ int list_get_count(list_t * list)
  *                                                              *
  * Parameters: list - A pointer to the list_t.                  *
  *                                                              *
- * Returns: The average of the values in the list.              *
+ * Returns: The average of the values in the list, 0 if the     *
+ *          list is empty.                                      *
  ****************************************************************/
 double list_get_average(list_t * list)
 {
-	return list->avg;
+	if (list->count == 0) {
+		return 0;
+	}
+	return (double)(list->sum) / (list->count);
+}
+
+/****************************************************************
+ * Summary: Gets the exact sum of the values in a list.         *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *                                                              *
+ * Returns: The sum of the values in the list.                  *
+ ****************************************************************/
+long long list_get_sum(list_t * list)
+{
+	return list->sum;
+}
+
+/****************************************************************
+ * Summary: Gets the population variance of the values in a     *
+ *          list. The numerator n*sum(x^2) - sum(x)^2 is        *
+ *          computed exactly in 128 bits and rounded once.      *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *                                                              *
+ * Returns: The variance of the values in the list, 0 if the    *
+ *          list is empty.                                      *
+ ****************************************************************/
+double list_get_variance(list_t * list)
+{
+	unsigned long long n = (unsigned long long)(list->count);
+	unsigned long long abs_sum;
+	unsigned long long num_lo, num_hi;
+	unsigned long long sq_lo, sq_hi;
+	unsigned long long high_part, unused;
+
+	if (n == 0) {
+		return 0;
+	}
+
+	/* n * sum of squares */
+	mul_u64(list->sumsq_lo, n, &num_lo, &num_hi);
+	mul_u64(list->sumsq_hi, n, &high_part, &unused);
+	num_hi += high_part;
+
+	/* minus the square of the sum */
+	abs_sum = (list->sum < 0) ? (0ULL - (unsigned long long)(list->sum))
+							  : (unsigned long long)(list->sum);
+	mul_u64(abs_sum, abs_sum, &sq_lo, &sq_hi);
+	num_hi -= sq_hi + (num_lo < sq_lo);
+	num_lo -= sq_lo;
+
+	return (double)(((long double)num_hi * 18446744073709551616.0L + (long double)num_lo) /
+					((long double)n * (long double)n));
+}
+
+/****************************************************************
+ * Summary: Gets the smallest value in a list. Takes O(log n)   *
+ *          with order statistics enabled, otherwise O(1) until *
+ *          the smallest or largest value is removed. The next  *
+ *          call then enables order statistics, taking          *
+ *          O(n log n) once, so that later removals and calls   *
+ *          take O(log n). Should that run out of memory, the   *
+ *          list is scanned instead, which takes O(n) after     *
+ *          every such removal.                                 *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             out - A pointer to an int to hold the value.     *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if the list is      *
+ *          empty.                                              *
+ ****************************************************************/
+int list_get_min(list_t * list, int * out)
+{
+	if (list->count == 0) {
+		return -1;
+	}
+	if (list->order == NULL && list->minmax_stale) {
+		refresh_min_max(list);
+	}
+	if (list->order != NULL) {
+		return ostree_get_min(list->order, out);
+	}
+	*out = list->min;
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Gets the largest value in a list, see list_get_min. *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             out - A pointer to an int to hold the value.     *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if the list is      *
+ *          empty.                                              *
+ ****************************************************************/
+int list_get_max(list_t * list, int * out)
+{
+	if (list->count == 0) {
+		return -1;
+	}
+	if (list->order == NULL && list->minmax_stale) {
+		refresh_min_max(list);
+	}
+	if (list->order != NULL) {
+		return ostree_get_max(list->order, out);
+	}
+	*out = list->max;
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Starts keeping the values of a list in an order     *
+ *          statistic tree next to the insertion-order links,   *
+ *          so that list_add_node and list_remove_node take     *
+ *          O(log n) and order statistics can be queried.       *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if failed.          *
+ ****************************************************************/
+int list_enable_order_stats(list_t * list)
+{
+	list_node_t * node;
+	struct ostree_rec * order;
+
+	if (list->order != NULL) { /* already enabled */
+		return 0;
+	}
+
+	/* Allocate memory. */
+	order = ostree_create();
+	if (order == NULL) {
+		return -1;
+	}
+
+	/* Add the current values. */
+	for (node = list->head ; node != NULL ; node = node->next) {
+		if (ostree_insert(order, node->val) != 0) {
+			ostree_destroy(order);
+			return -1;
+		}
+	}
+	list->order = order;
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Stops keeping order statistics, freeing memory.     *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void list_disable_order_stats(list_t * list)
+{
+	if (list->order != NULL) {
+		ostree_destroy(list->order);
+		list->order = NULL;
+	}
+}
+
+/****************************************************************
+ * Summary: Gets the k-th smallest value in a list.             *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             k - The 0-based position in sorted order.        *
+ *             out - A pointer to an int to hold the value.     *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if k is out of      *
+ *          range or order statistics are not enabled.          *
+ ****************************************************************/
+int list_get_kth(list_t * list, int k, int * out)
+{
+	if (list->order == NULL) {
+		return -1;
+	}
+	return ostree_select(list->order, k, out);
+}
+
+/****************************************************************
+ * Summary: Gets a percentile of the values in a list using the *
+ *          nearest-rank method.                                *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             percent - The percentile, between 0 and 100.     *
+ *             out - A pointer to an int to hold the value.     *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if the list is      *
+ *          empty, percent is out of range or order statistics  *
+ *          are not enabled.                                    *
+ ****************************************************************/
+int list_get_percentile(list_t * list, double percent, int * out)
+{
+	int rank;
+	double position;
+
+	if (list->order == NULL || list->count == 0 || percent < 0 || percent > 100) {
+		return -1;
+	}
+
+	/* rank = ceil(percent / 100 * count), at least 1 */
+	position = percent * (list->count) / 100.0;
+	rank = (int)position;
+	if ((double)rank < position) {
+		++rank;
+	}
+	if (rank < 1) {
+		rank = 1;
+	}
+
+	return ostree_select(list->order, rank - 1, out);
+}
+
+/****************************************************************
+ * Summary: Gets the median of the values in a list, the lower  *
+ *          of the two middle values if the count is even.      *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             out - A pointer to an int to hold the value.     *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if the list is      *
+ *          empty or order statistics are not enabled.          *
+ ****************************************************************/
+int list_get_median(list_t * list, int * out)
+{
+	return list_get_percentile(list, 50, out);
+}
+
+/****************************************************************
+ * Summary: Starts keeping an index from values to nodes, so    *
+ *          that finding a value takes O(1). list_add_node and  *
+ *          list_remove_node then also update the index.        *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if failed.          *
+ ****************************************************************/
+int list_enable_index(list_t * list)
+{
+	list_node_t * node;
+	struct vmap_rec * index;
+
+	if (list->index != NULL) { /* already enabled */
+		return 0;
+	}
+
+	/* Allocate memory. */
+	index = vmap_create();
+	if (index == NULL) {
+		return -1;
+	}
+
+	/* Add the current nodes, in list order. */
+	for (node = list->head ; node != NULL ; node = node->next) {
+		if (vmap_insert(index, node->val, node) != 0) {
+			vmap_destroy(index);
+			return -1;
+		}
+	}
+	list->index = index;
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Stops keeping the index, freeing memory. Searches   *
+ *          then scan the list.                                 *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void list_disable_index(list_t * list)
+{
+	if (list->index != NULL) {
+		vmap_destroy(list->index);
+		list->index = NULL;
+	}
+}
+
+/****************************************************************
+ * Summary: Finds a node holding value. With the index enabled  *
+ *          this is any such node, otherwise the first one in   *
+ *          the list.                                           *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             value - The value to find.                       *
+ *                                                              *
+ * Returns: A pointer to the list_node_t or NULL if not found.  *
+ ****************************************************************/
+list_node_t * list_find(list_t * list, int value)
+{
+	list_node_t * node;
+	list_node_t ** nodes;
+	struct vmap_entry_rec * entry;
+
+	if (list->index != NULL) {
+		entry = vmap_find(list->index, value);
+		if (entry == NULL) {
+			return NULL;
+		}
+		vmap_get_nodes(entry, &nodes);
+		return nodes[0];
+	}
+
+	for (node = list->head ; node != NULL ; node = node->next) {
+		if (node->val == value) {
+			return node;
+		}
+	}
+
+	return NULL;
+}
+
+/****************************************************************
+ * Summary: Finds every node holding value, in list order       *
+ *          unless the index is enabled.                        *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             value - The value to find.                       *
+ *             out - An array to hold the nodes, may be NULL.   *
+ *             size - The size of out, extra nodes are counted  *
+ *                    but not stored.                           *
+ *                                                              *
+ * Returns: The amount of nodes holding value.                  *
+ ****************************************************************/
+int list_find_all(list_t * list, int value, list_node_t ** out, int size)
+{
+	return collect(list, value, out, size, 0);
+}
+
+/****************************************************************
+ * Summary: Checks whether a list holds a value.                *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             value - The value to find.                       *
+ *                                                              *
+ * Returns: 1 if the value is in the list, otherwise 0.         *
+ ****************************************************************/
+int list_contains(list_t * list, int value)
+{
+	return list_find(list, value) != NULL;
+}
+
+/****************************************************************
+ * Summary: Counts the nodes whose value is between low and     *
+ *          high, inclusive. Takes O(log n) with order          *
+ *          statistics enabled, otherwise scans the list.       *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             low - The smallest value to count.               *
+ *             high - The largest value to count.               *
+ *                                                              *
+ * Returns: The amount of nodes in the range.                   *
+ ****************************************************************/
+int list_count_range(list_t * list, int low, int high)
+{
+	int count = 0;
+	list_node_t * node;
+
+	if (low > high) {
+		return 0;
+	}
+
+	if (list->order != NULL) {
+		/* values <= high minus values < low */
+		count = (high == INT_MAX) ? list->count : ostree_rank(list->order, high + 1);
+		return count - ostree_rank(list->order, low);
+	}
+
+	for (node = list->head ; node != NULL ; node = node->next) {
+		count += (node->val >= low && node->val <= high);
+	}
+
+	return count;
+}
+
+/****************************************************************
+ * Summary: Finds every node whose value is between low and     *
+ *          high, inclusive, grouped by increasing value when   *
+ *          both the index and order statistics are enabled, in *
+ *          O(d log n + k) for d distinct values and k nodes.   *
+ *          Otherwise the nodes are found by scanning the list. *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             low - The smallest value to find.                *
+ *             high - The largest value to find.                *
+ *             out - An array to hold the nodes, may be NULL.   *
+ *             size - The size of out, extra nodes are counted  *
+ *                    but not stored.                           *
+ *                                                              *
+ * Returns: The amount of nodes in the range.                   *
+ ****************************************************************/
+int list_find_range(list_t * list, int low, int high, list_node_t ** out, int size)
+{
+	int found = 0;
+	int value = 0;
+	list_node_t * node;
+
+	if (low > high) {
+		return 0;
+	}
+
+	if (list->index != NULL && list->order != NULL) {
+		/* Visit the distinct values in the range in order. */
+		while (ostree_ceil(list->order, low, &value) == 0 && value <= high) {
+			found = collect(list, value, out, size, found);
+			if (value == high) {
+				break;
+			}
+			low = value + 1;
+		}
+		return found;
+	}
+
+	for (node = list->head ; node != NULL ; node = node->next) {
+		if (node->val >= low && node->val <= high) {
+			if (out != NULL && found < size) {
+				out[found] = node;
+			}
+			++found;
+		}
+	}
+
+	return found;
+}
+
+/****************************************************************
+ * Summary: Creates a list holding the values of an array, in   *
+ *          order. All nodes come from one slab, so they are    *
+ *          contiguous, and no per-node malloc is made.         *
+ *                                                              *
+ * Parameters: values - The array of values.                    *
+ *             count - The amount of values.                    *
+ *                                                              *
+ * Returns: A pointer to list_t or NULL if failed.              *
+ ****************************************************************/
+list_t * list_from_array(const int * values, int count)
+{
+	int i;
+	list_node_t * node;
+	list_node_t * prev = NULL;
+	list_t * new_list;
+
+	if (count < 0 || (values == NULL && count > 0)) {
+		return NULL;
+	}
+
+	new_list = list_create_pooled(count);
+	if (new_list == NULL) {
+		return NULL;
+	}
+
+	for (i = 0 ; i < count ; ++i) {
+		node = (list_node_t *)slab_alloc(new_list->slab);
+		if (node == NULL) {
+			list_destroy(new_list);
+			return NULL;
+		}
+		node->val = values[i];
+		node->prev = prev;
+		node->next = NULL;
+		if (prev == NULL) {
+			new_list->head = node;
+		} else {
+			prev->next = node;
+		}
+		prev = node;
+
+		if (i == 0 || values[i] < new_list->min) {
+			new_list->min = values[i];
+		}
+		if (i == 0 || values[i] > new_list->max) {
+			new_list->max = values[i];
+		}
+		new_list->sum += values[i];
+		sumsq_add(new_list, values[i]);
+	}
+	new_list->tail = prev;
+	new_list->count = count;
+
+	return new_list;
+}
+
+/****************************************************************
+ * Summary: Copies the values of a list to an array, in order.  *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             out - An array to hold the values.               *
+ *             size - The size of out.                          *
+ *                                                              *
+ * Returns: The amount of values in the list, at most size of   *
+ *          them are stored in out.                             *
+ ****************************************************************/
+int list_to_array(list_t * list, int * out, int size)
+{
+	int i = 0;
+	list_node_t * node;
+
+	for (node = list->head ; node != NULL && i < size ; node = node->next) {
+		out[i] = node->val;
+		++i;
+	}
+
+	return list->count;
+}
+
+/****************************************************************
+ * Summary: Moves every node of src to the end of dest, leaving *
+ *          src empty. Takes O(1), plus O(m log n) to update    *
+ *          dest's order statistics or index if enabled. Both   *
+ *          lists must allocate nodes the same way; a pooled    *
+ *          src hands its slabs over to dest. A src whose slab  *
+ *          is shared with other lists, as after list_split_at, *
+ *          can't give it away, so its values are copied into   *
+ *          new nodes of dest's slab in O(m) and src's node     *
+ *          handles become invalid.                             *
+ *                                                              *
+ * Parameters: dest - A pointer to the list_t to add to.        *
+ *             src - A pointer to the list_t to move from.      *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if failed, leaving  *
+ *          both lists unchanged.                               *
+ ****************************************************************/
+int list_splice(list_t * dest, list_t * src)
+{
+	list_node_t * first = src->head;
+	list_node_t * last = src->tail;
+	int copy;
+
+	if (dest == src || src->count > INT_MAX - dest->count) {
+		return -1;
+	}
+	if (src->count == 0) {
+		return 0;
+	}
+
+	/* Every node must still be freed by the allocator it came from. */
+	if ((dest->slab == NULL) != (src->slab == NULL)) {
+		return -1;
+	}
+	copy = (dest->slab != src->slab && dest->slab != NULL && src->slab->refs > 1);
+	if (copy) {
+		first = copy_nodes(dest, src->head, &last);
+		if (first == NULL) {
+			return -1;
+		}
+	}
+
+	if (extras_add(dest, first) != 0) {
+		if (copy) {
+			free_nodes(dest, first);
+		}
+		return -1;
+	}
+	if (!copy && dest->slab != src->slab && dest->slab != NULL && slab_merge(dest->slab, src->slab) != 0) {
+		extras_remove(dest, first, NULL);
+		return -1;
+	}
+	if (src->order != NULL) {
+		ostree_clear(src->order);
+	}
+	if (src->index != NULL) {
+		vmap_clear(src->index);
+	}
+	if (copy) {
+		free_nodes(src, src->head);
+	}
+
+	/* Link src after dest. */
+	if (dest->tail == NULL) {
+		dest->head = first;
+	} else {
+		dest->tail->next = first;
+		first->prev = dest->tail;
+	}
+	dest->tail = last;
+
+	/* Merge the aggregates. */
+	if (dest->count == 0) {
+		dest->min = src->min;
+		dest->max = src->max;
+		dest->minmax_stale = src->minmax_stale;
+	} else if (dest->minmax_stale || src->minmax_stale) {
+		dest->minmax_stale = 1;
+	} else {
+		if (src->min < dest->min) {
+			dest->min = src->min;
+		}
+		if (src->max > dest->max) {
+			dest->max = src->max;
+		}
+	}
+	dest->count += src->count;
+	dest->sum += src->sum;
+	dest->sumsq_lo += src->sumsq_lo;
+	dest->sumsq_hi += src->sumsq_hi + (dest->sumsq_lo < src->sumsq_lo);
+
+	/* Empty src. */
+	src->count = 0;
+	src->sum = 0;
+	src->sumsq_lo = 0;
+	src->sumsq_hi = 0;
+	src->min = 0;
+	src->max = 0;
+	src->minmax_stale = 0;
+	src->head = NULL;
+	src->tail = NULL;
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Splits a list in two, moving node and every node    *
+ *          after it to a new list. Only the shorter of the two *
+ *          parts is walked, so this takes O(min(k, n - k)),    *
+ *          plus O(k log n) for the moved part if order         *
+ *          statistics or the index are enabled, in which case  *
+ *          they are enabled on the new list too. A pooled list *
+ *          shares its slab with the new list, so splicing the  *
+ *          new list into another pooled list copies its nodes. *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             node - The first node to move.                   *
+ *                                                              *
+ * Returns: A pointer to the new list_t or NULL if failed,      *
+ *          leaving list unchanged. Should memory also run out  *
+ *          putting the moved nodes back in list's order        *
+ *          statistics and index, those are disabled.           *
+ ****************************************************************/
+list_t * list_split_at(list_t * list, list_node_t * node)
+{
+	list_node_t * forward = node;
+	list_node_t * backward = node->prev;
+	list_t part;
+	list_t * new_list = list_create();
+
+	if (new_list == NULL) {
+		return NULL;
+	}
+	if (list->slab != NULL) {
+		new_list->slab = slab_share(list->slab);
+	}
+
+	/*
+	 * The moved nodes already end at NULL, so the new list can be indexed before unlinking.
+	 * A node keeps its slot in one index only, so they leave list's index first.
+	 */
+	new_list->head = node;
+	new_list->tail = list->tail;
+	extras_remove(list, node, NULL);
+	if ((list->order != NULL && list_enable_order_stats(new_list) != 0) ||
+		(list->index != NULL && list_enable_index(new_list) != 0)) {
+		new_list->head = NULL;
+		new_list->tail = NULL;
+		list_destroy(new_list);
+		if (extras_add(list, node) != 0) {
+			list_disable_order_stats(list);
+			list_disable_index(list);
+		}
+		return NULL;
+	}
+
+	/* Step out from node both ways until one part runs out. */
+	while (forward != NULL && backward != NULL) {
+		forward = forward->next;
+		backward = backward->prev;
+	}
+
+	if (forward == NULL) { /* the moved part is shorter */
+		measure(node, NULL, &part);
+		copy_aggregates(new_list, &part);
+		take_part(list, &part);
+	} else {
+		measure(list->head, node, &part);
+		copy_aggregates(new_list, list);
+		take_part(new_list, &part);
+		copy_aggregates(list, &part);
+	}
+
+	/* Unlink. */
+	list->tail = node->prev;
+	if (node->prev == NULL) {
+		list->head = NULL;
+	} else {
+		node->prev->next = NULL;
+	}
+	node->prev = NULL;
+
+	return new_list;
+}
+
+/****************************************************************
+ * Summary: Sorts a list in ascending order by relinking its    *
+ *          nodes, keeping equal values in their order. Uses a  *
+ *          merge sort that merges runs of equal length as soon *
+ *          as both exist, so merges mostly touch nodes that    *
+ *          are still in cache. O(n log n) time and no memory   *
+ *          allocation. Node handles stay valid.                *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void list_sort(list_t * list)
+{
+	int i;
+	list_node_t * runs[LIST_SORT_RUNS] = { NULL };	/* runs[i] holds 2^i nodes or none */
+	list_node_t * node = list->head;
+	list_node_t * next;
+	list_node_t * carry;
+
+	/* Count in binary, merging equal runs like carrying a bit. */
+	while (node != NULL) {
+		next = node->next;
+		node->next = NULL;
+		carry = node;
+		for (i = 0 ; runs[i] != NULL ; ++i) {
+			carry = merge(runs[i], carry);
+			runs[i] = NULL;
+		}
+		runs[i] = carry;
+		node = next;
+	}
+
+	/* Higher runs hold earlier nodes, so they go on the left. */
+	carry = NULL;
+	for (i = 0 ; i < LIST_SORT_RUNS ; ++i) {
+		if (runs[i] != NULL) {
+			carry = (carry == NULL) ? runs[i] : merge(runs[i], carry);
+		}
+	}
+
+	/* Restore the prev links. */
+	list->head = carry;
+	list->tail = NULL;
+	for (node = carry ; node != NULL ; node = node->next) {
+		node->prev = list->tail;
+		list->tail = node;
+	}
 }
 
 /****************************************************************
@@ -209,4 +1060,318 @@ list_node_t * list_get_prev_node(list_node_t * node)
 int list_get_node_value(list_node_t * node)
 {
 	return node->val;
-}
\ No newline at end of file
+}
+
+/* Allocates a node from the list's slab, or with malloc. */
+static list_node_t * node_alloc(list_t * list)
+{
+	if (list->slab != NULL) {
+		return (list_node_t *)slab_alloc(list->slab);
+	}
+	return (list_node_t *)malloc(sizeof(list_node_t));
+}
+
+/* Frees a node allocated by node_alloc. */
+static void node_free(list_t * list, list_node_t * node)
+{
+	if (list->slab != NULL) {
+		slab_free(list->slab, node);
+	} else {
+		free(node);
+	}
+}
+
+/****************************************************************
+ * Summary: Copies the values of the nodes from first on into   *
+ *          new nodes allocated for a list, linked in order.    *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t to allocate for.  *
+ *             first - The first node to copy.                  *
+ *             last - A pointer to hold the last copied node.   *
+ *                                                              *
+ * Returns: The first copied node or NULL if failed, having     *
+ *          allocated nothing.                                  *
+ ****************************************************************/
+static list_node_t * copy_nodes(list_t * list, list_node_t * first, list_node_t ** last)
+{
+	list_node_t * head = NULL;
+	list_node_t * tail = NULL;
+	list_node_t * copied;
+	list_node_t * node;
+
+	for (node = first ; node != NULL ; node = node->next) {
+		copied = node_alloc(list);
+		if (copied == NULL) {
+			free_nodes(list, head);
+			return NULL;
+		}
+		copied->val = node->val;
+		copied->next = NULL;
+		copied->prev = tail;
+		if (tail == NULL) {
+			head = copied;
+		} else {
+			tail->next = copied;
+		}
+		tail = copied;
+	}
+
+	*last = tail;
+	return head;
+}
+
+/* Frees the nodes from first on, which belong to list. */
+static void free_nodes(list_t * list, list_node_t * first)
+{
+	list_node_t * next;
+
+	while (first != NULL) {
+		next = first->next;
+		node_free(list, first);
+		first = next;
+	}
+}
+
+/* Adds value squared to the 128-bit sum of squares. */
+static void sumsq_add(list_t * list, int value)
+{
+	unsigned long long square = (unsigned long long)((long long)value * value);
+
+	list->sumsq_lo += square;
+	if (list->sumsq_lo < square) { /* carry */
+		++(list->sumsq_hi);
+	}
+}
+
+/* Subtracts value squared from the 128-bit sum of squares. */
+static void sumsq_sub(list_t * list, int value)
+{
+	unsigned long long square = (unsigned long long)((long long)value * value);
+
+	if (list->sumsq_lo < square) { /* borrow */
+		--(list->sumsq_hi);
+	}
+	list->sumsq_lo -= square;
+}
+
+/* Multiplies two 64-bit values into a 128-bit result. */
+static void mul_u64(unsigned long long a, unsigned long long b,
+					unsigned long long * lo, unsigned long long * hi)
+{
+	unsigned long long a_lo = a & 0xffffffffULL, a_hi = a >> 32;
+	unsigned long long b_lo = b & 0xffffffffULL, b_hi = b >> 32;
+	unsigned long long ll = a_lo * b_lo;
+	unsigned long long lh = a_lo * b_hi;
+	unsigned long long hl = a_hi * b_lo;
+	unsigned long long hh = a_hi * b_hi;
+	unsigned long long middle = (ll >> 32) + (lh & 0xffffffffULL) + (hl & 0xffffffffULL);
+
+	*lo = (middle << 32) | (ll & 0xffffffffULL);
+	*hi = hh + (lh >> 32) + (hl >> 32) + (middle >> 32);
+}
+
+/* Keeps min and max from now on in the order statistics, or rescans if memory runs out. */
+static void refresh_min_max(list_t * list)
+{
+	list_node_t * node = list->head;
+
+	if (list_enable_order_stats(list) == 0) {
+		return;
+	}
+
+	list->min = node->val;
+	list->max = node->val;
+	for (node = node->next ; node != NULL ; node = node->next) {
+		if (node->val < list->min) {
+			list->min = node->val;
+		}
+		if (node->val > list->max) {
+			list->max = node->val;
+		}
+	}
+	list->minmax_stale = 0;
+}
+
+/****************************************************************
+ * Summary: Stores the nodes holding value after the found      *
+ *          nodes already in out.                               *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             value - The value to find.                       *
+ *             out - An array to hold the nodes, may be NULL.   *
+ *             size - The size of out.                          *
+ *             found - The amount of nodes found so far.        *
+ *                                                              *
+ * Returns: found plus the amount of nodes holding value.       *
+ ****************************************************************/
+static int collect(list_t * list, int value, list_node_t ** out, int size, int found)
+{
+	int i, count;
+	list_node_t * node;
+	list_node_t ** nodes;
+	struct vmap_entry_rec * entry;
+
+	if (list->index != NULL) {
+		entry = vmap_find(list->index, value);
+		if (entry == NULL) {
+			return found;
+		}
+		count = vmap_get_nodes(entry, &nodes);
+		for (i = 0 ; i < count ; ++i) {
+			if (out != NULL && found < size) {
+				out[found] = nodes[i];
+			}
+			++found;
+		}
+		return found;
+	}
+
+	for (node = list->head ; node != NULL ; node = node->next) {
+		if (node->val == value) {
+			if (out != NULL && found < size) {
+				out[found] = node;
+			}
+			++found;
+		}
+	}
+
+	return found;
+}
+
+/****************************************************************
+ * Summary: Adds the values of the nodes from first to the end  *
+ *          of their chain to a list's order statistics and     *
+ *          index, if enabled.                                  *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             first - The first node to add.                   *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if failed, having   *
+ *          added nothing.                                      *
+ ****************************************************************/
+static int extras_add(list_t * list, list_node_t * first)
+{
+	list_node_t * node;
+
+	for (node = first ; node != NULL ; node = node->next) {
+		if (list->order != NULL && ostree_insert(list->order, node->val) != 0) {
+			extras_remove(list, first, node);
+			return -1;
+		}
+		if (list->index != NULL && vmap_insert(list->index, node->val, node) != 0) {
+			if (list->order != NULL) {
+				ostree_remove(list->order, node->val);
+			}
+			extras_remove(list, first, node);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* Removes the nodes from first up to end from a list's order statistics and index. */
+static void extras_remove(list_t * list, list_node_t * first, list_node_t * end)
+{
+	list_node_t * node;
+
+	for (node = first ; node != end ; node = node->next) {
+		if (list->order != NULL) {
+			ostree_remove(list->order, node->val);
+		}
+		if (list->index != NULL) {
+			vmap_remove(list->index, node->val, node);
+		}
+	}
+}
+
+/* Stores the aggregates of the nodes from first up to end in part. */
+static void measure(list_node_t * first, list_node_t * end, list_t * part)
+{
+	list_node_t * node;
+
+	part->count = 0;
+	part->sum = 0;
+	part->sumsq_lo = 0;
+	part->sumsq_hi = 0;
+	part->min = first->val;
+	part->max = first->val;
+	part->minmax_stale = 0;
+	for (node = first ; node != end ; node = node->next) {
+		if (node->val < part->min) {
+			part->min = node->val;
+		}
+		if (node->val > part->max) {
+			part->max = node->val;
+		}
+		++(part->count);
+		part->sum += node->val;
+		sumsq_add(part, node->val);
+	}
+}
+
+static void copy_aggregates(list_t * dest, list_t * src)
+{
+	dest->count = src->count;
+	dest->sum = src->sum;
+	dest->sumsq_lo = src->sumsq_lo;
+	dest->sumsq_hi = src->sumsq_hi;
+	dest->min = src->min;
+	dest->max = src->max;
+	dest->minmax_stale = src->minmax_stale;
+}
+
+/****************************************************************
+ * Summary: Takes the aggregates of a part of a list out of the *
+ *          list's aggregates. The min and max stay exact       *
+ *          unless the part held one of them.                   *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             part - The aggregates of the part.               *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+static void take_part(list_t * list, list_t * part)
+{
+	list->count -= part->count;
+	list->sum -= part->sum;
+	list->sumsq_hi -= part->sumsq_hi + (list->sumsq_lo < part->sumsq_lo);
+	list->sumsq_lo -= part->sumsq_lo;
+
+	if (list->count == 0) {
+		list->min = 0;
+		list->max = 0;
+		list->minmax_stale = 0;
+	} else if (part->min == list->min || part->max == list->max) {
+		list->minmax_stale = 1;
+	}
+}
+
+/****************************************************************
+ * Summary: Merges two sorted chains linked through next only.  *
+ *          On equal values the left chain goes first.          *
+ *                                                              *
+ * Parameters: left - The first node of the earlier chain.      *
+ *             right - The first node of the later chain.       *
+ *                                                              *
+ * Returns: The first node of the merged chain.                 *
+ ****************************************************************/
+static list_node_t * merge(list_node_t * left, list_node_t * right)
+{
+	list_node_t head;
+	list_node_t * tail = &head;
+
+	while (left != NULL && right != NULL) {
+		if (right->val < left->val) {
+			tail->next = right;
+			right = right->next;
+		} else {
+			tail->next = left;
+			left = left->next;
+		}
+		tail = tail->next;
+	}
+	tail->next = (left != NULL) ? left : right;
+
+	return head.next;
+}
@@ -1,18 +1,29 @@
 typedef struct list_node_rec {
 	int val;
+	int slot;						/* position among the indexed nodes of val */
 	struct list_node_rec * next;
 	struct list_node_rec * prev;
 } list_node_t;
 
 typedef struct list_rec {
 	int count;
-	double avg;
+	long long sum;
+	unsigned long long sumsq_lo;	/* sum of squares, low 64 bits */
+	unsigned long long sumsq_hi;	/* sum of squares, high 64 bits */
+	int min;
+	int max;
+	int minmax_stale;				/* min or max was removed */
+	struct ostree_rec * order;		/* sorted values, NULL if disabled */
+	struct vmap_rec * index;		/* nodes by value, NULL if disabled */
+	struct slab_rec * slab;			/* node allocator, NULL for malloc */
 	struct list_node_rec * head;
 	struct list_node_rec * tail;
 } list_t;
 
 list_t * list_create();
 
+list_t * list_create_pooled(int nodes_per_slab);
+
 void list_destroy(list_t * list);
 
 list_node_t * list_add_node(list_t * list, int value);
@@ -23,6 +34,48 @@ int list_get_count(list_t * list);
 
 double list_get_average(list_t * list);
 
+long long list_get_sum(list_t * list);
+
+double list_get_variance(list_t * list);
+
+int list_get_min(list_t * list, int * out);
+
+int list_get_max(list_t * list, int * out);
+
+int list_enable_order_stats(list_t * list);
+
+void list_disable_order_stats(list_t * list);
+
+int list_get_kth(list_t * list, int k, int * out);
+
+int list_get_percentile(list_t * list, double percent, int * out);
+
+int list_get_median(list_t * list, int * out);
+
+int list_enable_index(list_t * list);
+
+void list_disable_index(list_t * list);
+
+list_node_t * list_find(list_t * list, int value);
+
+int list_find_all(list_t * list, int value, list_node_t ** out, int size);
+
+int list_contains(list_t * list, int value);
+
+int list_count_range(list_t * list, int low, int high);
+
+int list_find_range(list_t * list, int low, int high, list_node_t ** out, int size);
+
+list_t * list_from_array(const int * values, int count);
+
+int list_to_array(list_t * list, int * out, int size);
+
+int list_splice(list_t * dest, list_t * src);
+
+list_t * list_split_at(list_t * list, list_node_t * node);
+
+void list_sort(list_t * list);
+
 list_node_t * list_get_head(list_t * list);
 
 list_node_t * list_get_tail(list_t * list);
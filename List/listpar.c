@@ -0,0 +1,358 @@
+/****************************************************************
+ * Summary: This library runs a callback over every node of a   *
+ *          list, or folds its values, on a pool of threads.    *
+ *          The caller walks the list once, handing out a       *
+ *          segment of nodes as soon as its first node is       *
+ *          reached, so the workers start before the walk ends. *
+ *          Partial results are kept per segment and combined   *
+ *          in list order, so the reduction only has to be      *
+ *          associative.                                        *
+ *                                                              *
+ *          The list must not change while a call runs, and a   *
+ *          pool runs one call at a time.                       *
+ ****************************************************************/
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <unistd.h>
+#include "list.h"
+#include "listpar.h"
+
+#if defined(__GNUC__)
+#define PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PREFETCH(address) ((void)(address))
+#endif
+
+typedef struct list_job_rec {
+	int count;					/* nodes in the list */
+	int segments;
+	list_node_t ** starts;		/* first node of every segment */
+	atomic_int published;		/* segments whose start is known */
+	atomic_int next;			/* the next segment to take */
+	list_visit_t visit;
+	void * context;
+	const list_reducer_t * reducer;
+	char * partials;			/* one result per segment */
+} list_job_t;
+
+static void * worker_main(void * arg);
+static int run(list_t * list, list_pool_t * pool, list_job_t * job);
+static void work(list_job_t * job);
+static void do_segment(list_job_t * job, list_node_t * node, int length, void * partial);
+
+/****************************************************************
+ * Summary: Creates a pool of worker threads.                   *
+ *                                                              *
+ * Parameters: threads - The amount of threads that work on a   *
+ *                       call, including the caller, or 0 for   *
+ *                       one per online processor.              *
+ *                                                              *
+ * Returns: A pointer to list_pool_t or NULL if failed.         *
+ ****************************************************************/
+list_pool_t * list_pool_create(int threads)
+{
+	int i;
+	list_pool_t * new_pool;
+
+	if (threads < 0) {
+		return NULL;
+	}
+	if (threads == 0) {
+		threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+		if (threads < 1) {
+			threads = 1;
+		}
+	}
+
+	new_pool = (list_pool_t *)malloc(sizeof(list_pool_t));
+	if (new_pool == NULL) {
+		return NULL;
+	}
+
+	/* The caller is one of the threads. */
+	new_pool->threads = threads - 1;
+	new_pool->workers = (pthread_t *)malloc(sizeof(pthread_t) * threads);
+	if (new_pool->workers == NULL) {
+		free(new_pool);
+		return NULL;
+	}
+	pthread_mutex_init(&(new_pool->lock), NULL);
+	pthread_cond_init(&(new_pool->wake), NULL);
+	pthread_cond_init(&(new_pool->done), NULL);
+	new_pool->generation = 0;
+	new_pool->busy = 0;
+	new_pool->shutdown = 0;
+	new_pool->job = NULL;
+
+	for (i = 0 ; i < new_pool->threads ; ++i) {
+		if (pthread_create(&(new_pool->workers[i]), NULL, worker_main, new_pool) != 0) {
+			new_pool->threads = i;
+			list_pool_destroy(new_pool);
+			return NULL;
+		}
+	}
+
+	return new_pool;
+}
+
+/****************************************************************
+ * Summary: Stops the workers of a pool and frees it.           *
+ *                                                              *
+ * Parameters: pool - A pointer to the list_pool_t to destroy.  *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void list_pool_destroy(list_pool_t * pool)
+{
+	int i;
+
+	pthread_mutex_lock(&(pool->lock));
+	pool->shutdown = 1;
+	pthread_cond_broadcast(&(pool->wake));
+	pthread_mutex_unlock(&(pool->lock));
+
+	for (i = 0 ; i < pool->threads ; ++i) {
+		pthread_join(pool->workers[i], NULL);
+	}
+
+	pthread_cond_destroy(&(pool->done));
+	pthread_cond_destroy(&(pool->wake));
+	pthread_mutex_destroy(&(pool->lock));
+	free(pool->workers);
+	free(pool);
+}
+
+/****************************************************************
+ * Summary: Calls visit for every node of a list. With a pool   *
+ *          the calls are spread over its threads in no         *
+ *          particular order, so visit must be thread safe and  *
+ *          must not change the list.                           *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             pool - A pointer to the list_pool_t, or NULL to  *
+ *                    run on the calling thread only.           *
+ *             visit - The function to call.                    *
+ *             context - Passed to visit.                       *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if failed.          *
+ ****************************************************************/
+int list_for_each(list_t * list, list_pool_t * pool, list_visit_t visit, void * context)
+{
+	list_job_t job;
+
+	job.visit = visit;
+	job.context = context;
+	job.reducer = NULL;
+	job.partials = NULL;
+
+	return run(list, pool, &job);
+}
+
+/****************************************************************
+ * Summary: Folds the values of a list into result. Every       *
+ *          segment is folded into its own partial result,      *
+ *          starting from init, and the partials are combined   *
+ *          into result in list order.                          *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             pool - A pointer to the list_pool_t, or NULL to  *
+ *                    run on the calling thread only.           *
+ *             reducer - The functions to fold with.            *
+ *             result - Room for reducer->size bytes to hold    *
+ *                      the result.                             *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if failed.          *
+ ****************************************************************/
+int list_reduce(list_t * list, list_pool_t * pool, const list_reducer_t * reducer, void * result)
+{
+	int i;
+	int segments = (list->count + LIST_PAR_SEGMENT - 1) / LIST_PAR_SEGMENT;
+	list_job_t job;
+
+	job.visit = NULL;
+	job.context = NULL;
+	job.reducer = reducer;
+	job.partials = NULL;
+
+	reducer->init(result, reducer->context);
+
+	/* Without other threads, fold straight into result. */
+	if (pool == NULL || pool->threads == 0 || segments < 2) {
+		do_segment(&job, list->head, list->count, result);
+		return 0;
+	}
+
+	job.partials = (char *)malloc(reducer->size * segments);
+	if (job.partials == NULL) {
+		return -1;
+	}
+	for (i = 0 ; i < segments ; ++i) {
+		reducer->init(job.partials + reducer->size * i, reducer->context);
+	}
+
+	if (run(list, pool, &job) != 0) {
+		free(job.partials);
+		return -1;
+	}
+
+	for (i = 0 ; i < segments ; ++i) {
+		reducer->combine(result, job.partials + reducer->size * i, reducer->context);
+	}
+	free(job.partials);
+
+	return 0;
+}
+
+static void * worker_main(void * arg)
+{
+	list_pool_t * pool = (list_pool_t *)arg;
+	unsigned long seen = 0;
+	list_job_t * job;
+
+	for (;;) {
+		pthread_mutex_lock(&(pool->lock));
+		while (pool->generation == seen && !pool->shutdown) {
+			pthread_cond_wait(&(pool->wake), &(pool->lock));
+		}
+		if (pool->shutdown) {
+			pthread_mutex_unlock(&(pool->lock));
+			return NULL;
+		}
+		seen = pool->generation;
+		job = pool->job;
+		pthread_mutex_unlock(&(pool->lock));
+
+		work(job);
+
+		pthread_mutex_lock(&(pool->lock));
+		if (--(pool->busy) == 0) {
+			pthread_cond_signal(&(pool->done));
+		}
+		pthread_mutex_unlock(&(pool->lock));
+	}
+}
+
+/****************************************************************
+ * Summary: Runs a job on the pool. The caller walks the list,  *
+ *          publishing the start of every segment, then works   *
+ *          on segments itself until none are left.             *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             pool - A pointer to the list_pool_t, or NULL.    *
+ *             job - The job, with its callbacks set.           *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if failed.          *
+ ****************************************************************/
+static int run(list_t * list, list_pool_t * pool, list_job_t * job)
+{
+	int i;
+	list_node_t * node;
+
+	job->count = list->count;
+	job->segments = (list->count + LIST_PAR_SEGMENT - 1) / LIST_PAR_SEGMENT;
+
+	/* Not worth waking the workers. */
+	if (pool == NULL || pool->threads == 0 || job->segments < 2) {
+		do_segment(job, list->head, list->count, job->partials);
+		return 0;
+	}
+
+	job->starts = (list_node_t **)malloc(sizeof(list_node_t *) * job->segments);
+	if (job->starts == NULL) {
+		return -1;
+	}
+	atomic_init(&(job->published), 0);
+	atomic_init(&(job->next), 0);
+
+	pthread_mutex_lock(&(pool->lock));
+	pool->job = job;
+	pool->busy = pool->threads;
+	++(pool->generation);
+	pthread_cond_broadcast(&(pool->wake));
+	pthread_mutex_unlock(&(pool->lock));
+
+	/* Hand out every segment as soon as its first node is reached. */
+	node = list->head;
+	for (i = 0 ; node != NULL ; ++i) {
+		if (i % LIST_PAR_SEGMENT == 0) {
+			job->starts[i / LIST_PAR_SEGMENT] = node;
+			atomic_store_explicit(&(job->published), i / LIST_PAR_SEGMENT + 1, memory_order_release);
+		}
+		node = node->next;
+	}
+
+	work(job);
+
+	pthread_mutex_lock(&(pool->lock));
+	while (pool->busy > 0) {
+		pthread_cond_wait(&(pool->done), &(pool->lock));
+	}
+	pool->job = NULL;
+	pthread_mutex_unlock(&(pool->lock));
+
+	free(job->starts);
+
+	return 0;
+}
+
+/* Takes segments of a job until none are left. */
+static void work(list_job_t * job)
+{
+	int k;
+	int length;
+	void * partial;
+
+	for (;;) {
+		k = atomic_fetch_add(&(job->next), 1);
+		if (k >= job->segments) {
+			return;
+		}
+		while (atomic_load_explicit(&(job->published), memory_order_acquire) <= k) {
+			sched_yield();
+		}
+
+		length = job->count - k * LIST_PAR_SEGMENT;
+		if (length > LIST_PAR_SEGMENT) {
+			length = LIST_PAR_SEGMENT;
+		}
+		partial = (job->partials == NULL) ? NULL : job->partials + job->reducer->size * k;
+		do_segment(job, job->starts[k], length, partial);
+	}
+}
+
+/****************************************************************
+ * Summary: Visits or folds length nodes starting from node,    *
+ *          prefetching the nodes LIST_PAR_PREFETCH ahead.      *
+ *                                                              *
+ * Parameters: job - The job.                                   *
+ *             node - The first node.                           *
+ *             length - The amount of nodes.                    *
+ *             partial - The result to fold into, or NULL to    *
+ *                       visit.                                 *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+static void do_segment(list_job_t * job, list_node_t * node, int length, void * partial)
+{
+	int i;
+	list_node_t * ahead = node;
+
+	for (i = 0 ; i < LIST_PAR_PREFETCH && ahead != NULL ; ++i) {
+		ahead = ahead->next;
+	}
+
+	for (i = 0 ; i < length ; ++i) {
+		if (ahead != NULL) {
+			PREFETCH(ahead->next);
+			ahead = ahead->next;
+		}
+		if (partial == NULL) {
+			job->visit(node, job->context);
+		} else {
+			job->reducer->accumulate(partial, node->val, job->reducer->context);
+		}
+		node = node->next;
+	}
+}
@@ -0,0 +1,45 @@
+#if !defined(_LISTPAR_H_)
+#define _LISTPAR_H_
+
+#include <stddef.h>
+#include <pthread.h>
+
+/* Nodes handed to a thread at a time. */
+#define LIST_PAR_SEGMENT (1024)
+
+/* How many nodes ahead of the current one are prefetched. */
+#define LIST_PAR_PREFETCH (8)
+
+/* Called for every node, from several threads at once. */
+typedef void (*list_visit_t)(struct list_node_rec * node, void * context);
+
+/* Folds the values of a list into a result of size bytes. */
+typedef struct list_reducer_rec {
+	size_t size;
+	void (*init)(void * partial, void * context);
+	void (*accumulate)(void * partial, int value, void * context);
+	void (*combine)(void * into, const void * partial, void * context);
+	void * context;
+} list_reducer_t;
+
+typedef struct list_pool_rec {
+	int threads;				/* workers, not counting the caller */
+	pthread_t * workers;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;		/* a job was posted or the pool is closing */
+	pthread_cond_t done;		/* the last worker finished the job */
+	unsigned long generation;	/* jobs posted so far */
+	int busy;					/* workers still on the current job */
+	int shutdown;
+	struct list_job_rec * job;
+} list_pool_t;
+
+list_pool_t * list_pool_create(int threads);
+
+void list_pool_destroy(list_pool_t * pool);
+
+int list_for_each(struct list_rec * list, list_pool_t * pool, list_visit_t visit, void * context);
+
+int list_reduce(struct list_rec * list, list_pool_t * pool, const list_reducer_t * reducer, void * result);
+
+#endif
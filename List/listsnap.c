@@ -0,0 +1,510 @@
+/****************************************************************
+ * Summary: This library saves a list to a flat binary file, a  *
+ *          header holding the aggregates followed by the       *
+ *          values, optionally also sorted, and opens such a    *
+ *          file as a read-only snapshot. On POSIX systems the  *
+ *          file is mapped into memory, so opening takes no     *
+ *          parsing and no per-value work; pages are read as    *
+ *          they are touched. A snapshot is thawed into a       *
+ *          normal list to change it.                           *
+ *                                                              *
+ *          Files are meant to be read on the machine type that *
+ *          wrote them; the header records the byte order and   *
+ *          a file of the other order is rejected.              *
+ ****************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "list.h"
+#include "listsnap.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* Values written to the file at a time. */
+#define LIST_SNAPSHOT_CHUNK (4096)
+
+static int write_values(FILE * fp, list_t * list);
+static int write_sorted(FILE * fp, list_t * list);
+static int compare_ints(const void * a, const void * b);
+static int load(const char * path, list_snapshot_t * snapshot);
+static void unload(list_snapshot_t * snapshot);
+static int check(list_snapshot_t * snapshot);
+
+/****************************************************************
+ * Summary: Saves a list to a file. The file is written under a *
+ *          temporary name and renamed over path, so readers    *
+ *          never see a partly written file.                    *
+ *                                                              *
+ * Parameters: list - A pointer to the list_t.                  *
+ *             path - The file to write.                        *
+ *             flags - 0 or LIST_SNAPSHOT_SORTED.               *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if failed.          *
+ ****************************************************************/
+int list_save(list_t * list, const char * path, int flags)
+{
+	int failed;
+	char * temp_path;
+	FILE * fp;
+	list_snapshot_header_t header;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, LIST_SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.version = LIST_SNAPSHOT_VERSION;
+	header.byte_order = LIST_SNAPSHOT_BYTE_ORDER;
+	header.flags = (unsigned int)flags;
+	header.count = list->count;
+	header.sum = list->sum;
+	header.sumsq_lo = list->sumsq_lo;
+	header.sumsq_hi = list->sumsq_hi;
+	header.variance = list_get_variance(list);
+	list_get_min(list, &(header.min));
+	list_get_max(list, &(header.max));
+	header.values_offset = (long long)sizeof(header);
+	if (flags & LIST_SNAPSHOT_SORTED) {
+		header.sorted_offset = header.values_offset + (long long)sizeof(int) * list->count;
+	}
+
+	temp_path = (char *)malloc(strlen(path) + 5);
+	if (temp_path == NULL) {
+		return -1;
+	}
+	strcpy(temp_path, path);
+	strcat(temp_path, ".tmp");
+
+	fp = fopen(temp_path, "wb");
+	if (fp == NULL) {
+		free(temp_path);
+		return -1;
+	}
+	failed = (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+			  write_values(fp, list) != 0 ||
+			  ((flags & LIST_SNAPSHOT_SORTED) && write_sorted(fp, list) != 0));
+	if (fclose(fp) != 0) {
+		failed = 1;
+	}
+
+#if defined(_WIN32)
+	/* rename does not replace an existing file here. */
+	if (!failed) {
+		remove(path);
+	}
+#endif
+	if (failed || rename(temp_path, path) != 0) {
+		remove(temp_path);
+		free(temp_path);
+		return -1;
+	}
+
+	free(temp_path);
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Opens a file written by list_save as a read-only    *
+ *          snapshot.                                           *
+ *                                                              *
+ * Parameters: path - The file to open.                         *
+ *                                                              *
+ * Returns: A pointer to list_snapshot_t or NULL if the file    *
+ *          can not be read or is not a valid snapshot.         *
+ ****************************************************************/
+list_snapshot_t * list_snapshot_open(const char * path)
+{
+	const char * base;
+	list_snapshot_t * snapshot = (list_snapshot_t *)malloc(sizeof(list_snapshot_t));
+
+	if (snapshot == NULL) {
+		return NULL;
+	}
+
+	if (load(path, snapshot) != 0) {
+		free(snapshot);
+		return NULL;
+	}
+	if (check(snapshot) != 0) {
+		unload(snapshot);
+		free(snapshot);
+		return NULL;
+	}
+
+	base = (const char *)(snapshot->data);
+	snapshot->header = (const list_snapshot_header_t *)base;
+	snapshot->values = (const int *)(base + snapshot->header->values_offset);
+	snapshot->sorted = (snapshot->header->sorted_offset == 0) ? NULL
+					   : (const int *)(base + snapshot->header->sorted_offset);
+
+	return snapshot;
+}
+
+/****************************************************************
+ * Summary: Closes a snapshot, freeing memory.                  *
+ *                                                              *
+ * Parameters: snapshot - A pointer to the list_snapshot_t to   *
+ *                        close.                                *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void list_snapshot_close(list_snapshot_t * snapshot)
+{
+	unload(snapshot);
+	free(snapshot);
+}
+
+/****************************************************************
+ * Summary: Copies a snapshot into a new, changeable list. The  *
+ *          snapshot stays open and unchanged.                  *
+ *                                                              *
+ * Parameters: snapshot - A pointer to the list_snapshot_t.     *
+ *                                                              *
+ * Returns: A pointer to list_t or NULL if failed.              *
+ ****************************************************************/
+list_t * list_snapshot_thaw(list_snapshot_t * snapshot)
+{
+	return list_from_array(snapshot->values, snapshot->header->count);
+}
+
+/****************************************************************
+ * Summary: Gets the amount of values in a snapshot.            *
+ *                                                              *
+ * Parameters: snapshot - A pointer to the list_snapshot_t.     *
+ *                                                              *
+ * Returns: The amount of values.                               *
+ ****************************************************************/
+int list_snapshot_get_count(list_snapshot_t * snapshot)
+{
+	return snapshot->header->count;
+}
+
+/****************************************************************
+ * Summary: Gets the sum of the values in a snapshot.           *
+ *                                                              *
+ * Parameters: snapshot - A pointer to the list_snapshot_t.     *
+ *                                                              *
+ * Returns: The sum of the values.                              *
+ ****************************************************************/
+long long list_snapshot_get_sum(list_snapshot_t * snapshot)
+{
+	return snapshot->header->sum;
+}
+
+/****************************************************************
+ * Summary: Gets the average of the values in a snapshot.       *
+ *                                                              *
+ * Parameters: snapshot - A pointer to the list_snapshot_t.     *
+ *                                                              *
+ * Returns: The average, 0 if the snapshot is empty.            *
+ ****************************************************************/
+double list_snapshot_get_average(list_snapshot_t * snapshot)
+{
+	if (snapshot->header->count == 0) {
+		return 0;
+	}
+	return (double)(snapshot->header->sum) / (snapshot->header->count);
+}
+
+/****************************************************************
+ * Summary: Gets the population variance of the values in a     *
+ *          snapshot, as computed when it was saved.            *
+ *                                                              *
+ * Parameters: snapshot - A pointer to the list_snapshot_t.     *
+ *                                                              *
+ * Returns: The variance, 0 if the snapshot is empty.           *
+ ****************************************************************/
+double list_snapshot_get_variance(list_snapshot_t * snapshot)
+{
+	return snapshot->header->variance;
+}
+
+/****************************************************************
+ * Summary: Gets the smallest value in a snapshot.              *
+ *                                                              *
+ * Parameters: snapshot - A pointer to the list_snapshot_t.     *
+ *             out - A pointer to an int to hold the value.     *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if the snapshot is  *
+ *          empty.                                              *
+ ****************************************************************/
+int list_snapshot_get_min(list_snapshot_t * snapshot, int * out)
+{
+	if (snapshot->header->count == 0) {
+		return -1;
+	}
+	*out = snapshot->header->min;
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Gets the largest value in a snapshot.               *
+ *                                                              *
+ * Parameters: snapshot - A pointer to the list_snapshot_t.     *
+ *             out - A pointer to an int to hold the value.     *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if the snapshot is  *
+ *          empty.                                              *
+ ****************************************************************/
+int list_snapshot_get_max(list_snapshot_t * snapshot, int * out)
+{
+	if (snapshot->header->count == 0) {
+		return -1;
+	}
+	*out = snapshot->header->max;
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Gets the k-th smallest value in a snapshot, in      *
+ *          O(1).                                               *
+ *                                                              *
+ * Parameters: snapshot - A pointer to the list_snapshot_t.     *
+ *             k - The 0-based position in sorted order.        *
+ *             out - A pointer to an int to hold the value.     *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if k is out of      *
+ *          range or the snapshot was saved without             *
+ *          LIST_SNAPSHOT_SORTED.                               *
+ ****************************************************************/
+int list_snapshot_get_kth(list_snapshot_t * snapshot, int k, int * out)
+{
+	if (snapshot->sorted == NULL || k < 0 || k >= snapshot->header->count) {
+		return -1;
+	}
+	*out = snapshot->sorted[k];
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Gets a percentile of the values in a snapshot using *
+ *          the nearest-rank method.                            *
+ *                                                              *
+ * Parameters: snapshot - A pointer to the list_snapshot_t.     *
+ *             percent - The percentile, between 0 and 100.     *
+ *             out - A pointer to an int to hold the value.     *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if the snapshot is  *
+ *          empty, percent is out of range or the snapshot was  *
+ *          saved without LIST_SNAPSHOT_SORTED.                 *
+ ****************************************************************/
+int list_snapshot_get_percentile(list_snapshot_t * snapshot, double percent, int * out)
+{
+	int rank;
+	double position;
+
+	if (snapshot->header->count == 0 || percent < 0 || percent > 100) {
+		return -1;
+	}
+
+	/* rank = ceil(percent / 100 * count), at least 1 */
+	position = percent * (snapshot->header->count) / 100.0;
+	rank = (int)position;
+	if ((double)rank < position) {
+		++rank;
+	}
+	if (rank < 1) {
+		rank = 1;
+	}
+
+	return list_snapshot_get_kth(snapshot, rank - 1, out);
+}
+
+/****************************************************************
+ * Summary: Gets the median of the values in a snapshot, the    *
+ *          lower of the two middle values if the count is      *
+ *          even.                                               *
+ *                                                              *
+ * Parameters: snapshot - A pointer to the list_snapshot_t.     *
+ *             out - A pointer to an int to hold the value.     *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if the snapshot is  *
+ *          empty or was saved without LIST_SNAPSHOT_SORTED.    *
+ ****************************************************************/
+int list_snapshot_get_median(list_snapshot_t * snapshot, int * out)
+{
+	return list_snapshot_get_percentile(snapshot, 50, out);
+}
+
+/****************************************************************
+ * Summary: Gets the values of a snapshot in list order, to     *
+ *          iterate with an index from 0 to the count.          *
+ *                                                              *
+ * Parameters: snapshot - A pointer to the list_snapshot_t.     *
+ *                                                              *
+ * Returns: A pointer to the first value.                       *
+ ****************************************************************/
+const int * list_snapshot_get_values(list_snapshot_t * snapshot)
+{
+	return snapshot->values;
+}
+
+/* Writes the values of a list in list order. */
+static int write_values(FILE * fp, list_t * list)
+{
+	int i = 0;
+	int chunk[LIST_SNAPSHOT_CHUNK];
+	list_node_t * node;
+
+	for (node = list->head ; node != NULL ; node = node->next) {
+		chunk[i++] = node->val;
+		if (i == LIST_SNAPSHOT_CHUNK) {
+			if (fwrite(chunk, sizeof(int), i, fp) != (size_t)i) {
+				return -1;
+			}
+			i = 0;
+		}
+	}
+	if (i > 0 && fwrite(chunk, sizeof(int), i, fp) != (size_t)i) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Writes the values of a list in ascending order. */
+static int write_sorted(FILE * fp, list_t * list)
+{
+	size_t written;
+	int * values;
+
+	if (list->count == 0) {
+		return 0;
+	}
+
+	values = (int *)malloc(sizeof(int) * list->count);
+	if (values == NULL) {
+		return -1;
+	}
+	list_to_array(list, values, list->count);
+	qsort(values, list->count, sizeof(int), compare_ints);
+	written = fwrite(values, sizeof(int), list->count, fp);
+	free(values);
+
+	return (written == (size_t)(list->count)) ? 0 : -1;
+}
+
+static int compare_ints(const void * a, const void * b)
+{
+	int x = *(const int *)a;
+	int y = *(const int *)b;
+
+	return (x > y) - (x < y);
+}
+
+#if !defined(_WIN32)
+
+/* Maps a whole file read-only. */
+static int load(const char * path, list_snapshot_t * snapshot)
+{
+	int fd;
+	struct stat info;
+	void * data;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+	if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(list_snapshot_header_t)) {
+		close(fd);
+		return -1;
+	}
+
+	data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return -1;
+	}
+
+	snapshot->data = data;
+	snapshot->size = (size_t)info.st_size;
+	snapshot->mapped = 1;
+
+	return 0;
+}
+
+#else
+
+/* Reads a whole file into memory. */
+static int load(const char * path, list_snapshot_t * snapshot)
+{
+	long size;
+	void * data;
+	FILE * fp = fopen(path, "rb");
+
+	if (fp == NULL) {
+		return -1;
+	}
+	if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < (long)sizeof(list_snapshot_header_t) ||
+		fseek(fp, 0, SEEK_SET) != 0) {
+		fclose(fp);
+		return -1;
+	}
+
+	data = malloc((size_t)size);
+	if (data == NULL || fread(data, 1, (size_t)size, fp) != (size_t)size) {
+		free(data);
+		fclose(fp);
+		return -1;
+	}
+	fclose(fp);
+
+	snapshot->data = data;
+	snapshot->size = (size_t)size;
+	snapshot->mapped = 0;
+
+	return 0;
+}
+
+#endif
+
+static void unload(list_snapshot_t * snapshot)
+{
+#if !defined(_WIN32)
+	if (snapshot->mapped) {
+		munmap(snapshot->data, snapshot->size);
+		return;
+	}
+#endif
+	free(snapshot->data);
+}
+
+/* Checks that the header is valid and its arrays fit in the file. */
+static int check(list_snapshot_t * snapshot)
+{
+	const list_snapshot_header_t * header = (const list_snapshot_header_t *)(snapshot->data);
+	long long values_size;
+	long long size = (long long)(snapshot->size);
+
+	if (memcmp(header->magic, LIST_SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+		header->version != LIST_SNAPSHOT_VERSION ||
+		header->byte_order != LIST_SNAPSHOT_BYTE_ORDER ||
+		header->count < 0) {
+		return -1;
+	}
+
+	values_size = (long long)sizeof(int) * header->count;
+	if (header->values_offset < (long long)sizeof(list_snapshot_header_t) ||
+		header->values_offset % (long long)sizeof(int) != 0 ||
+		header->values_offset > size - values_size) {
+		return -1;
+	}
+	if ((header->flags & LIST_SNAPSHOT_SORTED) != 0 &&
+		(header->sorted_offset < (long long)sizeof(list_snapshot_header_t) ||
+		 header->sorted_offset % (long long)sizeof(int) != 0 ||
+		 header->sorted_offset > size - values_size)) {
+		return -1;
+	}
+	if ((header->flags & LIST_SNAPSHOT_SORTED) == 0 && header->sorted_offset != 0) {
+		return -1;
+	}
+
+	return 0;
+}
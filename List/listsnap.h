@@ -0,0 +1,69 @@
+#if !defined(_LISTSNAP_H_)
+#define _LISTSNAP_H_
+
+#include <stddef.h>
+
+#define LIST_SNAPSHOT_MAGIC "LISTSNAP"
+#define LIST_SNAPSHOT_VERSION (1)
+
+/* Tells a file written on a machine of the other byte order. */
+#define LIST_SNAPSHOT_BYTE_ORDER (0x01020304u)
+
+/* Also store the values in sorted order, for order statistics. */
+#define LIST_SNAPSHOT_SORTED (1)
+
+/* The start of a snapshot file, followed by the arrays it points to. */
+typedef struct list_snapshot_header_rec {
+	char magic[8];
+	unsigned int version;
+	unsigned int byte_order;
+	unsigned int flags;
+	int count;
+	long long sum;
+	unsigned long long sumsq_lo;
+	unsigned long long sumsq_hi;
+	double variance;
+	int min;
+	int max;
+	long long values_offset;	/* bytes from the start of the file */
+	long long sorted_offset;	/* 0 without LIST_SNAPSHOT_SORTED */
+} list_snapshot_header_t;
+
+typedef struct list_snapshot_rec {
+	const struct list_snapshot_header_rec * header;
+	const int * values;
+	const int * sorted;			/* NULL if not stored */
+	void * data;				/* the mapped file, or a copy of it */
+	size_t size;
+	int mapped;
+} list_snapshot_t;
+
+int list_save(struct list_rec * list, const char * path, int flags);
+
+list_snapshot_t * list_snapshot_open(const char * path);
+
+void list_snapshot_close(list_snapshot_t * snapshot);
+
+struct list_rec * list_snapshot_thaw(list_snapshot_t * snapshot);
+
+int list_snapshot_get_count(list_snapshot_t * snapshot);
+
+long long list_snapshot_get_sum(list_snapshot_t * snapshot);
+
+double list_snapshot_get_average(list_snapshot_t * snapshot);
+
+double list_snapshot_get_variance(list_snapshot_t * snapshot);
+
+int list_snapshot_get_min(list_snapshot_t * snapshot, int * out);
+
+int list_snapshot_get_max(list_snapshot_t * snapshot, int * out);
+
+int list_snapshot_get_kth(list_snapshot_t * snapshot, int k, int * out);
+
+int list_snapshot_get_percentile(list_snapshot_t * snapshot, double percent, int * out);
+
+int list_snapshot_get_median(list_snapshot_t * snapshot, int * out);
+
+const int * list_snapshot_get_values(list_snapshot_t * snapshot);
+
+#endif
@@ -0,0 +1,566 @@
+/****************************************************************
+ * Summary: This library implements a bi-directional linked     *
+ *          list that many threads can add to, remove from and  *
+ *          iterate at once. A removal locks only the node and  *
+ *          its neighbours, iteration takes no locks, removed   *
+ *          nodes are freed once no thread can still see them   *
+ *          (epoch based reclamation), and every thread keeps   *
+ *          its own share of the count and sum.                 *
+ *                                                              *
+ *          Every thread registers itself with the list before  *
+ *          using it. Handles are valid between mtlist_enter    *
+ *          and mtlist_exit, or as long as the caller knows no  *
+ *          other thread removes the node.                      *
+ ****************************************************************/
+
+#include <stdlib.h>
+#include <sched.h>
+#include "mtlist.h"
+
+/* Thread records are aligned to this, so they never share a cache line. */
+#define MTLIST_LINE (64)
+
+static void lock(mtlist_node_t * node);
+static void unlock(mtlist_node_t * node);
+static void node_init(mtlist_node_t * node, int value);
+static void retire(mtlist_thread_t * thread, mtlist_node_t * node);
+static void reclaim(mtlist_thread_t * thread);
+static void try_advance(mtlist_t * list);
+static void free_chain(mtlist_node_t * node);
+static mtlist_thread_t * thread_alloc();
+static void thread_free(mtlist_thread_t * thread);
+
+/****************************************************************
+ * Summary: Creates an empty list and returns a pointer         *
+ *          to the list.                                        *
+ *                                                              *
+ * Parameters: None.                                            *
+ *                                                              *
+ * Returns: A pointer to mtlist_t or NULL if failed.            *
+ ****************************************************************/
+mtlist_t * mtlist_create()
+{
+	mtlist_t * new_list = (mtlist_t *)malloc(sizeof(mtlist_t));
+
+	if (new_list == NULL) {
+		return NULL;
+	}
+
+	/* The sentinels point at each other and at NULL beyond them. */
+	node_init(&(new_list->head), 0);
+	node_init(&(new_list->tail), 0);
+	atomic_store(&(new_list->head.next), &(new_list->tail));
+	atomic_store(&(new_list->tail.prev), &(new_list->head));
+	atomic_init(&(new_list->epoch), 0);
+	atomic_init(&(new_list->threads), NULL);
+
+	return new_list;
+}
+
+/****************************************************************
+ * Summary: Destroys a list, freeing memory. No thread may use  *
+ *          the list or its thread records any more.            *
+ *                                                              *
+ * Parameters: list - A pointer to the mtlist_t to destroy.     *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void mtlist_destroy(mtlist_t * list)
+{
+	int i;
+	mtlist_node_t * node = atomic_load(&(list->head.next));
+	mtlist_node_t * next;
+	mtlist_thread_t * thread = atomic_load(&(list->threads));
+	mtlist_thread_t * next_thread;
+
+	/* Free the nodes still in the list. */
+	while (node != &(list->tail)) {
+		next = atomic_load(&(node->next));
+		free(node);
+		node = next;
+	}
+
+	/* Free the retired nodes and the thread records. */
+	while (thread != NULL) {
+		next_thread = thread->next;
+		for (i = 0 ; i < MTLIST_LIMBO ; ++i) {
+			free_chain(thread->limbo[i]);
+		}
+		thread_free(thread);
+		thread = next_thread;
+	}
+
+	free(list);
+}
+
+/****************************************************************
+ * Summary: Registers the calling thread with a list. A record  *
+ *          left by an unregistered thread is reused.           *
+ *                                                              *
+ * Parameters: list - A pointer to the mtlist_t.                *
+ *                                                              *
+ * Returns: A pointer to the thread's mtlist_thread_t or NULL   *
+ *          if failed.                                          *
+ ****************************************************************/
+mtlist_thread_t * mtlist_thread_register(mtlist_t * list)
+{
+	int i;
+	int unused;
+	mtlist_thread_t * thread;
+	mtlist_thread_t * first;
+
+	for (thread = atomic_load(&(list->threads)) ; thread != NULL ; thread = thread->next) {
+		unused = 0;
+		if (atomic_compare_exchange_strong(&(thread->in_use), &unused, 1)) {
+			return thread;
+		}
+	}
+
+	thread = thread_alloc();
+	if (thread == NULL) {
+		return NULL;
+	}
+	thread->list = list;
+	atomic_init(&(thread->in_use), 1);
+	atomic_init(&(thread->active), 0);
+	atomic_init(&(thread->epoch), 0);
+	thread->depth = 0;
+	thread->retired = 0;
+	atomic_init(&(thread->count), 0);
+	atomic_init(&(thread->sum), 0);
+	for (i = 0 ; i < MTLIST_LIMBO ; ++i) {
+		thread->limbo[i] = NULL;
+		thread->limbo_epoch[i] = 0;
+	}
+
+	/* Records are only ever pushed, so readers can walk them freely. */
+	first = atomic_load(&(list->threads));
+	do {
+		thread->next = first;
+	} while (!atomic_compare_exchange_weak(&(list->threads), &first, thread));
+
+	return thread;
+}
+
+/****************************************************************
+ * Summary: Unregisters a thread from its list. Its share of    *
+ *          the count and sum, and its retired nodes, stay with *
+ *          the record until it is reused or the list is        *
+ *          destroyed.                                          *
+ *                                                              *
+ * Parameters: thread - A pointer to the mtlist_thread_t, not   *
+ *                      inside mtlist_enter.                    *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void mtlist_thread_unregister(mtlist_thread_t * thread)
+{
+	reclaim(thread);
+	atomic_store(&(thread->in_use), 0);
+}
+
+/****************************************************************
+ * Summary: Starts a section in which the thread may hold node  *
+ *          handles, none of which are freed until the matching *
+ *          mtlist_exit. Sections may be nested.                *
+ *                                                              *
+ * Parameters: thread - A pointer to the mtlist_thread_t.       *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void mtlist_enter(mtlist_thread_t * thread)
+{
+	if (thread->depth++ > 0) {
+		return;
+	}
+
+	/* Announce the epoch before touching any node. */
+	atomic_store(&(thread->active), 1);
+	atomic_store(&(thread->epoch), atomic_load(&(thread->list->epoch)));
+
+	reclaim(thread);
+}
+
+/****************************************************************
+ * Summary: Ends a section started by mtlist_enter.             *
+ *                                                              *
+ * Parameters: thread - A pointer to the mtlist_thread_t.       *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void mtlist_exit(mtlist_thread_t * thread)
+{
+	if (--(thread->depth) > 0) {
+		return;
+	}
+
+	atomic_store(&(thread->active), 0);
+}
+
+/****************************************************************
+ * Summary: Adds value to the end of the list.                  *
+ *                                                              *
+ * Parameters: thread - A pointer to the mtlist_thread_t.       *
+ *             value - The value to add.                        *
+ *                                                              *
+ * Returns: A pointer to the added node or NULL if failed.      *
+ ****************************************************************/
+mtlist_node_t * mtlist_add_node(mtlist_thread_t * thread, int value)
+{
+	mtlist_t * list = thread->list;
+	mtlist_node_t * tail = &(list->tail);
+	mtlist_node_t * last;
+	mtlist_node_t * new_node = (mtlist_node_t *)malloc(sizeof(mtlist_node_t));
+
+	if (new_node == NULL) {
+		return NULL;
+	}
+	node_init(new_node, value);
+
+	mtlist_enter(thread);
+
+	/* Lock the last node and the tail, left to right. */
+	for (;;) {
+		last = atomic_load(&(tail->prev));
+		lock(last);
+		if (!atomic_load(&(last->deleted)) && atomic_load(&(last->next)) == tail) {
+			break;
+		}
+		unlock(last);
+	}
+	lock(tail);
+
+	atomic_store(&(new_node->prev), last);
+	atomic_store(&(new_node->next), tail);
+	atomic_store(&(last->next), new_node);
+	atomic_store(&(tail->prev), new_node);
+
+	unlock(tail);
+	unlock(last);
+
+	atomic_store_explicit(&(thread->count), atomic_load_explicit(&(thread->count), memory_order_relaxed) + 1,
+						  memory_order_relaxed);
+	atomic_store_explicit(&(thread->sum), atomic_load_explicit(&(thread->sum), memory_order_relaxed) + value,
+						  memory_order_relaxed);
+
+	mtlist_exit(thread);
+
+	return new_node;
+}
+
+/****************************************************************
+ * Summary: Removes a node from the list. The node is freed     *
+ *          once no thread can still be looking at it.          *
+ *                                                              *
+ * Parameters: thread - A pointer to the mtlist_thread_t.       *
+ *             node - A pointer to the node to remove.          *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if another thread   *
+ *          removed node first.                                 *
+ ****************************************************************/
+int mtlist_remove_node(mtlist_thread_t * thread, mtlist_node_t * node)
+{
+	int value = node->val;
+	mtlist_node_t * prev;
+	mtlist_node_t * next;
+
+	if (atomic_load(&(node->deleted))) {
+		return -1;
+	}
+
+	mtlist_enter(thread);
+
+	/* Lock the previous node, the node and the next node, left to right. */
+	for (;;) {
+		prev = atomic_load(&(node->prev));
+		lock(prev);
+		lock(node);
+		if (atomic_load(&(node->deleted))) {
+			unlock(node);
+			unlock(prev);
+			mtlist_exit(thread);
+			return -1;
+		}
+		if (!atomic_load(&(prev->deleted)) && atomic_load(&(node->prev)) == prev) {
+			break;
+		}
+		unlock(node);
+		unlock(prev);
+	}
+	/* node->next only changes under node's lock, which is held. */
+	next = atomic_load(&(node->next));
+	lock(next);
+
+	/* The node keeps its links, so iterators standing on it can go on. */
+	atomic_store(&(node->deleted), 1);
+	atomic_store(&(prev->next), next);
+	atomic_store(&(next->prev), prev);
+
+	unlock(next);
+	unlock(node);
+	unlock(prev);
+
+	atomic_store_explicit(&(thread->count), atomic_load_explicit(&(thread->count), memory_order_relaxed) - 1,
+						  memory_order_relaxed);
+	atomic_store_explicit(&(thread->sum), atomic_load_explicit(&(thread->sum), memory_order_relaxed) - value,
+						  memory_order_relaxed);
+
+	retire(thread, node);
+	mtlist_exit(thread);
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Gets the amount of nodes, merging the share of      *
+ *          every thread. Concurrent changes may or may not be  *
+ *          counted.                                            *
+ *                                                              *
+ * Parameters: list - A pointer to the mtlist_t.                *
+ *                                                              *
+ * Returns: The amount of nodes.                                *
+ ****************************************************************/
+int mtlist_get_count(mtlist_t * list)
+{
+	long long count = 0;
+	mtlist_thread_t * thread;
+
+	for (thread = atomic_load(&(list->threads)) ; thread != NULL ; thread = thread->next) {
+		count += atomic_load_explicit(&(thread->count), memory_order_relaxed);
+	}
+
+	return (int)count;
+}
+
+/****************************************************************
+ * Summary: Gets the sum of the values, merging the share of    *
+ *          every thread.                                       *
+ *                                                              *
+ * Parameters: list - A pointer to the mtlist_t.                *
+ *                                                              *
+ * Returns: The sum of the values.                              *
+ ****************************************************************/
+long long mtlist_get_sum(mtlist_t * list)
+{
+	long long sum = 0;
+	mtlist_thread_t * thread;
+
+	for (thread = atomic_load(&(list->threads)) ; thread != NULL ; thread = thread->next) {
+		sum += atomic_load_explicit(&(thread->sum), memory_order_relaxed);
+	}
+
+	return sum;
+}
+
+/****************************************************************
+ * Summary: Gets the average of the values.                     *
+ *                                                              *
+ * Parameters: list - A pointer to the mtlist_t.                *
+ *                                                              *
+ * Returns: The average, 0 if the list is empty.                *
+ ****************************************************************/
+double mtlist_get_average(mtlist_t * list)
+{
+	long long count = 0;
+	long long sum = 0;
+	mtlist_thread_t * thread;
+
+	for (thread = atomic_load(&(list->threads)) ; thread != NULL ; thread = thread->next) {
+		count += atomic_load_explicit(&(thread->count), memory_order_relaxed);
+		sum += atomic_load_explicit(&(thread->sum), memory_order_relaxed);
+	}
+
+	return (count <= 0) ? 0 : (double)sum / count;
+}
+
+/****************************************************************
+ * Summary: Gets the first node of the list.                    *
+ *                                                              *
+ * Parameters: list - A pointer to the mtlist_t.                *
+ *                                                              *
+ * Returns: A pointer to the first node or NULL if empty.       *
+ ****************************************************************/
+mtlist_node_t * mtlist_get_head(mtlist_t * list)
+{
+	return mtlist_get_next_node(&(list->head));
+}
+
+/****************************************************************
+ * Summary: Gets the last node of the list.                     *
+ *                                                              *
+ * Parameters: list - A pointer to the mtlist_t.                *
+ *                                                              *
+ * Returns: A pointer to the last node or NULL if empty.        *
+ ****************************************************************/
+mtlist_node_t * mtlist_get_tail(mtlist_t * list)
+{
+	return mtlist_get_prev_node(&(list->tail));
+}
+
+/****************************************************************
+ * Summary: Gets the next node, skipping removed nodes. Works   *
+ *          from a removed node too.                            *
+ *                                                              *
+ * Parameters: node - A pointer to the node.                    *
+ *                                                              *
+ * Returns: A pointer to the next node or NULL if node is last. *
+ ****************************************************************/
+mtlist_node_t * mtlist_get_next_node(mtlist_node_t * node)
+{
+	mtlist_node_t * next = atomic_load(&(node->next));
+
+	/* Only the tail sentinel has no next node. */
+	while (atomic_load(&(next->next)) != NULL && atomic_load(&(next->deleted))) {
+		next = atomic_load(&(next->next));
+	}
+
+	return (atomic_load(&(next->next)) == NULL) ? NULL : next;
+}
+
+/****************************************************************
+ * Summary: Gets the previous node, skipping removed nodes.     *
+ *          Works from a removed node too.                      *
+ *                                                              *
+ * Parameters: node - A pointer to the node.                    *
+ *                                                              *
+ * Returns: A pointer to the previous node or NULL if node is   *
+ *          first.                                              *
+ ****************************************************************/
+mtlist_node_t * mtlist_get_prev_node(mtlist_node_t * node)
+{
+	mtlist_node_t * prev = atomic_load(&(node->prev));
+
+	/* Only the head sentinel has no previous node. */
+	while (atomic_load(&(prev->prev)) != NULL && atomic_load(&(prev->deleted))) {
+		prev = atomic_load(&(prev->prev));
+	}
+
+	return (atomic_load(&(prev->prev)) == NULL) ? NULL : prev;
+}
+
+/****************************************************************
+ * Summary: Gets the value of a node.                           *
+ *                                                              *
+ * Parameters: node - A pointer to the node.                    *
+ *                                                              *
+ * Returns: The value of the node.                              *
+ ****************************************************************/
+int mtlist_get_node_value(mtlist_node_t * node)
+{
+	return node->val;
+}
+
+/* Spins on a node's lock, yielding the processor while it is held. */
+static void lock(mtlist_node_t * node)
+{
+	while (atomic_flag_test_and_set_explicit(&(node->lock), memory_order_acquire)) {
+		sched_yield();
+	}
+}
+
+static void unlock(mtlist_node_t * node)
+{
+	atomic_flag_clear_explicit(&(node->lock), memory_order_release);
+}
+
+static void node_init(mtlist_node_t * node, int value)
+{
+	node->val = value;
+	atomic_init(&(node->deleted), 0);
+	atomic_flag_clear(&(node->lock));
+	atomic_init(&(node->next), NULL);
+	atomic_init(&(node->prev), NULL);
+	node->retired_next = NULL;
+}
+
+/****************************************************************
+ * Summary: Puts an unlinked node in the limbo list of the      *
+ *          current global epoch. Threads that could still see  *
+ *          it entered in that epoch or before, so it is freed  *
+ *          once the global epoch is two ahead.                 *
+ *                                                              *
+ * Parameters: thread - A pointer to the mtlist_thread_t.       *
+ *             node - The unlinked node.                        *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+static void retire(mtlist_thread_t * thread, mtlist_node_t * node)
+{
+	unsigned int epoch = atomic_load(&(thread->list->epoch));
+	int i = (int)(epoch % MTLIST_LIMBO);
+
+	/* A bucket from an older epoch is at least MTLIST_LIMBO epochs old. */
+	if (thread->limbo[i] != NULL && thread->limbo_epoch[i] != epoch) {
+		free_chain(thread->limbo[i]);
+		thread->limbo[i] = NULL;
+	}
+	node->retired_next = thread->limbo[i];
+	thread->limbo[i] = node;
+	thread->limbo_epoch[i] = epoch;
+
+	if (++(thread->retired) >= MTLIST_ADVANCE_EVERY) {
+		thread->retired = 0;
+		try_advance(thread->list);
+		reclaim(thread);
+	}
+}
+
+/* Frees the limbo lists of a thread that are two epochs old. */
+static void reclaim(mtlist_thread_t * thread)
+{
+	int i;
+	unsigned int epoch = atomic_load(&(thread->list->epoch));
+
+	for (i = 0 ; i < MTLIST_LIMBO ; ++i) {
+		if (thread->limbo[i] != NULL && epoch - thread->limbo_epoch[i] >= 2) {
+			free_chain(thread->limbo[i]);
+			thread->limbo[i] = NULL;
+		}
+	}
+}
+
+/* Moves the global epoch on if every active thread has seen it. */
+static void try_advance(mtlist_t * list)
+{
+	unsigned int epoch = atomic_load(&(list->epoch));
+	mtlist_thread_t * thread;
+
+	for (thread = atomic_load(&(list->threads)) ; thread != NULL ; thread = thread->next) {
+		if (atomic_load(&(thread->active)) && atomic_load(&(thread->epoch)) != epoch) {
+			return;
+		}
+	}
+
+	atomic_compare_exchange_strong(&(list->epoch), &epoch, epoch + 1);
+}
+
+static void free_chain(mtlist_node_t * node)
+{
+	mtlist_node_t * next;
+
+	while (node != NULL) {
+		next = node->retired_next;
+		free(node);
+		node = next;
+	}
+}
+
+static mtlist_thread_t * thread_alloc()
+{
+	size_t size = (sizeof(mtlist_thread_t) + MTLIST_LINE - 1) & ~(size_t)(MTLIST_LINE - 1);
+
+#if defined(_MSC_VER)
+	return (mtlist_thread_t *)_aligned_malloc(size, MTLIST_LINE);
+#else
+	return (mtlist_thread_t *)aligned_alloc(MTLIST_LINE, size);
+#endif
+}
+
+static void thread_free(mtlist_thread_t * thread)
+{
+#if defined(_MSC_VER)
+	_aligned_free(thread);
+#else
+	free(thread);
+#endif
+}
@@ -0,0 +1,75 @@
+#if !defined(_MTLIST_H_)
+#define _MTLIST_H_
+
+#include <stdatomic.h>
+
+/* Epochs a retired node waits through before it is freed, plus one. */
+#define MTLIST_LIMBO (3)
+
+/* Retired nodes between attempts to advance the global epoch. */
+#define MTLIST_ADVANCE_EVERY (64)
+
+typedef struct mtlist_node_rec {
+	int val;
+	atomic_int deleted;		/* set, under the node's lock, when unlinked */
+	atomic_flag lock;
+	_Atomic(struct mtlist_node_rec *) next;
+	_Atomic(struct mtlist_node_rec *) prev;
+	struct mtlist_node_rec * retired_next;	/* link in a limbo list */
+} mtlist_node_t;
+
+/* The state of one thread using a list, allocated on its own cache line. */
+typedef struct mtlist_thread_rec {
+	struct mtlist_rec * list;
+	atomic_int in_use;		/* registered to a thread */
+	atomic_int active;		/* inside mtlist_enter / mtlist_exit */
+	atomic_uint epoch;		/* the global epoch seen on entering */
+	int depth;				/* nesting of mtlist_enter */
+	int retired;			/* nodes retired since the last advance attempt */
+	atomic_llong count;		/* this thread's share of the count */
+	atomic_llong sum;		/* this thread's share of the sum */
+	struct mtlist_node_rec * limbo[MTLIST_LIMBO];
+	unsigned int limbo_epoch[MTLIST_LIMBO];
+	struct mtlist_thread_rec * next;	/* the next registered thread */
+} mtlist_thread_t;
+
+typedef struct mtlist_rec {
+	struct mtlist_node_rec head;	/* sentinels, never removed */
+	struct mtlist_node_rec tail;
+	atomic_uint epoch;
+	_Atomic(struct mtlist_thread_rec *) threads;
+} mtlist_t;
+
+mtlist_t * mtlist_create();
+
+void mtlist_destroy(mtlist_t * list);
+
+mtlist_thread_t * mtlist_thread_register(mtlist_t * list);
+
+void mtlist_thread_unregister(mtlist_thread_t * thread);
+
+void mtlist_enter(mtlist_thread_t * thread);
+
+void mtlist_exit(mtlist_thread_t * thread);
+
+mtlist_node_t * mtlist_add_node(mtlist_thread_t * thread, int value);
+
+int mtlist_remove_node(mtlist_thread_t * thread, mtlist_node_t * node);
+
+int mtlist_get_count(mtlist_t * list);
+
+long long mtlist_get_sum(mtlist_t * list);
+
+double mtlist_get_average(mtlist_t * list);
+
+mtlist_node_t * mtlist_get_head(mtlist_t * list);
+
+mtlist_node_t * mtlist_get_tail(mtlist_t * list);
+
+mtlist_node_t * mtlist_get_next_node(mtlist_node_t * node);
+
+mtlist_node_t * mtlist_get_prev_node(mtlist_node_t * node);
+
+int mtlist_get_node_value(mtlist_node_t * node);
+
+#endif
@@ -0,0 +1,394 @@
+/****************************************************************
+ * Summary: This library implements an order statistic tree, an *
+ *          AVL tree of distinct int keys where every node also *
+ *          holds the amount of keys in its subtree, so finding *
+ *          the k-th smallest key or the rank of a key takes    *
+ *          O(log n). Duplicate keys share one node.            *
+ ****************************************************************/
+
+#include <stdlib.h>
+#include "ostree.h"
+
+#define HEIGHT(node) (((node) == NULL) ? 0 : (node)->height)
+#define SIZE(node) (((node) == NULL) ? 0 : (node)->size)
+
+static void destroy_subtree(ostree_node_t * node);
+static void update(ostree_node_t * node);
+static ostree_node_t * rotate_left(ostree_node_t * node);
+static ostree_node_t * rotate_right(ostree_node_t * node);
+static ostree_node_t * balance(ostree_node_t * node);
+static ostree_node_t * insert(ostree_node_t * node, int key, int * failed);
+static ostree_node_t * remove_key(ostree_node_t * node, int key, int * found);
+static ostree_node_t * remove_min(ostree_node_t * node, ostree_node_t ** min);
+
+/****************************************************************
+ * Summary: Creates an empty tree and returns a pointer to it.  *
+ *                                                              *
+ * Parameters: None.                                            *
+ *                                                              *
+ * Returns: A pointer to ostree_t or NULL if failed.            *
+ ****************************************************************/
+ostree_t * ostree_create()
+{
+	ostree_t * new_tree = (ostree_t *)malloc(sizeof(ostree_t));
+
+	if (new_tree == NULL) {
+		return NULL;
+	}
+
+	new_tree->root = NULL;
+
+	return new_tree;
+}
+
+/****************************************************************
+ * Summary: Destroys a tree, freeing memory.                    *
+ *                                                              *
+ * Parameters: tree - A pointer to the ostree_t to destroy.     *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void ostree_destroy(ostree_t * tree)
+{
+	destroy_subtree(tree->root);
+	free(tree);
+}
+
+/****************************************************************
+ * Summary: Removes every key from a tree.                      *
+ *                                                              *
+ * Parameters: tree - A pointer to the ostree_t.                *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void ostree_clear(ostree_t * tree)
+{
+	destroy_subtree(tree->root);
+	tree->root = NULL;
+}
+
+/****************************************************************
+ * Summary: Inserts a key into a tree.                          *
+ *                                                              *
+ * Parameters: tree - A pointer to the ostree_t.                *
+ *             key - The key to insert.                         *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if failed.          *
+ ****************************************************************/
+int ostree_insert(ostree_t * tree, int key)
+{
+	int failed = 0;
+
+	tree->root = insert(tree->root, key, &failed);
+
+	return failed ? -1 : 0;
+}
+
+/****************************************************************
+ * Summary: Removes one occurrence of a key from a tree.        *
+ *                                                              *
+ * Parameters: tree - A pointer to the ostree_t.                *
+ *             key - The key to remove.                         *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if key is not in    *
+ *          the tree.                                           *
+ ****************************************************************/
+int ostree_remove(ostree_t * tree, int key)
+{
+	int found = 0;
+
+	tree->root = remove_key(tree->root, key, &found);
+
+	return found ? 0 : -1;
+}
+
+/****************************************************************
+ * Summary: Gets the amount of keys in a tree, counting every   *
+ *          occurrence of a duplicate key.                      *
+ *                                                              *
+ * Parameters: tree - A pointer to the ostree_t.                *
+ *                                                              *
+ * Returns: The amount of keys in the tree.                     *
+ ****************************************************************/
+int ostree_get_size(ostree_t * tree)
+{
+	return SIZE(tree->root);
+}
+
+/****************************************************************
+ * Summary: Gets the k-th smallest key.                         *
+ *                                                              *
+ * Parameters: tree - A pointer to the ostree_t.                *
+ *             k - The 0-based position in sorted order.        *
+ *             out - A pointer to an int to hold the key.       *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if k is out of      *
+ *          range.                                              *
+ ****************************************************************/
+int ostree_select(ostree_t * tree, int k, int * out)
+{
+	ostree_node_t * node = tree->root;
+
+	if (k < 0 || k >= SIZE(node)) {
+		return -1;
+	}
+
+	while (node != NULL) {
+		if (k < SIZE(node->left)) {
+			node = node->left;
+		} else if (k < SIZE(node->left) + node->mult) {
+			*out = node->key;
+			return 0;
+		} else {
+			k -= SIZE(node->left) + node->mult;
+			node = node->right;
+		}
+	}
+
+	return -1;
+}
+
+/****************************************************************
+ * Summary: Counts the keys smaller than key.                   *
+ *                                                              *
+ * Parameters: tree - A pointer to the ostree_t.                *
+ *             key - The key to rank.                           *
+ *                                                              *
+ * Returns: The amount of keys in the tree smaller than key.    *
+ ****************************************************************/
+int ostree_rank(ostree_t * tree, int key)
+{
+	int rank = 0;
+	ostree_node_t * node = tree->root;
+
+	while (node != NULL) {
+		if (key <= node->key) {
+			node = node->left;
+		} else {
+			rank += SIZE(node->left) + node->mult;
+			node = node->right;
+		}
+	}
+
+	return rank;
+}
+
+/****************************************************************
+ * Summary: Gets the smallest key that is not smaller than key. *
+ *                                                              *
+ * Parameters: tree - A pointer to the ostree_t.                *
+ *             key - The lower bound.                           *
+ *             out - A pointer to an int to hold the key.       *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if every key is     *
+ *          smaller than key.                                   *
+ ****************************************************************/
+int ostree_ceil(ostree_t * tree, int key, int * out)
+{
+	int found = 0;
+	ostree_node_t * node = tree->root;
+
+	while (node != NULL) {
+		if (node->key < key) {
+			node = node->right;
+		} else {
+			*out = node->key;
+			found = 1;
+			node = node->left;
+		}
+	}
+
+	return found ? 0 : -1;
+}
+
+/****************************************************************
+ * Summary: Gets the smallest key.                              *
+ *                                                              *
+ * Parameters: tree - A pointer to the ostree_t.                *
+ *             out - A pointer to an int to hold the key.       *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if the tree is      *
+ *          empty.                                              *
+ ****************************************************************/
+int ostree_get_min(ostree_t * tree, int * out)
+{
+	ostree_node_t * node = tree->root;
+
+	if (node == NULL) {
+		return -1;
+	}
+	while (node->left != NULL) {
+		node = node->left;
+	}
+	*out = node->key;
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Gets the largest key.                               *
+ *                                                              *
+ * Parameters: tree - A pointer to the ostree_t.                *
+ *             out - A pointer to an int to hold the key.       *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if the tree is      *
+ *          empty.                                              *
+ ****************************************************************/
+int ostree_get_max(ostree_t * tree, int * out)
+{
+	ostree_node_t * node = tree->root;
+
+	if (node == NULL) {
+		return -1;
+	}
+	while (node->right != NULL) {
+		node = node->right;
+	}
+	*out = node->key;
+
+	return 0;
+}
+
+static void destroy_subtree(ostree_node_t * node)
+{
+	ostree_node_t * right;
+
+	/* Recurse on the left only, walk down the right. */
+	while (node != NULL) {
+		destroy_subtree(node->left);
+		right = node->right;
+		free(node);
+		node = right;
+	}
+}
+
+/* Recomputes the height and size of a node from its children. */
+static void update(ostree_node_t * node)
+{
+	int left = HEIGHT(node->left);
+	int right = HEIGHT(node->right);
+
+	node->height = ((left > right) ? left : right) + 1;
+	node->size = SIZE(node->left) + SIZE(node->right) + node->mult;
+}
+
+static ostree_node_t * rotate_left(ostree_node_t * node)
+{
+	ostree_node_t * top = node->right;
+
+	node->right = top->left;
+	top->left = node;
+	update(node);
+	update(top);
+
+	return top;
+}
+
+static ostree_node_t * rotate_right(ostree_node_t * node)
+{
+	ostree_node_t * top = node->left;
+
+	node->left = top->right;
+	top->right = node;
+	update(node);
+	update(top);
+
+	return top;
+}
+
+/* Restores the AVL property of a node whose children are balanced. */
+static ostree_node_t * balance(ostree_node_t * node)
+{
+	int diff;
+
+	update(node);
+	diff = HEIGHT(node->left) - HEIGHT(node->right);
+
+	if (diff > 1) {
+		if (HEIGHT(node->left->left) < HEIGHT(node->left->right)) {
+			node->left = rotate_left(node->left);
+		}
+		return rotate_right(node);
+	}
+	if (diff < -1) {
+		if (HEIGHT(node->right->right) < HEIGHT(node->right->left)) {
+			node->right = rotate_right(node->right);
+		}
+		return rotate_left(node);
+	}
+
+	return node;
+}
+
+static ostree_node_t * insert(ostree_node_t * node, int key, int * failed)
+{
+	if (node == NULL) {
+		node = (ostree_node_t *)malloc(sizeof(ostree_node_t));
+		if (node == NULL) {
+			*failed = 1;
+			return NULL;
+		}
+		node->key = key;
+		node->mult = 1;
+		node->size = 1;
+		node->height = 1;
+		node->left = NULL;
+		node->right = NULL;
+		return node;
+	}
+
+	if (key < node->key) {
+		node->left = insert(node->left, key, failed);
+	} else if (key > node->key) {
+		node->right = insert(node->right, key, failed);
+	} else { /* a duplicate key */
+		++(node->mult);
+	}
+
+	return balance(node);
+}
+
+static ostree_node_t * remove_key(ostree_node_t * node, int key, int * found)
+{
+	ostree_node_t * min;
+
+	if (node == NULL) {
+		return NULL;
+	}
+
+	if (key < node->key) {
+		node->left = remove_key(node->left, key, found);
+	} else if (key > node->key) {
+		node->right = remove_key(node->right, key, found);
+	} else {
+		*found = 1;
+		if (node->mult > 1) { /* other occurrences remain */
+			--(node->mult);
+		} else if (node->right == NULL) {
+			min = node->left;
+			free(node);
+			return min;
+		} else {
+			/* Replace the node by the smallest node on its right. */
+			node->right = remove_min(node->right, &min);
+			min->left = node->left;
+			min->right = node->right;
+			free(node);
+			node = min;
+		}
+	}
+
+	return balance(node);
+}
+
+/* Detaches the smallest node of a subtree into min. */
+static ostree_node_t * remove_min(ostree_node_t * node, ostree_node_t ** min)
+{
+	if (node->left == NULL) {
+		*min = node;
+		return node->right;
+	}
+	node->left = remove_min(node->left, min);
+
+	return balance(node);
+}
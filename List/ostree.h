@@ -0,0 +1,40 @@
+#if !defined(_OSTREE_H_)
+#define _OSTREE_H_
+
+/* One distinct key, mult is how many times it was inserted. */
+typedef struct ostree_node_rec {
+	int key;
+	int mult;
+	int size;		/* sum of mult in this subtree */
+	int height;
+	struct ostree_node_rec * left;
+	struct ostree_node_rec * right;
+} ostree_node_t;
+
+typedef struct ostree_rec {
+	struct ostree_node_rec * root;
+} ostree_t;
+
+ostree_t * ostree_create();
+
+void ostree_destroy(ostree_t * tree);
+
+void ostree_clear(ostree_t * tree);
+
+int ostree_insert(ostree_t * tree, int key);
+
+int ostree_remove(ostree_t * tree, int key);
+
+int ostree_get_size(ostree_t * tree);
+
+int ostree_select(ostree_t * tree, int k, int * out);
+
+int ostree_rank(ostree_t * tree, int key);
+
+int ostree_ceil(ostree_t * tree, int key, int * out);
+
+int ostree_get_min(ostree_t * tree, int * out);
+
+int ostree_get_max(ostree_t * tree, int * out);
+
+#endif
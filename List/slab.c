@@ -0,0 +1,206 @@
+/****************************************************************
+ * Summary: This library implements a slab allocator for        *
+ *          objects of one size. Objects are carved in order    *
+ *          from large blocks, freed objects are kept on a free *
+ *          list for reuse, and destroying the slab releases    *
+ *          whole blocks without visiting the objects.          *
+ ****************************************************************/
+
+#include <stdlib.h>
+#include "slab.h"
+
+/* Objects are aligned like the strictest of these. */
+typedef union slab_align_rec {
+	void * pointer;
+	long long integer;
+	double real;
+} slab_align_t;
+
+#define ALIGN_UP(size) \
+	((((size) + sizeof(slab_align_t) - 1) / sizeof(slab_align_t)) * sizeof(slab_align_t))
+
+static int add_block(slab_t * slab);
+
+/****************************************************************
+ * Summary: Creates an empty slab and returns a pointer to it.  *
+ *                                                              *
+ * Parameters: object_size - The size of every object.         *
+ *             per_block - Objects per block, or 0 for          *
+ *                         SLAB_DEFAULT_OBJECTS.                *
+ *                                                              *
+ * Returns: A pointer to slab_t or NULL if failed.              *
+ ****************************************************************/
+slab_t * slab_create(int object_size, int per_block)
+{
+	slab_t * new_slab;
+
+	if (object_size < 1 || per_block < 0) {
+		return NULL;
+	}
+
+	new_slab = (slab_t *)malloc(sizeof(slab_t));
+	if (new_slab == NULL) {
+		return NULL;
+	}
+
+	/* Every object must be able to hold the free list link. */
+	if ((size_t)object_size < sizeof(void *)) {
+		object_size = (int)sizeof(void *);
+	}
+	new_slab->object_size = (int)ALIGN_UP((size_t)object_size);
+	new_slab->per_block = (per_block == 0) ? SLAB_DEFAULT_OBJECTS : per_block;
+	new_slab->free_list = NULL;
+	new_slab->next = NULL;
+	new_slab->end = NULL;
+	new_slab->blocks = NULL;
+	new_slab->refs = 1;
+
+	return new_slab;
+}
+
+/****************************************************************
+ * Summary: Gives up one owner's share of a slab. The last      *
+ *          owner destroys it, freeing every object in it.      *
+ *                                                              *
+ * Parameters: slab - A pointer to the slab_t to destroy.       *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void slab_destroy(slab_t * slab)
+{
+	slab_block_t * block = slab->blocks;
+	slab_block_t * next;
+
+	if (--(slab->refs) > 0) {
+		return;
+	}
+
+	while (block != NULL) {
+		next = block->next;
+		free(block);
+		block = next;
+	}
+	free(slab);
+}
+
+/****************************************************************
+ * Summary: Adds an owner to a slab, which then takes one more  *
+ *          slab_destroy to free.                               *
+ *                                                              *
+ * Parameters: slab - A pointer to the slab_t.                  *
+ *                                                              *
+ * Returns: slab.                                               *
+ ****************************************************************/
+slab_t * slab_share(slab_t * slab)
+{
+	++(slab->refs);
+
+	return slab;
+}
+
+/****************************************************************
+ * Summary: Moves every block of src to dest, so objects of src *
+ *          now belong to dest. src is left empty and usable.   *
+ *          The unused room left in src is dropped.             *
+ *                                                              *
+ * Parameters: dest - A pointer to the slab_t to move to.       *
+ *             src - A pointer to the slab_t to move from.      *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if the objects      *
+ *          differ in size or src has other owners.             *
+ ****************************************************************/
+int slab_merge(slab_t * dest, slab_t * src)
+{
+	slab_block_t * last;
+
+	if (dest->object_size != src->object_size || src->refs > 1) {
+		return -1;
+	}
+	if (src->blocks == NULL) {
+		return 0;
+	}
+
+	/* The newest block of dest stays first so its room is still used. */
+	for (last = src->blocks ; last->next != NULL ; last = last->next) {
+	}
+	if (dest->blocks == NULL) {
+		dest->blocks = src->blocks;
+	} else {
+		last->next = dest->blocks->next;
+		dest->blocks->next = src->blocks;
+	}
+
+	src->free_list = NULL;
+	src->next = NULL;
+	src->end = NULL;
+	src->blocks = NULL;
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Allocates an object, reusing a freed one if any.    *
+ *                                                              *
+ * Parameters: slab - A pointer to the slab_t.                  *
+ *                                                              *
+ * Returns: A pointer to the object or NULL if failed.          *
+ ****************************************************************/
+void * slab_alloc(slab_t * slab)
+{
+	void * object;
+
+	/* Reuse a freed object. */
+	if (slab->free_list != NULL) {
+		object = slab->free_list;
+		slab->free_list = *(void **)object;
+		return object;
+	}
+
+	/* Take the next object of the newest block. */
+	if (slab->next == slab->end && add_block(slab) != 0) {
+		return NULL;
+	}
+	object = slab->next;
+	slab->next += slab->object_size;
+
+	return object;
+}
+
+/****************************************************************
+ * Summary: Returns an object to the slab.                      *
+ *                                                              *
+ * Parameters: slab - A pointer to the slab_t.                  *
+ *             object - An object allocated from this slab.     *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void slab_free(slab_t * slab, void * object)
+{
+	*(void **)object = slab->free_list;
+	slab->free_list = object;
+}
+
+/****************************************************************
+ * Summary: Allocates a new block and makes it the newest.      *
+ *                                                              *
+ * Parameters: slab - A pointer to the slab_t.                  *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if failed.          *
+ ****************************************************************/
+static int add_block(slab_t * slab)
+{
+	size_t header = ALIGN_UP(sizeof(slab_block_t));
+	slab_block_t * block;
+
+	block = (slab_block_t *)malloc(header + (size_t)slab->object_size * slab->per_block);
+	if (block == NULL) {
+		return -1;
+	}
+
+	block->next = slab->blocks;
+	slab->blocks = block;
+	slab->next = (char *)block + header;
+	slab->end = slab->next + (size_t)slab->object_size * slab->per_block;
+
+	return 0;
+}
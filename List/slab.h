@@ -0,0 +1,32 @@
+#if !defined(_SLAB_H_)
+#define _SLAB_H_
+
+#define SLAB_DEFAULT_OBJECTS (1024)
+
+typedef struct slab_block_rec {
+	struct slab_block_rec * next;
+} slab_block_t;
+
+typedef struct slab_rec {
+	int object_size;	/* bytes per object, rounded up for alignment */
+	int per_block;		/* objects per block */
+	void * free_list;	/* freed objects, linked through their first bytes */
+	char * next;		/* the next never used object in the newest block */
+	char * end;			/* the end of the newest block */
+	struct slab_block_rec * blocks;
+	int refs;			/* owners, the slab is freed when the last one is done */
+} slab_t;
+
+slab_t * slab_create(int object_size, int per_block);
+
+void slab_destroy(slab_t * slab);
+
+slab_t * slab_share(slab_t * slab);
+
+int slab_merge(slab_t * dest, slab_t * src);
+
+void * slab_alloc(slab_t * slab);
+
+void slab_free(slab_t * slab, void * object);
+
+#endif
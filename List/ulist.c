@@ -0,0 +1,413 @@
+/****************************************************************
+ * Summary: This library implements an unrolled bi-directional  *
+ *          linked list. Every node is a chunk of one cache     *
+ *          line that holds several values, values only move in *
+ *          ulist_compact so a pointer to a value is a stable   *
+ *          handle, and the chunk of a handle is found by       *
+ *          masking its address.                                *
+ ****************************************************************/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "ulist.h"
+
+/* Fails to compile if a chunk does not fit in ULIST_CHUNK_SIZE bytes. */
+typedef char ulist_chunk_fits[(sizeof(ulist_chunk_t) <= ULIST_CHUNK_SIZE &&
+							   ULIST_CHUNK_VALUES <= 32) ? 1 : -1];
+
+#define CHUNK_OF(node) \
+	((ulist_chunk_t *)((uintptr_t)(node) & ~(uintptr_t)(ULIST_CHUNK_SIZE - 1)))
+
+static ulist_chunk_t * chunk_alloc();
+static void chunk_free(ulist_chunk_t * chunk);
+static unsigned int low_bits(unsigned int count);
+static int lowest_bit(unsigned int bits);
+static int highest_bit(unsigned int bits);
+
+/****************************************************************
+ * Summary: Creates an empty list and returns a pointer         *
+ *          to the list.                                        *
+ *                                                              *
+ * Parameters: None.                                            *
+ *                                                              *
+ * Returns: A pointer to ulist_t or NULL if failed.             *
+ ****************************************************************/
+ulist_t * ulist_create()
+{
+	/* Allocate memory. */
+	ulist_t * new_list = (ulist_t *)malloc(sizeof(ulist_t));
+
+	/* Check if malloc succeeded. */
+	if (new_list == NULL) {
+		return NULL;
+	}
+
+	/* Initialize members. */
+	new_list->count = 0;
+	new_list->sum = 0;
+	new_list->head = NULL;
+	new_list->tail = NULL;
+
+	return new_list;
+}
+
+/****************************************************************
+ * Summary: Destroys a list, freeing memory.                    *
+ *                                                              *
+ * Parameters: list - A pointer to the ulist_t to destroy.      *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void ulist_destroy(ulist_t * list)
+{
+	ulist_chunk_t * chunk = list->head;
+	ulist_chunk_t * next;
+
+	/* Free all chunks' memory. */
+	while (chunk != NULL) {
+		next = chunk->next;
+		chunk_free(chunk);
+		chunk = next;
+	}
+	/* Free list memory. */
+	free(list);
+}
+
+/****************************************************************
+ * Summary: Adds value to the end of the list.                  *
+ *                                                              *
+ * Parameters: list - A pointer to the ulist_t.                 *
+ *             value - The value to add.                        *
+ *                                                              *
+ * Returns: A handle to the added value or NULL if failed.      *
+ ****************************************************************/
+ulist_node_t * ulist_add_node(ulist_t * list, int value)
+{
+	ulist_chunk_t * chunk = list->tail;
+	ulist_node_t * new_node;
+
+	/* Start a new chunk if the tail is full. */
+	if (chunk == NULL || chunk->filled == ULIST_CHUNK_VALUES) {
+		chunk = chunk_alloc();
+		if (chunk == NULL) {
+			return NULL;
+		}
+		chunk->prev = list->tail;
+		if (list->tail != NULL) { /* if not adding to an empty list */
+			list->tail->next = chunk;
+		}
+		list->tail = chunk;
+		if (list->head == NULL) { /* if adding to an empty list */
+			list->head = chunk;
+		}
+	}
+
+	/* Take the next slot of the tail chunk. */
+	new_node = &(chunk->slots[chunk->filled]);
+	new_node->val = value;
+	chunk->used |= 1u << chunk->filled;
+	++(chunk->filled);
+
+	/* Update list's count and sum. */
+	++(list->count);
+	list->sum += value;
+
+	return new_node;
+}
+
+/****************************************************************
+ * Summary: Removes a value from a list. Other handles stay     *
+ *          valid, the slot is not reused and the chunk is      *
+ *          freed once its last value is removed.               *
+ *                                                              *
+ * Parameters: list - A pointer to the ulist_t.                 *
+ *             node - The handle of the value to remove.        *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void ulist_remove_node(ulist_t * list, ulist_node_t * node)
+{
+	ulist_chunk_t * chunk = CHUNK_OF(node);
+
+	/* Update list's count and sum. */
+	--(list->count);
+	list->sum -= node->val;
+
+	/* Free the slot. */
+	chunk->used &= ~(1u << (node - chunk->slots));
+	if (chunk->used != 0) {
+		return;
+	}
+
+	/* Remove the empty chunk from the list. */
+	if (chunk->next == NULL) { /* if removing tail */
+		list->tail = chunk->prev;
+	} else {
+		chunk->next->prev = chunk->prev;
+	}
+	if (chunk->prev == NULL) { /* if removing head */
+		list->head = chunk->next;
+	} else { /* if removing a chunk from the middle */
+		chunk->prev->next = chunk->next;
+	}
+
+	/* Free memory. */
+	chunk_free(chunk);
+}
+
+/****************************************************************
+ * Summary: Packs the values of a list into as few chunks as    *
+ *          they fit in, keeping their order, and frees the     *
+ *          chunks left empty. Removals that leave chunks       *
+ *          sparse cost memory and iteration until then.        *
+ *          Handles to values of the list are invalid after.    *
+ *                                                              *
+ * Parameters: list - A pointer to the ulist_t.                 *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void ulist_compact(ulist_t * list)
+{
+	ulist_chunk_t * chunk = list->head;
+	ulist_chunk_t * next;
+	ulist_chunk_t * to = list->head;	/* the chunk values are packed into */
+	unsigned int slot = 0;				/* the next slot of to */
+	unsigned int used;
+
+	/* Values only move back, so a chunk is read before it is written. */
+	while (chunk != NULL) {
+		used = chunk->used;
+		next = chunk->next;
+		while (used != 0) {
+			if (slot == ULIST_CHUNK_VALUES) {
+				to->used = low_bits(slot);
+				to->filled = slot;
+				to = to->next;
+				slot = 0;
+			}
+			to->slots[slot] = chunk->slots[lowest_bit(used)];
+			++slot;
+			used &= used - 1;
+		}
+		chunk = next;
+	}
+	if (to == NULL) { /* if the list is empty */
+		return;
+	}
+	to->used = low_bits(slot);
+	to->filled = slot;
+
+	/* Free the chunks after the last value. */
+	chunk = to->next;
+	to->next = NULL;
+	list->tail = to;
+	while (chunk != NULL) {
+		next = chunk->next;
+		chunk_free(chunk);
+		chunk = next;
+	}
+}
+
+/****************************************************************
+ * Summary: Gets the amount of values in a list.                *
+ *                                                              *
+ * Parameters: list - A pointer to the ulist_t.                 *
+ *                                                              *
+ * Returns: The amount of values in the list.                   *
+ ****************************************************************/
+int ulist_get_count(ulist_t * list)
+{
+	return list->count;
+}
+
+/****************************************************************
+ * Summary: Gets the average of the values in a list.           *
+ *                                                              *
+ * Parameters: list - A pointer to the ulist_t.                 *
+ *                                                              *
+ * Returns: The average of the values in the list, 0 if the     *
+ *          list is empty.                                      *
+ ****************************************************************/
+double ulist_get_average(ulist_t * list)
+{
+	if (list->count == 0) {
+		return 0;
+	}
+	return (double)(list->sum) / (list->count);
+}
+
+/****************************************************************
+ * Summary: Gets the first value in a list.                     *
+ *                                                              *
+ * Parameters: list - A pointer to the ulist_t.                 *
+ *                                                              *
+ * Returns: A handle to the first value, NULL if empty.         *
+ ****************************************************************/
+ulist_node_t * ulist_get_head(ulist_t * list)
+{
+	if (list->head == NULL) {
+		return NULL;
+	}
+	return &(list->head->slots[lowest_bit(list->head->used)]);
+}
+
+/****************************************************************
+ * Summary: Gets the last value in a list.                      *
+ *                                                              *
+ * Parameters: list - A pointer to the ulist_t.                 *
+ *                                                              *
+ * Returns: A handle to the last value, NULL if empty.          *
+ ****************************************************************/
+ulist_node_t * ulist_get_tail(ulist_t * list)
+{
+	if (list->tail == NULL) {
+		return NULL;
+	}
+	return &(list->tail->slots[highest_bit(list->tail->used)]);
+}
+
+/****************************************************************
+ * Summary: Gets the next value.                                *
+ *                                                              *
+ * Parameters: node - A handle to a value.                      *
+ *                                                              *
+ * Returns: A handle to the next value, NULL at the end.        *
+ ****************************************************************/
+ulist_node_t * ulist_get_next_node(ulist_node_t * node)
+{
+	ulist_chunk_t * chunk = CHUNK_OF(node);
+	unsigned int slot = (unsigned int)(node - chunk->slots);
+	unsigned int later;
+
+	/* The common case, the very next slot holds a value. */
+	if (slot + 1 < chunk->filled && (chunk->used & (1u << (slot + 1))) != 0) {
+		return node + 1;
+	}
+
+	/* Slots after this one in the same chunk. */
+	later = (slot + 1 < 32) ? (chunk->used & (~0u << (slot + 1))) : 0;
+	if (later != 0) {
+		return &(chunk->slots[lowest_bit(later)]);
+	}
+
+	/* Chunks in the list are never empty. */
+	chunk = chunk->next;
+	if (chunk == NULL) {
+		return NULL;
+	}
+	return &(chunk->slots[lowest_bit(chunk->used)]);
+}
+
+/****************************************************************
+ * Summary: Gets the previous value.                            *
+ *                                                              *
+ * Parameters: node - A handle to a value.                      *
+ *                                                              *
+ * Returns: A handle to the previous value, NULL at the start.  *
+ ****************************************************************/
+ulist_node_t * ulist_get_prev_node(ulist_node_t * node)
+{
+	ulist_chunk_t * chunk = CHUNK_OF(node);
+	unsigned int slot = (unsigned int)(node - chunk->slots);
+	unsigned int earlier;
+
+	/* Slots before this one in the same chunk. */
+	earlier = chunk->used & ((1u << slot) - 1);
+	if (earlier != 0) {
+		return &(chunk->slots[highest_bit(earlier)]);
+	}
+
+	chunk = chunk->prev;
+	if (chunk == NULL) {
+		return NULL;
+	}
+	return &(chunk->slots[highest_bit(chunk->used)]);
+}
+
+/****************************************************************
+ * Summary: Gets the value of a handle.                         *
+ *                                                              *
+ * Parameters: node - A handle to a value.                      *
+ *                                                              *
+ * Returns: The value.                                          *
+ ****************************************************************/
+int ulist_get_node_value(ulist_node_t * node)
+{
+	return node->val;
+}
+
+/****************************************************************
+ * Summary: Allocates an empty chunk aligned to its size, so    *
+ *          that CHUNK_OF can find it from any of its slots.    *
+ *                                                              *
+ * Parameters: None.                                            *
+ *                                                              *
+ * Returns: The chunk or NULL if failed.                        *
+ ****************************************************************/
+static ulist_chunk_t * chunk_alloc()
+{
+	ulist_chunk_t * chunk;
+
+#if defined(_MSC_VER)
+	chunk = (ulist_chunk_t *)_aligned_malloc(ULIST_CHUNK_SIZE, ULIST_CHUNK_SIZE);
+#else
+	chunk = (ulist_chunk_t *)aligned_alloc(ULIST_CHUNK_SIZE, ULIST_CHUNK_SIZE);
+#endif
+	if (chunk == NULL) {
+		return NULL;
+	}
+
+	chunk->next = NULL;
+	chunk->prev = NULL;
+	chunk->used = 0;
+	chunk->filled = 0;
+
+	return chunk;
+}
+
+static void chunk_free(ulist_chunk_t * chunk)
+{
+#if defined(_MSC_VER)
+	_aligned_free(chunk);
+#else
+	free(chunk);
+#endif
+}
+
+/* The lowest count bits set, count is at most 32. */
+static unsigned int low_bits(unsigned int count)
+{
+	return (count < 32) ? (1u << count) - 1 : ~0u;
+}
+
+/* Index of the lowest set bit, bits must not be 0. */
+static int lowest_bit(unsigned int bits)
+{
+#if defined(__GNUC__)
+	return __builtin_ctz(bits);
+#else
+	int i = 0;
+
+	while ((bits & 1u) == 0) {
+		bits >>= 1;
+		++i;
+	}
+	return i;
+#endif
+}
+
+/* Index of the highest set bit, bits must not be 0. */
+static int highest_bit(unsigned int bits)
+{
+#if defined(__GNUC__)
+	return 31 - __builtin_clz(bits);
+#else
+	int i = -1;
+
+	while (bits != 0) {
+		bits >>= 1;
+		++i;
+	}
+	return i;
+#endif
+}
@@ -0,0 +1,65 @@
+#if !defined(_ULIST_H_)
+#define _ULIST_H_
+
+/* Bytes per chunk, a power of two no larger than 128. */
+#if !defined(ULIST_CHUNK_SIZE)
+#define ULIST_CHUNK_SIZE (64)
+#endif
+
+/* Values that fit in a chunk after its links and bitmaps. */
+#define ULIST_CHUNK_VALUES \
+	((ULIST_CHUNK_SIZE - 2 * sizeof(void *) - 2 * sizeof(unsigned int)) / sizeof(int))
+
+/*
+ * A handle to a value, it stays valid until the value is removed or
+ * the list is compacted.
+ *
+ * Removal never moves values, so a chunk is only freed once all of its
+ * values are removed. At worst a chunk keeps a single value, which then
+ * costs ULIST_CHUNK_SIZE bytes and a chunk visited per value iterated,
+ * twice the memory of list.h. ulist_compact packs the values again.
+ */
+typedef struct ulist_node_rec {
+	int val;
+} ulist_node_t;
+
+typedef struct ulist_chunk_rec {
+	struct ulist_chunk_rec * next;
+	struct ulist_chunk_rec * prev;
+	unsigned int used;		/* bit i is set if slots[i] holds a value */
+	unsigned int filled;	/* slots handed out, values are appended at slots[filled] */
+	ulist_node_t slots[ULIST_CHUNK_VALUES];
+} ulist_chunk_t;
+
+typedef struct ulist_rec {
+	int count;
+	long long sum;
+	struct ulist_chunk_rec * head;
+	struct ulist_chunk_rec * tail;
+} ulist_t;
+
+ulist_t * ulist_create();
+
+void ulist_destroy(ulist_t * list);
+
+ulist_node_t * ulist_add_node(ulist_t * list, int value);
+
+void ulist_remove_node(ulist_t * list, ulist_node_t * node);
+
+void ulist_compact(ulist_t * list);
+
+int ulist_get_count(ulist_t * list);
+
+double ulist_get_average(ulist_t * list);
+
+ulist_node_t * ulist_get_head(ulist_t * list);
+
+ulist_node_t * ulist_get_tail(ulist_t * list);
+
+ulist_node_t * ulist_get_next_node(ulist_node_t * node);
+
+ulist_node_t * ulist_get_prev_node(ulist_node_t * node);
+
+int ulist_get_node_value(ulist_node_t * node);
+
+#endif
@@ -0,0 +1,337 @@
+/****************************************************************
+ * Summary: This library implements a hash multimap from int    *
+ *          values to list nodes, using open addressing with    *
+ *          linear probing. A value held by a single node needs *
+ *          no allocation beyond its slot. Every node keeps its *
+ *          position under its value, so removing it takes O(1) *
+ *          however many nodes share the value.                 *
+ ****************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "list.h"
+#include "vmap.h"
+
+#define VMAP_INITIAL_SIZE (16)
+
+/* Resize when used slots exceed 3/4 of the table. */
+#define VMAP_FULL(map) (4 * ((map)->used + 1) > 3 * (map)->size)
+
+static vmap_entry_t * probe(vmap_t * map, int key, int for_insert);
+static int resize(vmap_t * map, int size);
+static unsigned int hash(vmap_t * map, int key);
+static int shift_for(int size);
+
+/****************************************************************
+ * Summary: Creates an empty map and returns a pointer to it.   *
+ *                                                              *
+ * Parameters: None.                                            *
+ *                                                              *
+ * Returns: A pointer to vmap_t or NULL if failed.              *
+ ****************************************************************/
+vmap_t * vmap_create()
+{
+	vmap_t * new_map = (vmap_t *)malloc(sizeof(vmap_t));
+
+	if (new_map == NULL) {
+		return NULL;
+	}
+
+	new_map->entries = (vmap_entry_t *)calloc(VMAP_INITIAL_SIZE, sizeof(vmap_entry_t));
+	if (new_map->entries == NULL) {
+		free(new_map);
+		return NULL;
+	}
+	new_map->size = VMAP_INITIAL_SIZE;
+	new_map->shift = shift_for(VMAP_INITIAL_SIZE);
+	new_map->used = 0;
+	new_map->keys = 0;
+
+	return new_map;
+}
+
+/****************************************************************
+ * Summary: Destroys a map, freeing memory. The nodes are not   *
+ *          freed.                                              *
+ *                                                              *
+ * Parameters: map - A pointer to the vmap_t to destroy.        *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void vmap_destroy(vmap_t * map)
+{
+	int i;
+
+	for (i = 0 ; i < map->size ; ++i) {
+		if (map->entries[i].capacity != 0) {
+			free(map->entries[i].nodes.many);
+		}
+	}
+	free(map->entries);
+	free(map);
+}
+
+/****************************************************************
+ * Summary: Removes every key from a map, keeping its size.     *
+ *                                                              *
+ * Parameters: map - A pointer to the vmap_t.                   *
+ *                                                              *
+ * Returns: void.                                               *
+ ****************************************************************/
+void vmap_clear(vmap_t * map)
+{
+	int i;
+
+	for (i = 0 ; i < map->size ; ++i) {
+		if (map->entries[i].capacity != 0) {
+			free(map->entries[i].nodes.many);
+		}
+	}
+	memset(map->entries, 0, sizeof(vmap_entry_t) * map->size);
+	map->used = 0;
+	map->keys = 0;
+}
+
+/****************************************************************
+ * Summary: Adds a node under key, after the nodes already      *
+ *          there.                                              *
+ *                                                              *
+ * Parameters: map - A pointer to the vmap_t.                   *
+ *             key - The value of the node.                     *
+ *             node - The node.                                 *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if failed.          *
+ ****************************************************************/
+int vmap_insert(vmap_t * map, int key, struct list_node_rec * node)
+{
+	int capacity;
+	struct list_node_rec ** many;
+	vmap_entry_t * entry;
+
+	if (VMAP_FULL(map) && resize(map, map->size * 2) != 0) {
+		return -1;
+	}
+
+	entry = probe(map, key, 1);
+
+	if (entry->count == 0) { /* a new key */
+		if (!entry->deleted) {
+			++(map->used);
+		}
+		++(map->keys);
+		entry->key = key;
+		entry->count = 1;
+		entry->capacity = 0;
+		entry->deleted = 0;
+		entry->nodes.one = node;
+		node->slot = 0;
+		return 0;
+	}
+
+	/* Move a single node out to an array, or grow the array. */
+	if (entry->capacity == 0) {
+		many = (struct list_node_rec **)malloc(sizeof(struct list_node_rec *) * 4);
+		if (many == NULL) {
+			return -1;
+		}
+		many[0] = entry->nodes.one;
+		entry->nodes.many = many;
+		entry->capacity = 4;
+	} else if (entry->count == entry->capacity) {
+		capacity = entry->capacity * 2;
+		many = (struct list_node_rec **)realloc(entry->nodes.many,
+												sizeof(struct list_node_rec *) * capacity);
+		if (many == NULL) {
+			return -1;
+		}
+		entry->nodes.many = many;
+		entry->capacity = capacity;
+	}
+	entry->nodes.many[entry->count] = node;
+	node->slot = entry->count;
+	++(entry->count);
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Removes a node from under key, moving the last node *
+ *          under key into its place.                           *
+ *                                                              *
+ * Parameters: map - A pointer to the vmap_t.                   *
+ *             key - The value of the node.                     *
+ *             node - The node.                                 *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if not found.       *
+ ****************************************************************/
+int vmap_remove(vmap_t * map, int key, struct list_node_rec * node)
+{
+	int i;
+	vmap_entry_t * entry = probe(map, key, 0);
+
+	if (entry == NULL) {
+		return -1;
+	}
+
+	if (entry->capacity == 0) { /* the only node */
+		if (entry->nodes.one != node) {
+			return -1;
+		}
+		entry->count = 0;
+		entry->deleted = 1;
+		--(map->keys);
+		return 0;
+	}
+
+	/* The node's slot is stale if another map indexed it since, so search then. */
+	i = node->slot;
+	if (i < 0 || i >= entry->count || entry->nodes.many[i] != node) {
+		for (i = 0 ; i < entry->count && entry->nodes.many[i] != node ; ++i) {
+		}
+		if (i == entry->count) {
+			return -1;
+		}
+	}
+	--(entry->count);
+	entry->nodes.many[i] = entry->nodes.many[entry->count];
+	entry->nodes.many[i]->slot = i;
+
+	if (entry->count == 0) {
+		free(entry->nodes.many);
+		entry->capacity = 0;
+		entry->deleted = 1;
+		--(map->keys);
+	}
+
+	return 0;
+}
+
+/****************************************************************
+ * Summary: Finds the entry of a key.                           *
+ *                                                              *
+ * Parameters: map - A pointer to the vmap_t.                   *
+ *             key - The key to find.                           *
+ *                                                              *
+ * Returns: The entry or NULL if key is not in the map.         *
+ ****************************************************************/
+vmap_entry_t * vmap_find(vmap_t * map, int key)
+{
+	return probe(map, key, 0);
+}
+
+/****************************************************************
+ * Summary: Gets the nodes of an entry.                         *
+ *                                                              *
+ * Parameters: entry - The entry.                               *
+ *             out - A pointer to hold the array of nodes.      *
+ *                                                              *
+ * Returns: The amount of nodes.                                *
+ ****************************************************************/
+int vmap_get_nodes(vmap_entry_t * entry, struct list_node_rec *** out)
+{
+	*out = (entry->capacity == 0) ? &(entry->nodes.one) : entry->nodes.many;
+
+	return entry->count;
+}
+
+/****************************************************************
+ * Summary: Finds the slot of a key.                            *
+ *                                                              *
+ * Parameters: map - A pointer to the vmap_t.                   *
+ *             key - The key to find.                           *
+ *             for_insert - Non-0 to return the slot where key  *
+ *                          should be added if it is missing.   *
+ *                                                              *
+ * Returns: The slot, or NULL if key is missing and for_insert  *
+ *          is 0.                                               *
+ ****************************************************************/
+static vmap_entry_t * probe(vmap_t * map, int key, int for_insert)
+{
+	unsigned int mask = (unsigned int)(map->size - 1);
+	unsigned int i = hash(map, key);
+	vmap_entry_t * reuse = NULL;
+	vmap_entry_t * entry;
+
+	for (;;) {
+		entry = &(map->entries[i]);
+		if (entry->count != 0) {
+			if (entry->key == key) {
+				return entry;
+			}
+		} else if (entry->deleted) {
+			if (reuse == NULL) {
+				reuse = entry;
+			}
+		} else { /* an empty slot ends the probe */
+			if (!for_insert) {
+				return NULL;
+			}
+			return (reuse != NULL) ? reuse : entry;
+		}
+		i = (i + 1) & mask;
+	}
+}
+
+/****************************************************************
+ * Summary: Moves every entry to a new table, dropping deleted  *
+ *          slots.                                              *
+ *                                                              *
+ * Parameters: map - A pointer to the vmap_t.                   *
+ *             size - The new amount of slots, a power of two.  *
+ *                                                              *
+ * Returns: 0 if completed successfully, -1 if failed.          *
+ ****************************************************************/
+static int resize(vmap_t * map, int size)
+{
+	int i;
+	unsigned int j;
+	int old_size = map->size;
+	vmap_entry_t * old = map->entries;
+	vmap_entry_t * entries;
+
+	/* Only grow if live keys, not deleted slots, fill the table. */
+	if (4 * (map->keys + 1) <= 2 * map->size) {
+		size = map->size;
+	}
+
+	entries = (vmap_entry_t *)calloc(size, sizeof(vmap_entry_t));
+	if (entries == NULL) {
+		return -1;
+	}
+
+	map->entries = entries;
+	map->size = size;
+	map->shift = shift_for(size);
+	for (i = 0 ; i < old_size ; ++i) {
+		if (old[i].count != 0) {
+			j = hash(map, old[i].key);
+			while (entries[j].count != 0) {
+				j = (j + 1) & (unsigned int)(size - 1);
+			}
+			entries[j] = old[i];
+		}
+	}
+
+	free(old);
+	map->used = map->keys;
+
+	return 0;
+}
+
+/* Fibonacci hashing, the top bits of key times 2^32 / phi. */
+static unsigned int hash(vmap_t * map, int key)
+{
+	return ((unsigned int)key * 2654435769u) >> map->shift;
+}
+
+/* 32 minus the amount of bits needed to index size slots. */
+static int shift_for(int size)
+{
+	int bits = 0;
+
+	while ((1 << bits) < size) {
+		++bits;
+	}
+
+	return 32 - bits;
+}
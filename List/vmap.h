@@ -0,0 +1,38 @@
+#if !defined(_VMAP_H_)
+#define _VMAP_H_
+
+/* All the nodes holding one value, in no particular order. */
+typedef struct vmap_entry_rec {
+	int key;
+	int count;		/* 0 if the slot is free */
+	int capacity;	/* size of nodes.many, 0 while nodes.one is used */
+	int deleted;	/* the slot was freed after being used */
+	union {
+		struct list_node_rec * one;
+		struct list_node_rec ** many;
+	} nodes;
+} vmap_entry_t;
+
+typedef struct vmap_rec {
+	int size;		/* slots, a power of two */
+	int shift;		/* 32 - log2(size), for hashing */
+	int used;		/* slots that are in use or deleted */
+	int keys;		/* distinct keys */
+	struct vmap_entry_rec * entries;
+} vmap_t;
+
+vmap_t * vmap_create();
+
+void vmap_destroy(vmap_t * map);
+
+void vmap_clear(vmap_t * map);
+
+int vmap_insert(vmap_t * map, int key, struct list_node_rec * node);
+
+int vmap_remove(vmap_t * map, int key, struct list_node_rec * node);
+
+vmap_entry_t * vmap_find(vmap_t * map, int key);
+
+int vmap_get_nodes(vmap_entry_t * entry, struct list_node_rec *** out);
+
+#endif
@@ -105,6 +105,9 @@ int queue_pop(queue_t * queue, int *out)
 	/* Save removed node and promote node. */
 	temp = queue->head;
 	queue->head = queue->head->next;
+	if (queue->head == NULL) {/* upon popping the last node. */
+		queue->tail = NULL;
+	}
 
 	/* Save value and free memory. */
 	val = temp->val;